@@ -0,0 +1,26 @@
+#include "bitset.h"
+
+#include "assert_opt.h"
+#include "memory_opt.h"
+
+#include <string.h>
+
+void bitset_set(u64 **bits, size_t index) {
+	assert(bits && "bitset_set: bits == 0");
+	const size_t len = buf_len(*bits), word = index / 64;
+	if (word >= len) {
+		/* doubling, but without buf_fit's 16 word minimum: most sets are a word or two */
+		if (word + 1 > buf_cap(*bits)) buf_reserve(*bits, MAX(word + 1, 2 * buf_cap(*bits)));
+		memset(*bits + len, 0, (word + 1 - len) * sizeof(u64));
+		buf__hdr(*bits)->len = word + 1;
+	}
+	(*bits)[word] |= (u64)1 << (index % 64);
+}
+void bitset_unset(u64 **bits, size_t index) {
+	assert(bits && "bitset_unset: bits == 0");
+	if (index / 64 < buf_len(*bits)) (*bits)[index / 64] &= ~((u64)1 << (index % 64));
+}
+void bitset_free(u64 **bits) {
+	assert(bits && "bitset_free: bits == 0");
+	buf_free(*bits);
+}
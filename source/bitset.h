@@ -0,0 +1,19 @@
+#pragma once
+
+#include "types.h"
+#include "memory_opt.h"
+
+#include <stddef.h>
+
+/* A set of small indices (a country's, a culture's, an interned flag's) as a u64 stretchy buffer of bits, so
+	membership is one bit test instead of a search through a list of them. It grows to fit
+	the highest index set; bits past its end read as 0. Zero-initialise (0 is the empty set). */
+
+internal inline boolean bitset_contains(const u64 *bits, size_t index) {
+	return index / 64 < buf_len(bits) && (bits[index / 64] >> (index % 64)) & 1;
+}
+
+/* the buffer is passed around by its address since setting a bit can grow it */
+void bitset_set(u64 **bits, size_t index);
+void bitset_unset(u64 **bits, size_t index);
+void bitset_free(u64 **bits);
@@ -1,57 +1,54 @@
-/* included in winmain.c */
-
-typedef struct {
-	vec2f pos;
-	vec2 screen_dims;
-	float zoom;
-} camera_t;
-
-camera_t camera = { .pos = { 0 }, .zoom = 0.4f, .screen_dims = { 0 } };
-
-vec2f screen_to_worldf(vec2f v) {
-	v.x -= (float)(camera.screen_dims.x / 2);
-	v.y -= (float)(camera.screen_dims.y / 2);
-	v.x = v.x / camera.zoom;
-	v.y = v.y / camera.zoom;
-	v.x += camera.pos.x;
-	v.y += camera.pos.y;
+#include "camera.h"
+
+#include "assert_opt.h"
+
+vec2f screen_to_worldf(const camera_t *cam, vec2f v) {
+	assert(cam && "screen_to_worldf: cam == 0");
+	v.x -= (float)(cam->screen_dims.x / 2);
+	v.y -= (float)(cam->screen_dims.y / 2);
+	v.x = v.x / cam->zoom;
+	v.y = v.y / cam->zoom;
+	v.x += cam->pos.x;
+	v.y += cam->pos.y;
 	return v;
 }
-vec2 screen_to_world(vec2 v) {
+vec2 screen_to_world(const camera_t *cam, vec2 v) {
 	vec2f vf = { .x = (float)v.x, .y = (float)v.y };
-	vf = screen_to_worldf(vf);
+	vf = screen_to_worldf(cam, vf);
 	v.x = (s32)vf.x;
 	v.y = (s32)vf.y;
 	return v;
 }
-vec2f world_to_screenf(vec2f v) {
-	v.x -= camera.pos.x;
-	v.y -= camera.pos.y;
-	v.x = v.x * camera.zoom;
-	v.y = v.y * camera.zoom;
-	v.x += (float)(camera.screen_dims.x / 2);
-	v.y += (float)(camera.screen_dims.y / 2);
+vec2f world_to_screenf(const camera_t *cam, vec2f v) {
+	assert(cam && "world_to_screenf: cam == 0");
+	v.x -= cam->pos.x;
+	v.y -= cam->pos.y;
+	v.x = v.x * cam->zoom;
+	v.y = v.y * cam->zoom;
+	v.x += (float)(cam->screen_dims.x / 2);
+	v.y += (float)(cam->screen_dims.y / 2);
 	return v;
 }
-vec2 world_to_screen(vec2 v) {
+vec2 world_to_screen(const camera_t *cam, vec2 v) {
 	vec2f vf = { .x = (float)v.x, .y = (float)v.y };
-	vf = world_to_screenf(vf);
+	vf = world_to_screenf(cam, vf);
 	v.x = (s32)vf.x;
 	v.y = (s32)vf.y;
 	return v;
 }
 
-void world_to_screen_quad(vec2 *corner, vec2 *dims) {
+void world_to_screen_quad(const camera_t *cam, vec2 *corner, vec2 *dims) {
+	assert(cam && "world_to_screen_quad: cam == 0");
 	assert(corner && "world_to_screen_quad: corner == 0");
 	assert(dims && "world_to_screen_quad: dims == 0");
 
 	corner->x += dims->x / 2;
 	corner->y += dims->y / 2;
 
-	*corner = world_to_screen(*corner);
+	*corner = world_to_screen(cam, *corner);
 
-	dims->x = (s32)((float)dims->x * camera.zoom);
-	dims->y = (s32)((float)dims->y * camera.zoom);
+	dims->x = (s32)((float)dims->x * cam->zoom);
+	dims->y = (s32)((float)dims->y * cam->zoom);
 
 	corner->x -= dims->x / 2;
 	corner->y -= dims->y / 2;
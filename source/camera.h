@@ -0,0 +1,15 @@
+#pragma once
+
+#include "types.h"
+
+typedef struct camera_s {
+	vec2f pos;
+	vec2 screen_dims;
+	float zoom;
+} camera_t;
+
+vec2f screen_to_worldf(const camera_t *cam, vec2f v);
+vec2 screen_to_world(const camera_t *cam, vec2 v);
+vec2f world_to_screenf(const camera_t *cam, vec2f v);
+vec2 world_to_screen(const camera_t *cam, vec2 v);
+void world_to_screen_quad(const camera_t *cam, vec2 *corner, vec2 *dims);
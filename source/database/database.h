@@ -1,11 +1,17 @@
 #pragma once
 
 #include "string_wrapper.h"
+#include "memory_opt.h"
+#include "bitset.h"
 #include "render.h"
+#include "assert_opt.h"
 
 #include "parser.h"
 
+/* the game or mod files are read from, with a trailing '/'. Set with -DMOD_FOLDER=<path> when configuring */
+#ifndef MOD_FOLDER
 #define MOD_FOLDER "C:/Program Files (x86)/Steam/steamapps/common/Victoria 2/"
+#endif
 
 /* Helper functions */
 u32 to_color(const u8 color[3]);
@@ -48,6 +54,11 @@ u32 to_color(const u8 color[3]);
 	func(reform_group, reform_groups)		\
 	func(unit, units)
 
+/* inline slots of the small_vec lists objects keep of each other: most states have a handful of provinces,
+	most provinces a core or two and most countries few accepted cultures. Longer lists spill to the heap */
+#define DATABASE_REF_LIST_INLINE 8
+#define DATABASE_SMALL_LIST_INLINE 4
+
 #define for_all_database_ref_lists(func)			\
 	func(state, province, provinces)				\
 	func(trade_good_group, trade_good, trade_goods)	\
@@ -56,13 +67,41 @@ u32 to_color(const u8 color[3]);
 	func(issue_group, issue, issues)				\
 	func(reform_group, reform, reforms)
 
+/* stretchy buffers owned by each object of a list, shrunk once loading is done */
+#define for_all_database_object_buffers(func)					\
+	func(province, provinces, flags)							\
+	func(province, provinces, core_bits)						\
+	func(province, provinces, flag_bits)						\
+	func(country, countries, parties)							\
+	func(country, countries, flags)								\
+	func(country, countries, accepted_bits)					\
+	func(country, countries, flag_bits)						\
+	func(culture, cultures, first_names)						\
+	func(culture, cultures, last_names)
+
+/* the same for the small_vec lists */
+#define for_all_database_object_small_vecs(func)				\
+	func(province, provinces, cores)							\
+	func(country, countries, accepted_cultures)				\
+	func(culture_group, culture_groups, cultures)				\
+	func(state, states, provinces)								\
+	func(trade_good_group, trade_good_groups, trade_goods)	\
+	func(religion_group, religion_groups, religions)			\
+	func(ideology_group, ideology_groups, ideologies)			\
+	func(issue_group, issue_groups, issues)					\
+	func(reform_group, reform_groups, reforms)
+
+/* REFS
+	Objects refer to each other by typed refs rather than pointers: the object's index in its list + 1, with 0 for
+	none (the numbering the province columns use). A ref stays valid when its list grows and moves, so lists can be
+	added to while loading whatever points into them, and the database can be copied or moved as it is. 16 bits is
+	plenty, province ids already are. database_<type>(db, ref) resolves one and database_<type>_ref makes one. */
+#define template_list_ref(type, plural) struct type##_ref_t { u16 index; };
+	for_all_database_lists(template_list_ref)
+#undef template_list_ref
+#define DATABASE_LIST_MAX 0xFFFF
+
 /* forward declaration */
-#define template_ref_list_forward_declare(type, list_type, list_name) struct type##_t;
-	for_all_database_ref_lists(template_ref_list_forward_declare)
-#undef template_ref_list_forward_declare
-struct country_t;
-struct province_t;
-struct culture_group_t;
 struct database_t;
 
 enum graphical_culture_t {
@@ -102,15 +141,15 @@ struct national_value_t {
 /* Trade Good */
 struct trade_good_t {
 	string name;
-	struct trade_good_group_t *group;
-	double cost;
+	struct trade_good_group_ref_t group;
+	decimal_t cost;
 	u32 color;
 	boolean available_from_start, overseas_penalty, money, tradeable;
 };
 
 struct trade_good_t trade_good_default(void);
-double *create_trade_good_list(const struct database_t *db);
-void add_to_trade_good_list(struct database_t *db, double *list, const struct trade_good_t *good, double amount, boolean warn_repeated);
+decimal_t *create_trade_good_list(const struct database_t *db);
+void add_to_trade_good_list(struct database_t *db, decimal_t *list, const struct trade_good_t *good, decimal_t amount, boolean warn_repeated);
 
 /* Unit */
 struct unit_t {
@@ -124,29 +163,29 @@ struct unit_t {
 	string move_sound, select_sound;
 	string sprite_override, sprite_mount, sprite_mount_attach_node;
 	boolean transport, floating_flag;
-	double colonial_points;
+	decimal_t colonial_points;
 
-	double priority, max_strength, default_organisation;
-	double maximum_speed, weighted_value;
+	decimal_t priority, max_strength, default_organisation;
+	decimal_t maximum_speed, weighted_value;
 	boolean can_build_overseas;
 
 	int build_time;
-	double *build_cost;
+	decimal_t *build_cost;
 
 	s8 min_port_level, limit_per_port;
-	double supply_consumption_score;
+	decimal_t supply_consumption_score;
 
-	double supply_consumption, *supply_cost;
+	decimal_t supply_consumption, *supply_cost;
 	/* land */
-	double reconnaissance, attack, defence, discipline, support, maneuver, siege;
+	decimal_t reconnaissance, attack, defence, discipline, support, maneuver, siege;
 	/* naval */
-	double hull, gun_power, fire_range, evasion, torpedo_attack;
+	decimal_t hull, gun_power, fire_range, evasion, torpedo_attack;
 };
 
 /* Ideology */
 struct ideology_t {
 	string name;
-	struct ideology_group_t *group;
+	struct ideology_group_ref_t group;
 	boolean uncivilized, can_reduce_militancy;
 	u32 color;
 	date_t date;
@@ -168,13 +207,13 @@ void government_type_init(const struct database_t *db, struct government_type_t
 /* Issue */
 struct issue_t {
 	string name;
-	struct issue_group_t *group;
+	struct issue_group_ref_t group;
 };
 
 /* Reform */
 struct reform_t {
 	string name;
-	struct reform_group_t *group;
+	struct reform_group_ref_t group;
 	enum reform_type_t type;
 };
 
@@ -182,8 +221,8 @@ struct reform_t {
 struct party_t {
 	string name;
 	date_t start, end;
-	struct ideology_t *ideology;
-	struct issue_t **issues;
+	struct ideology_ref_t ideology;
+	struct issue_ref_t *issues;	/* one per issue group */
 };
 
 void party_issues_init(const struct database_t *db, struct party_t *party);
@@ -192,30 +231,30 @@ void party_free(struct party_t *party);
 /* Culture */
 struct culture_t {
 	string name;
-	struct culture_group_t *group;
+	struct culture_group_ref_t group;
 	u32 color;
 	u8 radicalism;
-	struct country_t *primary;
+	struct country_ref_t primary;
 	string *first_names, *last_names;
 };
 
 /* Culture Group */
 struct culture_group_t {
 	string name;
-	struct culture_t **cultures;
+	small_vec(struct culture_ref_t, DATABASE_REF_LIST_INLINE) cultures;
 
 	enum leader_t leader;
 	enum graphical_culture_t unit;
-	struct country_t *cultural_union;
+	struct country_ref_t cultural_union;
 };
 
-void culture_group_add_culture(struct culture_group_t *culture_group, struct culture_t *culture);
-boolean culture_group_contains_culture(const struct culture_group_t *culture_group, const struct culture_t *culture);
+void culture_group_add_culture(struct culture_group_t *culture_group, struct culture_ref_t culture);
+boolean culture_group_contains_culture(const struct culture_group_t *culture_group, struct culture_ref_t culture);
 
 /* Religion */
 struct religion_t {
 	string name;
-	struct religion_group_t *group;
+	struct religion_group_ref_t group;
 	u8 icon;
 	u32 color;
 	boolean pagan;
@@ -227,23 +266,26 @@ struct country_t {
 	string defines_location, oob_location;
 	u32 color;
 	enum graphical_culture_t graphical_culture;
-	struct province_t *capital;
-	struct culture_t *primary_culture;
-	struct culture_t **accepted_cultures;
-	struct religion_t *religion;
-	struct government_type_t *government;
-	double plurality;
-	struct national_value_t *nv;
-	double literacy, non_state_culture_literacy;
+	struct province_ref_t capital;
+	struct culture_ref_t primary_culture;
+	small_vec(struct culture_ref_t, DATABASE_SMALL_LIST_INLINE) accepted_cultures;
+	struct religion_ref_t religion;
+	struct government_type_ref_t government;
+	decimal_t plurality;
+	struct national_value_ref_t nv;
+	decimal_t literacy, non_state_culture_literacy;
 	boolean civilized, is_releasable_vassal;
-	double prestige;
-	struct party_t *ruling_party;
+	decimal_t prestige;
+	u16 ruling_party;	/* index in parties + 1, 0 for none */
 	struct party_t *parties;
-	double *upper_house;
-	struct reform_t **reforms;
-	double consciousness, nonstate_consciousness;
+	decimal_t *upper_house;
+	struct reform_ref_t *reforms;	/* one per reform group */
+	decimal_t consciousness, nonstate_consciousness;
 	date_t last_election;
 	string *flags;
+	/* bitsets for membership tests, kept alongside the lists above */
+	u64 *accepted_bits;			/* by database_culture_index */
+	u64 *flag_bits;				/* by database_flag_id */
 
 	boolean history_defined;
 };
@@ -252,41 +294,63 @@ void country_upper_house_init(const struct database_t *db, struct country_t *cou
 void country_reforms_init(const struct database_t *db, struct country_t *country);
 void country_add_party(struct country_t *country, const struct party_t *party);
 struct party_t *country_get_party(struct country_t *country, const string *party);
-void country_add_accepted_culture(struct country_t *country, struct culture_t *culture);
-boolean country_has_accepted(const struct country_t *country, const struct culture_t *culture);
-boolean country_has_flag(const struct country_t *country, const string *flag);
+struct party_t *country_ruling_party(struct country_t *country);
+void country_add_accepted_culture(struct country_t *country, struct culture_ref_t culture);
+boolean country_has_accepted(const struct country_t *country, struct culture_ref_t culture);
+/* takes the flag's text, returns false (leaving flag alone) if the country already has it */
+boolean country_add_flag(struct database_t *db, struct country_t *country, string *flag);
+boolean country_has_flag(const struct database_t *db, const struct country_t *country, const string *flag);
 
 /* Province */
 struct province_t {
 	u16 id;
 	u32 color;
-	struct state_t *state;
-	struct country_t *owner, *controller;
-	struct country_t **cores;
-	struct trade_good_t *rgo;
+	struct state_ref_t state;
+	struct country_ref_t owner, controller;
+	small_vec(struct country_ref_t, DATABASE_SMALL_LIST_INLINE) cores;
+	struct trade_good_ref_t rgo;
 	u8 life_rating, railroad, naval_base, fort, colonial;
 	boolean sea_start;
 	string *flags;
+	/* bitsets for membership tests, kept alongside the lists above */
+	u64 *core_bits;		/* by database_country_index */
+	u64 *flag_bits;		/* by database_flag_id */
 
 	boolean history_defined;
 };
 
-boolean province_has_core(const struct province_t *province, const struct country_t *country);
-void province_add_core(struct province_t *province, struct country_t *country);
-boolean province_has_flag(const struct province_t *province, const string *flag);
+boolean province_has_core(const struct province_t *province, struct country_ref_t country);
+void province_add_core(struct database_t *db, struct province_t *province, struct country_ref_t country);
+/* takes the flag's text, returns false (leaving flag alone) if the province already has it */
+boolean province_add_flag(struct database_t *db, struct province_t *province, string *flag);
+boolean province_has_flag(const struct database_t *db, const struct province_t *province, const string *flag);
 
 #define template_ref_list_declare(type, list_type, list_name) struct type##_t {							\
 																string name;							\
-																struct list_type##_t **list_name; };	\
-							void type##_add_##list_type(struct type##_t *type, struct list_type##_t *list_type);
+																small_vec(struct list_type##_ref_t, DATABASE_REF_LIST_INLINE) list_name; };	\
+							void type##_add_##list_type(struct type##_t *type, struct list_type##_ref_t list_type);
 	for_all_database_ref_lists(template_ref_list_declare)
 #undef template_ref_list_declare
 
-#define template_ref_list_contains_dec(type, list_type, list_name) boolean type##_contains_##list_type(const struct type##_t *type, const struct list_type##_t *list_type);
+#define template_ref_list_contains_dec(type, list_type, list_name) boolean type##_contains_##list_type(const struct type##_t *type, struct list_type##_ref_t list_type);
 	for_all_database_ref_lists(template_ref_list_contains_dec)
 #undef template_ref_list_contains_dec
 
-boolean state_contains_province(const struct state_t *state, const struct province_t *prov);
+
+/* Province columns: the fields map modes and statistics read, one contiguous array per field indexed by
+	province id - 1, so a pass over every province touches only the bytes it uses and can be vectorised. A
+	mirror of db->provinces (which stays the place to read a single province from): database_build_province_columns
+	fills it in at the end of loading and province_columns_update keeps one province in step after it changes.
+	Objects are stored as their refs' indices. */
+struct province_columns_t {
+	size_t count;
+	u16 *owner, *controller;	/* countries */
+	u16 *rgo;					/* trade_goods */
+	u16 *state;					/* states */
+	u32 *color;
+	u8 *life_rating, *railroad, *naval_base, *fort, *colonial;
+	boolean *sea_start;
+};
 
 /* Database */
 struct database_t {
@@ -297,10 +361,18 @@ struct database_t {
 
 	struct map_t {
 		s32 width, height, size;
-		RenderBuffer province_id, province_col, province_owner;
+		RenderBuffer province_id, province_owner;
 	} map;
 
 	size_t land_province_count, sea_province_count;
+	struct province_columns_t province_columns;
+
+	/* every province and country flag name, interned: a flag's id is its index */
+	string *flag_names;
+	/* their hash index, open addressing: id + 1 of the name in each slot, 0 for none. flag_slot_count is a
+		power of two, kept at least twice the number of names */
+	u32 *flag_slots;
+	size_t flag_slot_count;
 
 	struct load_status_t {
 		struct common_loaded_t {
@@ -330,9 +402,13 @@ struct database_t {
 
 int database_load_all(struct database_t *db);
 void database_free_all(struct database_t *db);
+/* gives back the spare capacity of every list and of the for_all_database_object_buffers buffers and small_vecs */
+void database_shrink_all(struct database_t *db);
+/* for every list and object buffer: elements, capacity and the bytes allocated but not in use */
+void database_memory_report(FILE *const stream, const struct database_t *db);
 
-/* these add exact copies, without making new pointers */
-#define template_list_add_dec(type, plural) void database_add_##type(struct database_t *db, const struct type##_t *type);
+/* these add exact copies, without making new pointers, and return the copy's ref */
+#define template_list_add_dec(type, plural) struct type##_ref_t database_add_##type(struct database_t *db, const struct type##_t *type);
 	for_all_database_lists(template_list_add_dec)
 #undef template_add_dec
 #define template_list_free_dec(type, plural) void type##_free(struct type##_t *type);
@@ -342,8 +418,27 @@ void database_free_all(struct database_t *db);
 		for_all_database_lists(template_list_index_dec)
 #undef template_list_index_dec
 
+/* the object a ref is for, 0 for none; the ref of an object in its list, none for 0; and the ref the next
+	database_add_<type> will return */
+#define template_list_ref_helpers(type, plural)																	\
+	internal inline struct type##_t *database_##type(const struct database_t *db, struct type##_ref_t ref) {		\
+		assert(ref.index <= buf_len(db->plural) && "database_" #type ": ref out of range");						\
+		return ref.index ? &db->plural[ref.index - 1] : 0; }														\
+	internal inline struct type##_ref_t database_##type##_ref(const struct database_t *db, const struct type##_t *type) {	\
+		struct type##_ref_t ref = { type ? (u16)(type - db->plural + 1) : 0 };										\
+		return ref; }																								\
+	internal inline struct type##_ref_t database_next_##type##_ref(const struct database_t *db) {					\
+		struct type##_ref_t ref = { (u16)(buf_len(db->plural) + 1) };												\
+		return ref; }
+	for_all_database_lists(template_list_ref_helpers)
+#undef template_list_ref_helpers
+
 /* Getters */
 struct country_t *database_get_country(struct database_t *db, const struct tag_t *tag);
+/* a flag's id, -1 if no province or country has ever had it */
+int database_flag_id(const struct database_t *db, const string *flag);
+/* the flag's id, giving it one if it doesn't have one yet */
+int database_intern_flag(struct database_t *db, const string *flag);
 struct province_t *database_get_province(struct database_t *db, int id);
 struct province_t *database_get_province_col(struct database_t *db, u32 color);
 
@@ -351,5 +446,29 @@ struct province_t *database_get_province_col(struct database_t *db, u32 color);
 	for_all_database_lists_named(template_list_get_by_name_dec)
 #undef template_list_get_by_name_dec
 
-typedef u32(*map_mode_t)(struct province_t *prov);
+void database_build_province_columns(struct database_t *db);
+void province_columns_update(struct database_t *db, const struct province_t *prov);
+void province_columns_free(struct province_columns_t *columns);
+
+/* MAP MODES
+	A map mode colours each province: either one province at a time through a callback, or all at once as a
+	palette (one colour per province id, [0] for pixels that aren't a province) built from the province columns,
+	which the map is then drawn from with a lookup per pixel. */
+typedef u32(*map_mode_t)(const struct database_t *db, const struct province_t *prov);
 void database_apply_mapmode(struct database_t *db, RenderBuffer *rb, map_mode_t map_mode);
+u32 map_mode_owner(const struct database_t *db, const struct province_t *prov);
+u32 map_mode_rgo(const struct database_t *db, const struct province_t *prov);
+u32 map_mode_state(const struct database_t *db, const struct province_t *prov);
+
+/* palette has database_palette_size entries */
+typedef void(*map_palette_t)(const struct database_t *db, u32 *palette);
+internal inline size_t database_palette_size(const struct database_t *db) {
+	return db->province_columns.count + 1;
+}
+void database_apply_palette(struct database_t *db, RenderBuffer *rb, map_palette_t map_palette);
+/* the colour database_apply_palette gives the pixels of province id, for when the map drawn isn't at hand */
+u32 database_palette_colour(const struct database_t *db, map_palette_t map_palette, u32 id);
+/* the same colours as the map_mode_ callbacks */
+void map_palette_owner(const struct database_t *db, u32 *palette);
+void map_palette_rgo(const struct database_t *db, u32 *palette);
+void map_palette_state(const struct database_t *db, u32 *palette);
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "types.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/* KEYWORDS
+	Every fixed set of strings the readers compare against, as X-macro lists. tools/keyword_gen.c turns each
+	set into a perfect hash table at build time (keywords.h, in the build folder), <set>_keywords, so a lookup
+	is one hash, one table read and one string compare however many keys the set has. Sets marked
+	KEYWORD_ENUM also get an enum <set>_key_t of <SET>_KEY_<key> (e.g. UNIT_KEY_icon) for the readers to switch
+	on, the others index an existing enum in database.h, so their order has to match it. */
+
+#define KEYWORD_STRING(key) #key,
+
+/* enums from database.h */
+#define FLAG_TYPE_KEYWORDS(X) X(communist) X(republic) X(fascist) X(monarchy)
+#define GRAPHICAL_CULTURE_KEYWORDS(X) X(Generic) X(BritishGC) X(EuropeanGC) X(MiddleEasternGC) \
+	X(ChineseGC) X(IndianGC) X(AfricanGC) X(UsGC) X(RussianGC) X(FrenchGC) X(PrussianGC) X(ItalianGC) X(AustriaHungaryGC) X(SwedishGC) \
+	X(SpanishGC) X(OttomanGC) X(MoroccoGC) X(ZuluGC) X(AsianGC) X(SouthAmericanGC) X(ConfederateGC) X(JapaneseGC)
+#define LEADER_KEYWORDS(X) X(european) X(russian) X(arab) X(asian) X(indian) X(nativeamerican) X(southamerican) X(african) X(polar_bear)
+#define REFORM_TYPE_KEYWORDS(X) X(political_reforms) X(social_reforms) X(economic_reforms) X(military_reforms)
+#define UNIT_TERRAIN_TYPE_KEYWORDS(X) X(land) X(naval)
+#define UNIT_TYPE_KEYWORDS(X) X(infantry) X(cavalry) X(support) X(special) X(transport) X(light_ship) X(big_ship)
+
+/* reader keys */
+#define TRADE_GOOD_KEYWORDS(X) X(cost) X(color) X(available_from_start) X(tradeable) X(money) X(overseas_penalty)
+#define PROVINCE_HISTORY_KEYWORDS(X) X(owner) X(controller) X(add_core) X(trade_goods) X(life_rating) X(railroad) \
+	X(naval_base) X(fort) X(colonial) X(colony) X(set_province_flag) X(state_building) X(party_loyalty) X(is_slave) X(terrain)
+#define COUNTRY_HISTORY_KEYWORDS(X) X(capital) X(primary_culture) X(culture) X(religion) X(government) X(plurality) \
+	X(nationalvalue) X(literacy) X(non_state_culture_literacy) X(civilized) X(is_releasable_vassal) X(prestige) \
+	X(set_country_flag) X(ruling_party) X(upper_house) X(consciousness) X(nonstate_consciousness) X(last_election) X(oob)
+#define COUNTRY_DEFINE_KEYWORDS(X) X(color) X(graphical_culture) X(party) X(unit_names)
+#define PARTY_KEYWORDS(X) X(name) X(start_date) X(end_date) X(ideology) X(social_policy)
+#define UNIT_KEYWORDS(X) X(icon) X(naval_icon) X(type) X(unit_type) X(sprite) X(move_sound) X(select_sound) \
+	X(sprite_override) X(sprite_mount) X(sprite_mount_attach_node) X(capital) X(sail) X(active) X(transport) \
+	X(floating_flag) X(can_build_overseas) X(colonial_points) X(priority) X(max_strength) X(default_organisation) \
+	X(maximum_speed) X(weighted_value) X(build_time) X(build_cost) X(min_port_level) X(limit_per_port) \
+	X(supply_consumption_score) X(supply_consumption) X(supply_cost) X(reconnaissance) X(attack) X(defence) \
+	X(discipline) X(support) X(maneuver) X(siege) X(hull) X(gun_power) X(fire_range) X(evasion) X(torpedo_attack)
+
+/* X(set name, key list, KEYWORD_ENUM or KEYWORD_NO_ENUM) */
+#define KEYWORD_NO_ENUM 0
+#define KEYWORD_ENUM 1
+#define for_all_keyword_sets(X) \
+	X(flag_type, FLAG_TYPE_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(graphical_culture, GRAPHICAL_CULTURE_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(leader, LEADER_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(reform_type, REFORM_TYPE_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(unit_terrain_type, UNIT_TERRAIN_TYPE_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(unit_type, UNIT_TYPE_KEYWORDS, KEYWORD_NO_ENUM) \
+	X(trade_good, TRADE_GOOD_KEYWORDS, KEYWORD_ENUM) \
+	X(province_history, PROVINCE_HISTORY_KEYWORDS, KEYWORD_ENUM) \
+	X(country_history, COUNTRY_HISTORY_KEYWORDS, KEYWORD_ENUM) \
+	X(country_define, COUNTRY_DEFINE_KEYWORDS, KEYWORD_ENUM) \
+	X(party, PARTY_KEYWORDS, KEYWORD_ENUM) \
+	X(unit, UNIT_KEYWORDS, KEYWORD_ENUM)
+
+/* the strings of every set, <set>_strings[] */
+#define template_keyword_strings(set, keys, has_enum) internal const char *set##_strings[] = { keys(KEYWORD_STRING) };
+	for_all_keyword_sets(template_keyword_strings)
+#undef template_keyword_strings
+
+typedef struct keyword_set_s {
+	const char **strings;
+	u32 count;
+	u32 seed, mask;
+	const u8 *slots;	/* mask + 1 of them, index + 1 of the string hashing there, 0 if none does */
+} keyword_set_t;
+
+/* FNV-1a, with the seed the generator found folded in and the high bits mixed down into the masked ones */
+internal inline u32 keyword_hash(const char *text, size_t length, u32 seed) {
+	u32 hash = 2166136261u ^ seed;
+	for (size_t i = 0; i < length; ++i) {
+		hash ^= (u8)text[i];
+		hash *= 16777619u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+/* the index of text[0, length) in set, or -1 if it isn't one of its strings */
+internal inline int keyword_lookup(const keyword_set_t *set, const char *text, size_t length) {
+	const u32 slot = set->slots[keyword_hash(text, length, set->seed) & set->mask];
+	if (!slot) return -1;
+	const char *key = set->strings[slot - 1];
+	return strncmp(key, text, length) == 0 && key[length] == '\0' ? (int)slot - 1 : -1;
+}
@@ -1,16 +1,21 @@
 #include "database.h"
+#include "database_keys.h"
 
 #include "assert_opt.h"
 #include "memory_opt.h"
 
 #include <stdio.h>
+#include <string.h>
 
 /* LIST ADDERS */
 /* adds an exact copy, without making new pointers */
-#define template_list_add(type,plural) void database_add_##type(struct database_t *db, const struct type##_t *type) {	\
+#define template_list_add(type,plural) struct type##_ref_t database_add_##type(struct database_t *db, const struct type##_t *type) {	\
 									assert(db && "database_add_" #type ": db == 0");					\
 									assert(type && "database_add_" #type ": " #type " == 0");			\
-									buf_push(db->plural,*type); }
+									assert(buf_len(db->plural) < DATABASE_LIST_MAX && "database_add_" #type ": too many for a ref");	\
+									const struct type##_ref_t ref = database_next_##type##_ref(db);		\
+									buf_push(db->plural,*type);											\
+									return ref; }
 	for_all_database_lists(template_list_add)
 #undef template_add
 
@@ -23,6 +28,38 @@ struct country_t *database_get_country(struct database_t* db, const struct tag_t
 			return &db->countries[i];
 	return 0;
 }
+/* the slot flag is in, or the empty one it would go in */
+internal size_t database_flag_slot(const struct database_t *db, const string *flag) {
+	const size_t mask = db->flag_slot_count - 1;
+	size_t slot = keyword_hash(string_text(flag), string_length(flag), 0) & mask;
+	while (db->flag_slots[slot] && !string_equal(&db->flag_names[db->flag_slots[slot] - 1], flag))
+		slot = (slot + 1) & mask;
+	return slot;
+}
+int database_flag_id(const struct database_t *db, const string *flag) {
+	assert(db && "database_flag_id: db == 0");
+	assert(flag && "database_flag_id: flag == 0");
+	if (db->flag_slot_count == 0) return -1;
+	return (int)db->flag_slots[database_flag_slot(db, flag)] - 1;
+}
+int database_intern_flag(struct database_t *db, const string *flag) {
+	assert(db && "database_intern_flag: db == 0");
+	assert(flag && "database_intern_flag: flag == 0");
+	const int id = database_flag_id(db, flag);
+	if (id >= 0) return id;
+	if (2 * (buf_len(db->flag_names) + 1) > db->flag_slot_count) {
+		/* rehash every name into a table twice the size */
+		if (db->flag_slots) free_s(db->flag_slots);
+		db->flag_slot_count = db->flag_slot_count ? 2 * db->flag_slot_count : 64;
+		db->flag_slots = calloc_s(db->flag_slot_count * sizeof(u32));
+		for_buf(i, db->flag_names) db->flag_slots[database_flag_slot(db, &db->flag_names[i])] = (u32)i + 1;
+	}
+	string name = { 0 };
+	string_set(&name, flag);
+	buf_push(db->flag_names, name);
+	db->flag_slots[database_flag_slot(db, flag)] = (u32)buf_len(db->flag_names);
+	return (int)buf_len(db->flag_names) - 1;
+}
 struct province_t *database_get_province(struct database_t *db, int id) {
 	assert(db && "database_get_province: db == 0");
 	if (id <= 0 || id > buf_len(db->provinces)) return 0;
@@ -70,11 +107,204 @@ void database_free_all(struct database_t *db) {
 		for_all_database_lists(template_list_free)
 #undef template_list_free
 
-	RB_free_pixels(&db->map.province_col);
+	for_buf(i, db->flag_names)
+		string_clear(&db->flag_names[i]);
+	buf_free(db->flag_names);
+	if (db->flag_slots) free_s(db->flag_slots);
+	db->flag_slots = 0;
+	db->flag_slot_count = 0;
+	province_columns_free(&db->province_columns);
+
 	RB_free_pixels(&db->map.province_id);
 	RB_free_pixels(&db->map.province_owner);
 }
 
+void database_shrink_all(struct database_t *db) {
+	assert(db && "database_shrink_all: db == 0");
+#define template_list_shrink(type, plural) buf_shrink(db->plural);
+	for_all_database_lists(template_list_shrink)
+#undef template_list_shrink
+#define template_object_buffer_shrink(type, plural, buffer) for_buf(i, db->plural) buf_shrink(db->plural[i].buffer);
+	for_all_database_object_buffers(template_object_buffer_shrink)
+#undef template_object_buffer_shrink
+#define template_object_small_vec_shrink(type, plural, vec) for_buf(i, db->plural) svec_shrink(db->plural[i].vec);
+	for_all_database_object_small_vecs(template_object_small_vec_shrink)
+#undef template_object_small_vec_shrink
+}
+
+void database_memory_report(FILE *const stream, const struct database_t *db) {
+	assert(stream && "database_memory_report: stream == 0");
+	assert(db && "database_memory_report: db == 0");
+	size_t total_used = 0, total_wasted = 0;
+	fprintf(stream, "[database_memory_report]       count   capacity   bytes used  bytes spare  list\n");
+#define template_list_report(type, plural) if (buf_cap(db->plural)) {												\
+		fprintf(stream, "                         %10zu %10zu %12zu %12zu  " #plural "\n",							\
+			buf_len(db->plural), buf_cap(db->plural), buf_sizeof(db->plural), buf_waste(db->plural));				\
+		total_used += buf_sizeof(db->plural); total_wasted += buf_waste(db->plural); }
+	for_all_database_lists(template_list_report)
+#undef template_list_report
+#define template_object_buffer_report(type, plural, buffer) {														\
+		size_t count = 0, capacity = 0, used = 0, wasted = 0;														\
+		for_buf(i, db->plural) {																					\
+			count += buf_len(db->plural[i].buffer); capacity += buf_cap(db->plural[i].buffer);						\
+			used += buf_sizeof(db->plural[i].buffer); wasted += buf_waste(db->plural[i].buffer); }					\
+		if (capacity) fprintf(stream, "                         %10zu %10zu %12zu %12zu  " #plural "[]." #buffer "\n",	\
+			count, capacity, used, wasted);																			\
+		total_used += used; total_wasted += wasted; }
+	for_all_database_object_buffers(template_object_buffer_report)
+#undef template_object_buffer_report
+#define template_object_small_vec_report(type, plural, vec) {														\
+		size_t count = 0, capacity = 0, used = 0, wasted = 0;														\
+		for_buf(i, db->plural) {																					\
+			count += svec_len(db->plural[i].vec); capacity += svec_cap(db->plural[i].vec);							\
+			used += svec_sizeof(db->plural[i].vec); wasted += svec_waste(db->plural[i].vec); }						\
+		if (capacity) fprintf(stream, "                         %10zu %10zu %12zu %12zu  " #plural "[]." #vec "\n",	\
+			count, capacity, used, wasted);																			\
+		total_used += used; total_wasted += wasted; }
+	for_all_database_object_small_vecs(template_object_small_vec_report)
+#undef template_object_small_vec_report
+	fprintf(stream, "                         %10s %10s %12zu %12zu  total\n", "", "", total_used, total_wasted);
+}
+
+/* PROVINCE COLUMNS */
+void province_columns_free(struct province_columns_t *columns) {
+	assert(columns && "province_columns_free: columns == 0");
+	if (columns->color) free_s(columns->color);
+	memset(columns, 0, sizeof(struct province_columns_t));
+}
+void database_build_province_columns(struct database_t *db) {
+	assert(db && "database_build_province_columns: db == 0");
+	struct province_columns_t *columns = &db->province_columns;
+	province_columns_free(columns);
+	const size_t count = buf_len(db->provinces);
+	if (count == 0) return;
+	/* one block, the widest columns first so every one is aligned */
+	const size_t u16_columns = 4, u8_columns = 6;
+	u8 *block = calloc_s(count * (sizeof(u32) + u16_columns * sizeof(u16) + u8_columns));
+	assert(block && "database_build_province_columns: calloc failed");
+	columns->count = count;
+	columns->color = (u32 *)block;
+	columns->owner = (u16 *)(columns->color + count);
+	columns->controller = columns->owner + count;
+	columns->rgo = columns->controller + count;
+	columns->state = columns->rgo + count;
+	columns->life_rating = (u8 *)(columns->state + count);
+	columns->railroad = columns->life_rating + count;
+	columns->naval_base = columns->railroad + count;
+	columns->fort = columns->naval_base + count;
+	columns->colonial = columns->fort + count;
+	columns->sea_start = columns->colonial + count;
+	for_buf(i, db->provinces) province_columns_update(db, &db->provinces[i]);
+}
+void province_columns_update(struct database_t *db, const struct province_t *prov) {
+	assert(db && "province_columns_update: db == 0");
+	assert(prov && "province_columns_update: prov == 0");
+	struct province_columns_t *columns = &db->province_columns;
+	const size_t i = prov->id - 1;
+	if (i >= columns->count) return;
+	columns->owner[i] = prov->owner.index;
+	columns->controller[i] = prov->controller.index;
+	columns->rgo[i] = prov->rgo.index;
+	columns->state[i] = prov->state.index;
+	columns->color[i] = prov->color;
+	columns->life_rating[i] = prov->life_rating;
+	columns->railroad[i] = prov->railroad;
+	columns->naval_base[i] = prov->naval_base;
+	columns->fort[i] = prov->fort;
+	columns->colonial[i] = prov->colonial;
+	columns->sea_start[i] = prov->sea_start;
+}
+
+/* MAP MODES */
+u32 map_mode_owner(const struct database_t *db, const struct province_t *prov) {
+	if (prov->owner.index) return database_country(db, prov->owner)->color;
+	if (!prov->sea_start) return 0xAAAAAA;
+	return prov->color;
+}
+u32 map_mode_rgo(const struct database_t *db, const struct province_t *prov) {
+	if (prov->rgo.index) return database_trade_good(db, prov->rgo)->color;
+	if (!prov->sea_start) return 0xFF0000;
+	return prov->color;
+}
+u32 map_mode_state(const struct database_t *db, const struct province_t *prov) {
+	if (prov->state.index) return database_province(db, svec_at(database_state(db, prov->state)->provinces, 0))->color;
+	if (!prov->sea_start) return 0xFF00FF;
+	return prov->color;
+}
+
+/* the same for every palette: lookup[0] is unused, the column holds lookup indices with 0 for none, and provinces
+	with none get no_value, or their own colour if they're sea */
+internal void map_palette_from_column(const struct database_t *db, u32 *palette, const u16 *column, const u32 *lookup, u32 no_value) {
+	const struct province_columns_t *columns = &db->province_columns;
+	palette[0] = 0xFF0000;
+	u32 *province_palette = palette + 1;
+	for (size_t i = 0; i < columns->count; ++i) {
+		const u32 none = columns->sea_start[i] ? columns->color[i] : no_value;
+		province_palette[i] = column[i] ? lookup[column[i]] : none;
+	}
+}
+void map_palette_owner(const struct database_t *db, u32 *palette) {
+	assert(db && "map_palette_owner: db == 0");
+	assert(palette && "map_palette_owner: palette == 0");
+	const scratch_mark_t mark = scratch_mark();
+	u32 *lookup = scratch_alloc((buf_len(db->countries) + 1) * sizeof(u32));
+	for_buf(i, db->countries) lookup[i + 1] = db->countries[i].color;
+	map_palette_from_column(db, palette, db->province_columns.owner, lookup, 0xAAAAAA);
+	scratch_reset(mark);
+}
+void map_palette_rgo(const struct database_t *db, u32 *palette) {
+	assert(db && "map_palette_rgo: db == 0");
+	assert(palette && "map_palette_rgo: palette == 0");
+	const scratch_mark_t mark = scratch_mark();
+	u32 *lookup = scratch_alloc((buf_len(db->trade_goods) + 1) * sizeof(u32));
+	for_buf(i, db->trade_goods) lookup[i + 1] = db->trade_goods[i].color;
+	map_palette_from_column(db, palette, db->province_columns.rgo, lookup, 0xFF0000);
+	scratch_reset(mark);
+}
+void map_palette_state(const struct database_t *db, u32 *palette) {
+	assert(db && "map_palette_state: db == 0");
+	assert(palette && "map_palette_state: palette == 0");
+	const scratch_mark_t mark = scratch_mark();
+	u32 *lookup = scratch_alloc((buf_len(db->states) + 1) * sizeof(u32));
+	for_buf(i, db->states) lookup[i + 1] = svec_len(db->states[i].provinces) ? database_province(db, svec_at(db->states[i].provinces, 0))->color : 0xFF00FF;
+	map_palette_from_column(db, palette, db->province_columns.state, lookup, 0xFF00FF);
+	scratch_reset(mark);
+}
+
+void database_apply_palette(struct database_t *db, RenderBuffer *rb, map_palette_t map_palette) {
+	assert(db && "database_apply_palette: db == 0");
+	assert(rb && "database_apply_palette: rb == 0");
+	assert(map_palette && "database_apply_palette: map_palette == 0");
+	assert(db->map.size && db->map.province_id.pixels && "database_apply_palette: province id map not loaded");
+	RB_resize(rb, db->map.width, db->map.height);
+	assert(rb->pixels && "database_apply_palette: failed to allocate rb");
+	/* a load that stopped part way never built them */
+	if (db->province_columns.count != buf_len(db->provinces)) database_build_province_columns(db);
+	const size_t palette_size = database_palette_size(db);
+	const scratch_mark_t mark = scratch_mark();
+	u32 *palette = scratch_alloc(palette_size * sizeof(u32));
+	map_palette(db, palette);
+	const u32 *ids = db->map.province_id.pixels;
+	/* ids past the provinces (not in definition.csv) get palette[0], like database_get_province failing */
+	for (int i = 0; i < rb->size; ++i) {
+		const u32 id = ids[i];
+		rb->pixels[i] = palette[id < palette_size ? id : 0];
+	}
+	scratch_reset(mark);
+}
+
+u32 database_palette_colour(const struct database_t *db, map_palette_t map_palette, u32 id) {
+	assert(db && "database_palette_colour: db == 0");
+	assert(map_palette && "database_palette_colour: map_palette == 0");
+	const size_t palette_size = database_palette_size(db);
+	const scratch_mark_t mark = scratch_mark();
+	u32 *palette = scratch_alloc(palette_size * sizeof(u32));
+	map_palette(db, palette);
+	const u32 colour = palette[id < palette_size ? id : 0];
+	scratch_reset(mark);
+	return colour;
+}
+
 void database_apply_mapmode(struct database_t *db, RenderBuffer *rb, map_mode_t map_mode) {
 	assert(db && "database_apply_mapmode: db == 0");
 	assert(rb && "database_apply_mapmode: rb == 0");
@@ -91,7 +321,7 @@ void database_apply_mapmode(struct database_t *db, RenderBuffer *rb, map_mode_t
 			rb->pixels[i] = rb->pixels[i - 1];
 		else {
 			struct province_t *prov = database_get_province(db, id);
-			if (prov) rb->pixels[i] = map_mode(prov);
+			if (prov) rb->pixels[i] = map_mode(db, prov);
 			else rb->pixels[i] = 0xFF0000;
 		}
 	}
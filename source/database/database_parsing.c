@@ -1,17 +1,17 @@
 #include "database_parsing.h"
+#include "directory.h"
 
 #include "assert_opt.h"
 #include "memory_opt.h"
 
 #include <string.h>
-#include <windows.h>
 
 int database_load_all(struct database_t *db) {
 	assert(db && "database_load_all: db == 0");
 	/* LOAD ORDER:
 		- COMMON: trade goods, ideologies, issues, national values, religions, government_types, countries, cultures, country defines
 		- MAP: province definitions, default.map (sea starts), states, provinces
-		database objects can contain pointers to other database objects ONLY IF they are loaded after the object */
+		database objects can refer to other database objects ONLY IF they are loaded after the object */
 	int err;
 	/* ==================== COMMON ==================== */
 	/* load trade goods */
@@ -55,6 +55,8 @@ int database_load_all(struct database_t *db) {
 	/* load province histories */
 	err = read_province_histories(db, MOD_FOLDER "history/provinces"); if_err_ret else db->load_status.history.provinces = true;
 
+	database_build_province_columns(db);
+	database_shrink_all(db);
 	return 0;
 }
 
@@ -76,12 +78,12 @@ int token_source_get_tag(struct token_source_t *src, struct tag_t *tag, const ch
 		token_free(&token);
 		return ERROR_RETURN;
 	}
-	if (token.data.str.length != 3) {
-		fprintf(stdout, "[%s] Invalid TAG for %s: %s [line:%zu]\n", func_name, purpose, token.data.str.text, src->line_number);
+	if (string_length(&token.data.str) != 3) {
+		fprintf(stdout, "[%s] Invalid TAG for %s: %s [line:%zu]\n", func_name, purpose, string_text(&token.data.str), src->line_number);
 		token_free(&token);
 		return ERROR_RETURN;
 	}
-	memcpy(tag->text, token.data.str.text, 3);
+	memcpy(tag->text, string_text(&token.data.str), 3);
 	token_free(&token);
 	if (!tag_valid(tag)) {
 		fprintf(stdout, "[%s] Invalid TAG for %s: %s [line:%zu]\n", func_name, purpose, tag->text, src->line_number);
@@ -89,14 +91,14 @@ int token_source_get_tag(struct token_source_t *src, struct tag_t *tag, const ch
 	}
 	return 0;
 }
-int token_source_get_country(struct token_source_t *src, struct database_t *db, struct country_t **country, const char *func_name, const char *purpose) {
+int token_source_get_country(struct token_source_t *src, struct database_t *db, struct country_ref_t *country, const char *func_name, const char *purpose) {
 	assert(src && "token_source_get_country: src == 0");
 	assert(db && "token_source_get_country: db == 0");
 	assert(country && "token_source_get_country: country == 0");
 	struct tag_t tag = { 0 };
 	if (token_source_get_tag(src, &tag, func_name, purpose)) return ERROR_RETURN;
-	*country = database_get_country(db, &tag);
-	if (*country == 0) {
+	*country = database_country_ref(db, database_get_country(db, &tag));
+	if (country->index == 0) {
 		fprintf(stdout, "[%s] Unrecognised TAG for %s: %s [line:%zu]\n", func_name, purpose, tag.text, src->line_number);
 		return ERROR_RETURN;
 	}
@@ -107,25 +109,25 @@ boolean lexeme_get_tag(struct lexeme_t *root, struct tag_t *tag) {
 	assert(root && "lexeme_get_tag: root == 0");
 	assert(tag && "lexeme_get_tag: tag == 0");
 	memset(tag, 0, sizeof(struct tag_t));
-	if (root->compound || root->values == 0 || buf_len(root->values) != 1 || root->values[0]->key.type != ALPHANUMERIC || root->values[0]->key.data.str.length != 3) {
+	if (root->compound || root->values == 0 || buf_len(root->values) != 1 || root->values[0]->key.type != ALPHANUMERIC || string_length(&root->values[0]->key.data.str) != 3) {
 		fprintf(stdout, "[lexeme_get_tag] Invalid lexeme for TAG\n");
 		return false;
 	}
-	memcpy(tag->text, root->values[0]->key.data.str.text, 3);
+	memcpy(tag->text, string_text(&root->values[0]->key.data.str), 3);
 	if (!tag_valid(tag)) {
 		fprintf(stdout, "[lexeme_get_tag] Invalid TAG: %s\n", tag->text);
 		return false;
 	}
 	return true;
 }
-boolean lexeme_get_country(struct lexeme_t *root, struct database_t *db, struct country_t **country) {
+boolean lexeme_get_country(struct lexeme_t *root, struct database_t *db, struct country_ref_t *country) {
 	assert(root && "lexeme_get_country: root == 0");
 	assert(db && "lexeme_get_country: db == 0");
 	assert(country && "lexeme_get_country: country == 0");
 	struct tag_t tag = { 0 };
 	if (!lexeme_get_tag(root, &tag)) return false;
-	*country = database_get_country(db, &tag);
-	if (*country == 0) {
+	*country = database_country_ref(db, database_get_country(db, &tag));
+	if (country->index == 0) {
 		fprintf(stdout, "[lexeme_get_country] Unrecognised TAG: %s\n", tag.text);
 		return false;
 	}
@@ -133,32 +135,22 @@ boolean lexeme_get_country(struct lexeme_t *root, struct database_t *db, struct
 }
 
 int read_all_in_folder(struct database_t *db, read_file_func_t read_file_func, const char *base_folder, int *files_read, const char *func_name) {
-	WIN32_FIND_DATA foundFile;
-	HANDLE hFind = NULL;
-	char sPath[2048];
-	/* Specify a file mask. *.* = We want everything! */
-	sprintf_s(sPath, 2048, "%s/*.*", base_folder);
-	if ((hFind = FindFirstFile(sPath, &foundFile)) == INVALID_HANDLE_VALUE) {
+	directory_entry_t *entries = 0;
+	if (directory_list_files(base_folder, &entries) && buf_len(entries) == 0) {
 		fprintf(stdout, "[%s] could not find base folder: %s\n", func_name, base_folder);
+		directory_list_free(&entries);
 		return ERROR_RETURN;
 	}
 	int err = 0;
-	do {
-		if (strcmp(foundFile.cFileName, ".") != 0 && strcmp(foundFile.cFileName, "..") != 0) {
-			/* Build up our file path using the passed in [sDir] and the file/foldername we just found: */
-			sprintf_s(sPath, 2048, "%s/%s", base_folder, foundFile.cFileName);
-
-			/* Is the entity a File or Folder? */
-			if (foundFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)	/* Folder */
-				read_all_in_folder(db, read_file_func, sPath, files_read, func_name);
-			else														/* File */
-				if (read_file_func(db, sPath, foundFile.cFileName)) {
-					err++;
-					fprintf(stdout, "[%s] Failed to read file: %s\n\t(at %s)\n", func_name, foundFile.cFileName, sPath);
-				} else
-					*files_read += 1;
-		}
-	} while (FindNextFile(hFind, &foundFile));
-	FindClose(hFind);
+	for_buf(i, entries) {
+		directory_prefetch_next(entries, buf_len(entries), i);
+		const directory_entry_t *entry = &entries[i];
+		if (read_file_func(db, string_text(&entry->path), directory_entry_name(entry))) {
+			err++;
+			fprintf(stdout, "[%s] Failed to read file: %s\n\t(at %s)\n", func_name, directory_entry_name(entry), string_text(&entry->path));
+		} else
+			*files_read += 1;
+	}
+	directory_list_free(&entries);
 	return err;
 }
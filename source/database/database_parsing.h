@@ -10,24 +10,24 @@
 internal const date_t ACW_START_DATE = { .year = 1861, .month = 1, .day = 1 };
 internal const date_t DOMINIONS_START_DATE = { .year = 1836, .month = 1, .day = 2 };
 
-internal const char *flag_type_strings[FLAG_TYPE_COUNT] = { "communist", "republic", "fascist", "monarchy" };
+/* the string tables (<set>_strings[]) and their perfect hash lookups (<set>_keywords), see database_keys.h */
+#include "keywords.h"
 
-internal const char *graphical_culture_strings[GRAPHICAL_CULTURE_COUNT] = { "Generic", "BritishGC", "EuropeanGC", "MiddleEasternGC",
-	"ChineseGC", "IndianGC", "AfricanGC", "UsGC", "RussianGC", "FrenchGC", "PrussianGC", "ItalianGC", "AustriaHungaryGC", "SwedishGC",
-	"SpanishGC", "OttomanGC", "MoroccoGC", "ZuluGC", "AsianGC", "SouthAmericanGC", "ConfederateGC", "JapaneseGC" };
+_Static_assert(sizeof(flag_type_strings) / sizeof(flag_type_strings[0]) == FLAG_TYPE_COUNT, "flag_type_strings doesn't match enum flag_type_t");
+_Static_assert(sizeof(graphical_culture_strings) / sizeof(graphical_culture_strings[0]) == GRAPHICAL_CULTURE_COUNT, "graphical_culture_strings doesn't match enum graphical_culture_t");
+_Static_assert(sizeof(leader_strings) / sizeof(leader_strings[0]) == LEADER_COUNT, "leader_strings doesn't match enum leader_t");
+_Static_assert(sizeof(reform_type_strings) / sizeof(reform_type_strings[0]) == REFORM_TYPE_COUNT, "reform_type_strings doesn't match enum reform_type_t");
+_Static_assert(sizeof(unit_terrain_type_strings) / sizeof(unit_terrain_type_strings[0]) == UNIT_TERRAIN_TYPE_COUNT, "unit_terrain_type_strings doesn't match enum unit_terrain_type_t");
+_Static_assert(sizeof(unit_type_strings) / sizeof(unit_type_strings[0]) == UNIT_TYPE_COUNT, "unit_type_strings doesn't match enum unit_type_t");
 
-internal const char *leader_strings[LEADER_COUNT] = { "european", "russian", "arab", "asian", "indian", "nativeamerican", "southamerican", "african", "polar_bear" };
-
-internal const char *reform_type_strings[REFORM_TYPE_COUNT] = { "political_reforms", "social_reforms", "economic_reforms", "military_reforms" };
-
-internal const char *unit_terrain_type_strings[UNIT_TERRAIN_TYPE_COUNT] = { "land", "naval" };
-internal const char *unit_type_strings[UNIT_TYPE_COUNT] = { "infantry", "cavalry", "support", "special", "transport", "light_ship", "big_ship" };
+/* the index of str in a keyword set, -1 if it isn't in it */
+#define keyword_lookup_string(set, str) keyword_lookup((set), string_text(str), string_length(str))
 
 int token_source_get_tag(struct token_source_t * src, struct tag_t * tag, const char *func_name, const char *purpose);
-int token_source_get_country(struct token_source_t *src, struct database_t *db, struct country_t **country, const char *func_name, const char *purpose);
+int token_source_get_country(struct token_source_t *src, struct database_t *db, struct country_ref_t *country, const char *func_name, const char *purpose);
 
 boolean lexeme_get_tag(struct lexeme_t *root, struct tag_t *tag);
-boolean lexeme_get_country(struct lexeme_t *root, struct database_t *db, struct country_t **country);
+boolean lexeme_get_country(struct lexeme_t *root, struct database_t *db, struct country_ref_t *country);
 
 typedef int(*read_file_func_t)(struct database_t *db, const char *filepath, const char *filename);
 int read_all_in_folder(struct database_t * db, read_file_func_t read_file_func, const char *base_folder, int *files_read, const char *func_name);
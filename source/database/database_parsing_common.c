@@ -1,4 +1,5 @@
 #include "database_parsing.h"
+#include "database_schema.h"
 
 #include "assert_opt.h"
 #include "memory_opt.h"
@@ -20,7 +21,7 @@ int read_trade_goods(struct database_t *db, const char *filename) {
 		struct lexeme_t *group_l = root_l->values[i];
 		if (lexeme_is_named_group(group_l)) {
 			if (database_get_trade_good_group(db, &group_l->key.data.str)) {
-				fprintf(stdout, "[read_trade_goods] Duplicate trade good group with name: %s\n", group_l->key.data.str.text);
+				fprintf(stdout, "[read_trade_goods] Duplicate trade good group with name: %s\n", string_text(&group_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct trade_good_group_t group = { 0 };
@@ -29,63 +30,36 @@ int read_trade_goods(struct database_t *db, const char *filename) {
 					struct lexeme_t *good_l = group_l->values[j];
 					if (lexeme_is_named_group(good_l)) {
 						if (database_get_trade_good(db, &good_l->key.data.str)) {
-							fprintf(stdout, "[read_trade_goods] Duplicate trade good with name: %s\n", good_l->key.data.str.text);
+							fprintf(stdout, "[read_trade_goods] Duplicate trade good with name: %s\n", string_text(&good_l->key.data.str));
 							err = ERROR_RETURN;
 						} else {
 							struct trade_good_t good = trade_good_default();
 							string_set(&good.name, &good_l->key.data.str);
+							u64 seen = 0;
 							for_buf(k, good_l->values) {	// for each trade good arg...
 								struct lexeme_t *arg_l = good_l->values[k];
 								if (arg_l->key.type == ALPHANUMERIC) {
-									if (string_equal_c(&arg_l->key.data.str, "cost")) {
-										if (!lexeme_get_int_or_decimal(arg_l, &good.cost)) {
-											fprintf(stdout, "[read_trade_goods] Cost for %s is not a number\n", good.name.text);
-											err = ERROR_RETURN;
-										}
-									} else if (string_equal_c(&arg_l->key.data.str, "color")) {
-										u8 col[3] = { 0 };
-										if (lexeme_get_color(arg_l, col))
-											good.color = to_color(col);
-										else {
-											fprintf(stdout, "[read_trade_goods] Could not read color for %s\n", good.name.text);
-											err = ERROR_RETURN;
-										}
-									} else if (string_equal_c(&arg_l->key.data.str, "available_from_start")) {
-										if (!lexeme_get_bool(arg_l, &good.available_from_start)) {
-											fprintf(stdout, "[read_trade_goods] Could not read available_from_start bool for %s\n", good.name.text);
-											err = ERROR_RETURN;
-										}
-									} else if (string_equal_c(&arg_l->key.data.str, "tradeable")) {
-										if (!lexeme_get_bool(arg_l, &good.tradeable)) {
-											fprintf(stdout, "[read_trade_goods] Could not read tradeable bool for %s\n", good.name.text);
-											err = ERROR_RETURN;
-										}
-									} else if (string_equal_c(&arg_l->key.data.str, "money")) {
-										if (!lexeme_get_bool(arg_l, &good.money)) {
-											fprintf(stdout, "[read_trade_goods] Could not read money bool for %s\n", good.name.text);
-											err = ERROR_RETURN;
-										}
-									} else if (string_equal_c(&arg_l->key.data.str, "overseas_penalty")) {
-										if (!lexeme_get_bool(arg_l, &good.overseas_penalty)) {
-											fprintf(stdout, "[read_trade_goods] Could not read overseas_penalty bool for %s\n", good.name.text);
-											err = ERROR_RETURN;
-										}
+									const int key = keyword_lookup_string(&trade_good_keywords, &arg_l->key.data.str);
+									if (schema_has_field(&trade_good_schema, key)) {
+										if (schema_apply_lexeme(&trade_good_schema, &good, key, arg_l, "read_trade_goods", string_text(&good.name))) err = ERROR_RETURN;
+										else schema_mark_seen(&seen, key);
 									} else {
-										fprintf(stdout, "[read_trade_goods] Unrecognised trade good specification for %s: %s\n", good.name.text, arg_l->key.data.str.text);
+										fprintf(stdout, "[read_trade_goods] Unrecognised trade good specification for %s: %s\n", string_text(&good.name), string_text(&arg_l->key.data.str));
 										err = ERROR_RETURN;
 									}
 								} else {
-									fprintf(stdout, "[read_trade_goods] Invalid token (expected alphanumeric trade good specifications for %s): ", good.name.text);
+									fprintf(stdout, "[read_trade_goods] Invalid token (expected alphanumeric trade good specifications for %s): ", string_text(&good.name));
 									token_print(stdout, &arg_l->key);
 									fprintf(stdout, "\n");
 									err = ERROR_RETURN;
 								}
 							}
-							database_add_trade_good(db, &good);
-							trade_good_group_add_trade_good(&group, (struct trade_good_t *)buf_len(db->trade_goods));
+							schema_check_required(&trade_good_schema, seen, "read_trade_goods", string_text(&good.name));
+							good.group = database_next_trade_good_group_ref(db);
+							trade_good_group_add_trade_good(&group, database_add_trade_good(db, &good));
 						}
 					} else {
-						fprintf(stdout, "[read_trade_goods] Invalid token (expected alphanumeric trade good definition for %s): ", group.name.text);
+						fprintf(stdout, "[read_trade_goods] Invalid token (expected alphanumeric trade good definition for %s): ", string_text(&group.name));
 						token_print(stdout, &group_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
@@ -103,14 +77,6 @@ int read_trade_goods(struct database_t *db, const char *filename) {
 
 	lexeme_delete(root_l);
 
-	for_buf(i, db->trade_good_groups) {
-		struct trade_good_group_t *group = &db->trade_good_groups[i];
-		for_buf(j, group->trade_goods) {
-			group->trade_goods[j] = &db->trade_goods[(size_t)group->trade_goods[j] - 1];
-			group->trade_goods[j]->group = group;
-		}
-	}
-
 	fprintf(stdout, "[read_trade_goods] Loaded %zu trade_goods into %zu trade_good groups.\n", buf_len(db->trade_goods), buf_len(db->trade_good_groups));
 	return err;
 }
@@ -122,8 +88,8 @@ int write_trade_goods(struct database_t *db, const char *filename) {
 	for_buf(i, db->trade_good_groups) { // for each trade good group...
 		struct trade_good_group_t *group = &db->trade_good_groups[i];
 		struct lexeme_t *group_l = lexeme_new_alphanumeric(&group->name, true, true);
-		for_buf(j, group->trade_goods) { // for each trade good in the group...
-			struct trade_good_t *good = group->trade_goods[j];
+		for_svec(j, group->trade_goods) { // for each trade good in the group...
+			const struct trade_good_t *good = database_trade_good(db, svec_at(group->trade_goods, j));
 			struct lexeme_t *good_l = lexeme_new_alphanumeric(&good->name, true, true);
 			{	// cost
 				struct lexeme_t *cost_l = lexeme_new_alphanumeric_c("cost", false);
@@ -182,7 +148,7 @@ int read_ideologies(struct database_t *db, const char *filename) {
 		struct lexeme_t *group_l = root_l->values[i];
 		if (lexeme_is_named_group(group_l)) {
 			if (database_get_ideology_group(db, &group_l->key.data.str)) {
-				fprintf(stdout, "[read_ideologies] Duplicate ideology group with name: %s\n", group_l->key.data.str.text);
+				fprintf(stdout, "[read_ideologies] Duplicate ideology group with name: %s\n", string_text(&group_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct ideology_group_t group = { 0 };
@@ -191,7 +157,7 @@ int read_ideologies(struct database_t *db, const char *filename) {
 					struct lexeme_t *ideology_l = group_l->values[j];
 					if (lexeme_is_named_group(ideology_l)) {
 						if (database_get_ideology(db, &ideology_l->key.data.str)) {
-							fprintf(stdout, "[read_ideologies] Duplicate ideology with name: %s\n", ideology_l->key.data.str.text);
+							fprintf(stdout, "[read_ideologies] Duplicate ideology with name: %s\n", string_text(&ideology_l->key.data.str));
 							err = ERROR_RETURN;
 						} else {
 							struct ideology_t ideology = ideology_default();
@@ -201,7 +167,7 @@ int read_ideologies(struct database_t *db, const char *filename) {
 								if (arg_l->key.type == ALPHANUMERIC) {
 									if (string_equal_c(&arg_l->key.data.str, "uncivilized")) {
 										if (!lexeme_get_bool(arg_l, &ideology.uncivilized)) {
-											fprintf(stdout, "[read_ideologies] Could not read uncivilized bool for %s\n", ideology.name.text);
+											fprintf(stdout, "[read_ideologies] Could not read uncivilized bool for %s\n", string_text(&ideology.name));
 											err = ERROR_RETURN;
 										}
 									} else if (string_equal_c(&arg_l->key.data.str, "color")) {
@@ -209,17 +175,17 @@ int read_ideologies(struct database_t *db, const char *filename) {
 										if (lexeme_get_color(arg_l, col))
 											ideology.color = to_color(col);
 										else {
-											fprintf(stdout, "[read_ideologies] Could not read color for %s\n", ideology.name.text);
+											fprintf(stdout, "[read_ideologies] Could not read color for %s\n", string_text(&ideology.name));
 											err = ERROR_RETURN;
 										}
 									} else if (string_equal_c(&arg_l->key.data.str, "date")) {
 										if (!lexeme_get_date(arg_l, &ideology.date)) {
-											fprintf(stdout, "[read_ideologies] Could not read date for %s\n", ideology.name.text);
+											fprintf(stdout, "[read_ideologies] Could not read date for %s\n", string_text(&ideology.name));
 											err = ERROR_RETURN;
 										}
 									} else if (string_equal_c(&arg_l->key.data.str, "can_reduce_militancy")) {
 										if (!lexeme_get_bool(arg_l, &ideology.can_reduce_militancy)) {
-											fprintf(stdout, "[read_ideologies] Could not read can_reduce_militancy bool for %s\n", ideology.name.text);
+											fprintf(stdout, "[read_ideologies] Could not read can_reduce_militancy bool for %s\n", string_text(&ideology.name));
 											err = ERROR_RETURN;
 										}
 									} else if (string_equal_c(&arg_l->key.data.str, "add_political_reform") || string_equal_c(&arg_l->key.data.str, "remove_political_reform") ||
@@ -227,21 +193,21 @@ int read_ideologies(struct database_t *db, const char *filename) {
 										string_equal_c(&arg_l->key.data.str, "add_military_reform") || string_equal_c(&arg_l->key.data.str, "add_economic_reform")) {
 										// TODO parse these modifiers
 									} else {
-										fprintf(stdout, "[read_ideologies] Unrecognised ideology specification for %s: %s\n", ideology.name.text, arg_l->key.data.str.text);
+										fprintf(stdout, "[read_ideologies] Unrecognised ideology specification for %s: %s\n", string_text(&ideology.name), string_text(&arg_l->key.data.str));
 										err = ERROR_RETURN;
 									}
 								} else {
-									fprintf(stdout, "[read_ideologies] Invalid token (expected alphanumeric ideology specifications for %s): ", ideology.name.text);
+									fprintf(stdout, "[read_ideologies] Invalid token (expected alphanumeric ideology specifications for %s): ", string_text(&ideology.name));
 									token_print(stdout, &arg_l->key);
 									fprintf(stdout, "\n");
 									err = ERROR_RETURN;
 								}
 							}
-							database_add_ideology(db, &ideology);
-							ideology_group_add_ideology(&group, (struct ideology_t *)buf_len(db->ideologies));
+							ideology.group = database_next_ideology_group_ref(db);
+							ideology_group_add_ideology(&group, database_add_ideology(db, &ideology));
 						}
 					} else {
-						fprintf(stdout, "[read_ideologies] Invalid token (expected alphanumeric ideology definition for %s): ", group.name.text);
+						fprintf(stdout, "[read_ideologies] Invalid token (expected alphanumeric ideology definition for %s): ", string_text(&group.name));
 						token_print(stdout, &group_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
@@ -259,14 +225,6 @@ int read_ideologies(struct database_t *db, const char *filename) {
 
 	lexeme_delete(root_l);
 
-	for_buf(i, db->ideology_groups) {
-		struct ideology_group_t *group = &db->ideology_groups[i];
-		for_buf(j, group->ideologies) {
-			group->ideologies[j] = &db->ideologies[(size_t)group->ideologies[j] - 1];
-			group->ideologies[j]->group = group;
-		}
-	}
-
 	fprintf(stdout, "[read_ideologies] Loaded %zu ideologies into %zu ideology groups.\n", buf_len(db->ideologies), buf_len(db->ideology_groups));
 	return err;
 }
@@ -294,7 +252,7 @@ int read_issues(struct database_t *db, const char *filename) {
 				struct lexeme_t *group_l = parent->values[i];
 				if (lexeme_is_named_group(group_l)) {
 					if (database_get_issue_group(db, &group_l->key.data.str)) {
-						fprintf(stdout, "[read_issues] Duplicate issue group with name: %s\n", group_l->key.data.str.text);
+						fprintf(stdout, "[read_issues] Duplicate issue group with name: %s\n", string_text(&group_l->key.data.str));
 						err = ERROR_RETURN;
 					} else {
 						struct issue_group_t group = { 0 };
@@ -303,7 +261,7 @@ int read_issues(struct database_t *db, const char *filename) {
 							struct lexeme_t *issue_l = group_l->values[j];
 							if (lexeme_is_named_group(issue_l)) {
 								if (database_get_issue(db, &issue_l->key.data.str)) {
-									fprintf(stdout, "[read_issues] Duplicate issue with name: %s\n", issue_l->key.data.str.text);
+									fprintf(stdout, "[read_issues] Duplicate issue with name: %s\n", string_text(&issue_l->key.data.str));
 									err = ERROR_RETURN;
 								} else {
 									struct issue_t issue = { 0 };
@@ -313,17 +271,17 @@ int read_issues(struct database_t *db, const char *filename) {
 										if (arg_l->key.type == ALPHANUMERIC) {
 											// TODO parse these modifiers
 										} else {
-											fprintf(stdout, "[read_issues] Invalid token (expected alphanumeric issue specifications for %s): ", issue.name.text);
+											fprintf(stdout, "[read_issues] Invalid token (expected alphanumeric issue specifications for %s): ", string_text(&issue.name));
 											token_print(stdout, &arg_l->key);
 											fprintf(stdout, "\n");
 											err = ERROR_RETURN;
 										}
 									}*/
-									database_add_issue(db, &issue);
-									issue_group_add_issue(&group, (struct issue_t *)buf_len(db->issues));
+									issue.group = database_next_issue_group_ref(db);
+									issue_group_add_issue(&group, database_add_issue(db, &issue));
 								}
 							} else {
-								fprintf(stdout, "[read_issues] Invalid token (expected alphanumeric issue definition for %s): ", group.name.text);
+								fprintf(stdout, "[read_issues] Invalid token (expected alphanumeric issue definition for %s): ", string_text(&group.name));
 								token_print(stdout, &group_l->key);
 								fprintf(stdout, "\n");
 								err = ERROR_RETURN;
@@ -339,14 +297,13 @@ int read_issues(struct database_t *db, const char *filename) {
 				}
 			}
 		} else {
-			enum reform_type_t type;
-			for (type = 0; type < REFORM_TYPE_COUNT && !string_equal_c(&parent->key.data.str, reform_type_strings[type]); type++);
-			if (type < REFORM_TYPE_COUNT) {
+			const int type = keyword_lookup_string(&reform_type_keywords, &parent->key.data.str);
+			if (type >= 0) {
 				for_buf(m, parent->values) {
 					struct lexeme_t *group_l = parent->values[m];
 					if (group_l->key.type == ALPHANUMERIC) {
 						if (database_get_reform_group(db, &group_l->key.data.str)) {
-							fprintf(stdout, "[read_reforms] Duplicate reform group with name: %s\n", group_l->key.data.str.text);
+							fprintf(stdout, "[read_reforms] Duplicate reform group with name: %s\n", string_text(&group_l->key.data.str));
 							err = ERROR_RETURN;
 						}
 						struct reform_group_t group = { 0 };
@@ -356,29 +313,29 @@ int read_issues(struct database_t *db, const char *filename) {
 							if (reform_l->key.type == ALPHANUMERIC) {
 								if (string_equal_c(&reform_l->key.data.str, "next_step_only")) {
 									//if (!lexeme_get_bool(reform_l, &group.next_step_only)) {
-									//	fprintf(stdout, "[read_reforms] Could not read next_step_only bool for %s\n", group.name.text);
+									//	fprintf(stdout, "[read_reforms] Could not read next_step_only bool for %s\n", string_text(&group.name));
 									//	err = ERROR_RETURN;
 									//}
 									// TODO WHAT TO DO WITH next_step_only???
 								} else if (string_equal_c(&reform_l->key.data.str, "administrative")) {
 									//if (!lexeme_get_bool(reform_l, &administrative.next_step_only)) {
-									//	fprintf(stdout, "[read_reforms] Could not read administrative bool for %s\n", group.name.text);
+									//	fprintf(stdout, "[read_reforms] Could not read administrative bool for %s\n", string_text(&group.name));
 									//	err = ERROR_RETURN;
 									//}
 									// TODO WHAT TO DO WITH administrative???
 								} else {
 									if (database_get_reform(db, &reform_l->key.data.str)) {
-										fprintf(stdout, "[read_reforms] Duplicate reform with name: %s\n", reform_l->key.data.str.text);
+										fprintf(stdout, "[read_reforms] Duplicate reform with name: %s\n", string_text(&reform_l->key.data.str));
 										err = ERROR_RETURN;
 									}
 									struct reform_t reform = { .type = type };
 									string_set(&reform.name, &reform_l->key.data.str);
 									// TODO process effects here
-									database_add_reform(db, &reform);
-									reform_group_add_reform(&group, (struct reform_t *)buf_len(db->reforms));
+									reform.group = database_next_reform_group_ref(db);
+									reform_group_add_reform(&group, database_add_reform(db, &reform));
 								}
 							} else {
-								fprintf(stdout, "[read_reforms] Invalid token (expected alphanumeric reform definition for %s): ", group.name.text);
+								fprintf(stdout, "[read_reforms] Invalid token (expected alphanumeric reform definition for %s): ", string_text(&group.name));
 								token_print(stdout, &reform_l->key);
 								fprintf(stdout, "\n");
 								err = ERROR_RETURN;
@@ -397,7 +354,7 @@ int read_issues(struct database_t *db, const char *filename) {
 					}
 				}
 			} else {
-				fprintf(stdout, "[read_issues] Unrecognised alphanumeric (expected issue or reform group definition): %s\n", parent->key.data.str.text);
+				fprintf(stdout, "[read_issues] Unrecognised alphanumeric (expected issue or reform group definition): %s\n", string_text(&parent->key.data.str));
 				err = ERROR_RETURN;
 			}
 		}
@@ -405,22 +362,6 @@ int read_issues(struct database_t *db, const char *filename) {
 
 	lexeme_delete(root_l);
 
-	for_buf(i, db->issue_groups) {
-		struct issue_group_t *group = &db->issue_groups[i];
-		for_buf(j, group->issues) {
-			group->issues[j] = &db->issues[(size_t)group->issues[j] - 1];
-			group->issues[j]->group = group;
-		}
-	}
-
-	for_buf(i, db->reform_groups) {
-		struct reform_group_t *group = &db->reform_groups[i];
-		for_buf(j, group->reforms) {
-			group->reforms[j] = &db->reforms[(size_t)group->reforms[j] - 1];
-			group->reforms[j]->group = group;
-		}
-	}
-
 	fprintf(stdout, "[read_issues] Loaded %zu issues into %zu issue groups.\n", buf_len(db->issues), buf_len(db->issue_groups));
 	fprintf(stdout, "[read_reforms] Loaded %zu reforms into %zu reform groups.\n", buf_len(db->reforms), buf_len(db->reform_groups));
 	return err;
@@ -443,7 +384,7 @@ int read_national_values(struct database_t *db, const char *filename) {
 			continue;
 		}
 		if (database_get_national_value(db, &nv_l->key.data.str)) {
-			fprintf(stdout, "[read_national_values] Duplicate national_value with name: %s\n", nv_l->key.data.str.text);
+			fprintf(stdout, "[read_national_values] Duplicate national_value with name: %s\n", string_text(&nv_l->key.data.str));
 			err = ERROR_RETURN;
 			continue;
 		}
@@ -472,7 +413,7 @@ int read_religions(struct database_t *db, const char *filename) {
 		struct lexeme_t *group_l = root_l->values[i];
 		if (lexeme_is_named_group(group_l)) {
 			if (database_get_religion_group(db, &group_l->key.data.str)) {
-				fprintf(stdout, "[read_religions] Duplicate religion group with name: %s\n", group_l->key.data.str.text);
+				fprintf(stdout, "[read_religions] Duplicate religion group with name: %s\n", string_text(&group_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct religion_group_t group = { 0 };
@@ -481,7 +422,7 @@ int read_religions(struct database_t *db, const char *filename) {
 					struct lexeme_t *religion_l = group_l->values[j];
 					if (lexeme_is_named_group(religion_l)) {
 						if (database_get_religion(db, &religion_l->key.data.str)) {
-							fprintf(stdout, "[read_religions] Duplicate religion with name: %s\n", religion_l->key.data.str.text);
+							fprintf(stdout, "[read_religions] Duplicate religion with name: %s\n", string_text(&religion_l->key.data.str));
 							err = ERROR_RETURN;
 						} else {
 							struct religion_t religion = { 0 };
@@ -492,7 +433,7 @@ int read_religions(struct database_t *db, const char *filename) {
 									if (string_equal_c(&arg_l->key.data.str, "icon")) {
 										int tmp = 0;
 										if (!lexeme_get_int(arg_l, &tmp)) {
-											fprintf(stdout, "[read_religions] Could not read icon int for %s\n", religion.name.text);
+											fprintf(stdout, "[read_religions] Could not read icon int for %s\n", string_text(&religion.name));
 											err = ERROR_RETURN;
 										} else religion.icon = tmp;
 									} else if (string_equal_c(&arg_l->key.data.str, "color")) {
@@ -500,30 +441,30 @@ int read_religions(struct database_t *db, const char *filename) {
 										if (lexeme_get_color(arg_l, col))
 											religion.color = to_color(col);
 										else {
-											fprintf(stdout, "[read_religions] Could not read color for %s\n", religion.name.text);
+											fprintf(stdout, "[read_religions] Could not read color for %s\n", string_text(&religion.name));
 											err = ERROR_RETURN;
 										}
 									} else if (string_equal_c(&arg_l->key.data.str, "pagan")) {
 										if (!lexeme_get_bool(arg_l, &religion.pagan)) {
-											fprintf(stdout, "[read_religions] Could not read pagan bool for %s\n", religion.name.text);
+											fprintf(stdout, "[read_religions] Could not read pagan bool for %s\n", string_text(&religion.name));
 											err = ERROR_RETURN;
 										}
 									} else {
-										fprintf(stdout, "[read_religions] Unrecognised religion specification for %s: %s\n", religion.name.text, arg_l->key.data.str.text);
+										fprintf(stdout, "[read_religions] Unrecognised religion specification for %s: %s\n", string_text(&religion.name), string_text(&arg_l->key.data.str));
 										err = ERROR_RETURN;
 									}
 								} else {
-									fprintf(stdout, "[read_religions] Invalid token (expected alphanumeric religion specifications for %s): ", religion.name.text);
+									fprintf(stdout, "[read_religions] Invalid token (expected alphanumeric religion specifications for %s): ", string_text(&religion.name));
 									token_print(stdout, &arg_l->key);
 									fprintf(stdout, "\n");
 									err = ERROR_RETURN;
 								}
 							}
-							database_add_religion(db, &religion);
-							religion_group_add_religion(&group, (struct religion_t *)buf_len(db->religions));
+							religion.group = database_next_religion_group_ref(db);
+							religion_group_add_religion(&group, database_add_religion(db, &religion));
 						}
 					} else {
-						fprintf(stdout, "[read_religions] Invalid token (expected alphanumeric religion definition for %s): ", group.name.text);
+						fprintf(stdout, "[read_religions] Invalid token (expected alphanumeric religion definition for %s): ", string_text(&group.name));
 						token_print(stdout, &group_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
@@ -541,14 +482,6 @@ int read_religions(struct database_t *db, const char *filename) {
 
 	lexeme_delete(root_l);
 
-	for_buf(i, db->religion_groups) {
-		struct religion_group_t *group = &db->religion_groups[i];
-		for_buf(j, group->religions) {
-			group->religions[j] = &db->religions[(size_t)group->religions[j] - 1];
-			group->religions[j]->group = group;
-		}
-	}
-
 	fprintf(stdout, "[read_religions] Loaded %zu religions into %zu religion groups.\n", buf_len(db->religions), buf_len(db->religion_groups));
 	return err;
 }
@@ -566,7 +499,7 @@ int read_government_types(struct database_t *db, const char *filename) {
 		struct lexeme_t *gov_l = root_l->values[i];
 		if (lexeme_is_named_group(gov_l)) {
 			if (database_get_government_type(db, &gov_l->key.data.str)) {
-				fprintf(stdout, "[read_government_types] Duplicate government type with name: %s\n", gov_l->key.data.str.text);
+				fprintf(stdout, "[read_government_types] Duplicate government type with name: %s\n", string_text(&gov_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct government_type_t gov = { 0 };
@@ -577,31 +510,30 @@ int read_government_types(struct database_t *db, const char *filename) {
 					if (arg_l->key.type == ALPHANUMERIC) {
 						if (string_equal_c(&arg_l->key.data.str, "election")) {
 							if (!lexeme_get_bool(arg_l, &gov.election)) {
-								fprintf(stdout, "[read_government_types] Could not read election bool for %s\n", gov.name.text);
+								fprintf(stdout, "[read_government_types] Could not read election bool for %s\n", string_text(&gov.name));
 								err = ERROR_RETURN;
 							}
 						} else if (string_equal_c(&arg_l->key.data.str, "duration")) {
 							int tmp = 0;
 							if (!lexeme_get_int(arg_l, &tmp)) {
-								fprintf(stdout, "[read_government_types] Could not read duration int for %s\n", gov.name.text);
+								fprintf(stdout, "[read_government_types] Could not read duration int for %s\n", string_text(&gov.name));
 								err = ERROR_RETURN;
 							}
 							gov.duration = tmp;
 						} else if (string_equal_c(&arg_l->key.data.str, "appoint_ruling_party")) {
 							if (!lexeme_get_bool(arg_l, &gov.appoint_ruling_party)) {
-								fprintf(stdout, "[read_government_types] Could not read appoint_ruling_party bool for %s\n", gov.name.text);
+								fprintf(stdout, "[read_government_types] Could not read appoint_ruling_party bool for %s\n", string_text(&gov.name));
 								err = ERROR_RETURN;
 							}
 						} else if (string_equal_c(&arg_l->key.data.str, "flagType")) {
 							if (arg_l->compound || arg_l->values == 0 || arg_l->values[0]->key.type != ALPHANUMERIC) {
-								fprintf(stdout, "[read_government_types] Unrecognised flagType for %s\n", gov.name.text);
+								fprintf(stdout, "[read_government_types] Unrecognised flagType for %s\n", string_text(&gov.name));
 								err = ERROR_RETURN;
 							} else {
-								enum flag_type_t f;
-								for (f = 0; f < FLAG_TYPE_COUNT && !string_equal_c(&arg_l->values[0]->key.data.str, flag_type_strings[f]); ++f);
-								if (f == FLAG_TYPE_COUNT) {
+								const int f = keyword_lookup_string(&flag_type_keywords, &arg_l->values[0]->key.data.str);
+								if (f < 0) {
 									fprintf(stdout, "[read_government_types] Unknown flag type for %s: %s\n",
-										gov.name.text, arg_l->values[0]->key.data.str.text);
+										string_text(&gov.name), string_text(&arg_l->values[0]->key.data.str));
 									err = ERROR_RETURN;
 								} else gov.flag = f;
 							}
@@ -609,16 +541,16 @@ int read_government_types(struct database_t *db, const char *filename) {
 							struct ideology_t *ideo = database_get_ideology(db, &arg_l->key.data.str);
 							if (ideo) {
 								if (!lexeme_get_bool(arg_l, &gov.ideologies[database_ideology_index(db, ideo)])) {
-									fprintf(stdout, "[read_government_types] Could not read %s bool for %s\n", ideo->name.text, gov.name.text);
+									fprintf(stdout, "[read_government_types] Could not read %s bool for %s\n", string_text(&ideo->name), string_text(&gov.name));
 									err = ERROR_RETURN;
 								}
 							} else {
-								fprintf(stdout, "[read_government_types] Unrecognised government type specification for %s: %s\n", gov.name.text, arg_l->key.data.str.text);
+								fprintf(stdout, "[read_government_types] Unrecognised government type specification for %s: %s\n", string_text(&gov.name), string_text(&arg_l->key.data.str));
 								err = ERROR_RETURN;
 							}
 						}
 					} else {
-						fprintf(stdout, "[read_government_types] Invalid token (expected alphanumeric government type specifications for %s): ", gov.name.text);
+						fprintf(stdout, "[read_government_types] Invalid token (expected alphanumeric government type specifications for %s): ", string_text(&gov.name));
 						token_print(stdout, &arg_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
@@ -649,11 +581,12 @@ int read_countries(struct database_t *db, const char *filename) {
 		return ERROR_RETURN;
 	}
 	int err = 0;
+	buf_reserve(db->countries, buf_len(db->countries) + buf_len(root_l->values));
 	for_buf(i, root_l->values) {	// for each country
 		struct lexeme_t *country_l = root_l->values[i];
-		if (country_l->key.type == ALPHANUMERIC && country_l->key.data.str.length == 3) {
+		if (country_l->key.type == ALPHANUMERIC && string_length(&country_l->key.data.str) == 3) {
 			struct country_t country = { 0 };
-			memcpy(country.tag.text, country_l->key.data.str.text, 3);
+			memcpy(country.tag.text, string_text(&country_l->key.data.str), 3);
 			if (!tag_valid(&country.tag)) {
 				fprintf(stdout, "[read_countries] Invalid TAG: %s\n", country.tag.text);
 				err = ERROR_RETURN;
@@ -700,7 +633,7 @@ int read_cultures(struct database_t *db, const char *filename) {
 		struct lexeme_t *group_l = root_l->values[i];
 		if (lexeme_is_named_group(group_l)) {
 			if (database_get_culture_group(db, &group_l->key.data.str)) {
-				fprintf(stdout, "[read_cultures] Duplicate culture group with name: %s\n", group_l->key.data.str.text);
+				fprintf(stdout, "[read_cultures] Duplicate culture group with name: %s\n", string_text(&group_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct culture_group_t group = { 0 };
@@ -713,14 +646,13 @@ int read_cultures(struct database_t *db, const char *filename) {
 						} else if (string_equal_c(&culture_l->key.data.str, "leader")) {
 							string tmp = { 0 };
 							if (!lexeme_get_alphanumeric(culture_l, &tmp)) {
-								fprintf(stdout, "[read_cultures] Could not read leader alphanumeric for %s\n", group.name.text);
+								fprintf(stdout, "[read_cultures] Could not read leader alphanumeric for %s\n", string_text(&group.name));
 								err = ERROR_RETURN;
 							} else {
-								enum leader_t l;
-								for (l = 0; l < LEADER_COUNT && !string_equal_c(&tmp, leader_strings[l]); ++l);
-								if (l == LEADER_COUNT) {
+								const int l = keyword_lookup_string(&leader_keywords, &tmp);
+								if (l < 0) {
 									fprintf(stdout, "[read_cultures] Unknown leader type for %s: %s\n",
-										group.name.text, tmp.text);
+										string_text(&group.name), string_text(&tmp));
 									err = ERROR_RETURN;
 								} else group.leader = l;
 							}
@@ -728,26 +660,25 @@ int read_cultures(struct database_t *db, const char *filename) {
 						} else if (string_equal_c(&culture_l->key.data.str, "unit")) {
 							string tmp = { 0 };
 							if (!lexeme_get_alphanumeric(culture_l, &tmp)) {
-								fprintf(stdout, "[read_cultures] Could not read unit alphanumeric for %s\n", group.name.text);
+								fprintf(stdout, "[read_cultures] Could not read unit alphanumeric for %s\n", string_text(&group.name));
 								err = ERROR_RETURN;
 							} else {
-								enum graphical_culture_t u;
-								for (u = 0; u < GRAPHICAL_CULTURE_COUNT && !string_equal_c(&tmp, graphical_culture_strings[u]); ++u);
-								if (u == GRAPHICAL_CULTURE_COUNT) {
+								const int u = keyword_lookup_string(&graphical_culture_keywords, &tmp);
+								if (u < 0) {
 									fprintf(stdout, "[read_cultures] Unknown graphical culture (unit) type for %s: %s\n",
-										group.name.text, tmp.text);
+										string_text(&group.name), string_text(&tmp));
 									err = ERROR_RETURN;
 								} else group.unit = u;
 							}
 							string_clear(&tmp);
 						} else if (string_equal_c(&culture_l->key.data.str, "union")) {
 							if (!lexeme_get_country(culture_l, db, &group.cultural_union)) {
-								fprintf(stdout, "[read_cultures] Could not read union TAG for %s\n", group.name.text);
+								fprintf(stdout, "[read_cultures] Could not read union TAG for %s\n", string_text(&group.name));
 								err = ERROR_RETURN;
 							}
 						} else {
 							if (database_get_culture(db, &culture_l->key.data.str)) {
-								fprintf(stdout, "[read_cultures] Duplicate culture with name: %s\n", culture_l->key.data.str.text);
+								fprintf(stdout, "[read_cultures] Duplicate culture with name: %s\n", string_text(&culture_l->key.data.str));
 								err = ERROR_RETURN;
 							} else {
 								struct culture_t culture = { 0 };
@@ -760,31 +691,32 @@ int read_cultures(struct database_t *db, const char *filename) {
 											if (lexeme_get_color(arg_l, col))
 												culture.color = to_color(col);
 											else {
-												fprintf(stdout, "[read_cultures] Could not read color for %s\n", culture.name.text);
+												fprintf(stdout, "[read_cultures] Could not read color for %s\n", string_text(&culture.name));
 												err = ERROR_RETURN;
 											}
 										} else if (string_equal_c(&arg_l->key.data.str, "radicalism")) {
 											int tmp = 0;
 											if (!lexeme_get_int(arg_l, &tmp)) {
-												fprintf(stdout, "[read_cultures] Could not read radicalism int for %s\n", culture.name.text);
+												fprintf(stdout, "[read_cultures] Could not read radicalism int for %s\n", string_text(&culture.name));
 												err = ERROR_RETURN;
 											} else culture.radicalism = tmp;
 										} else if (string_equal_c(&arg_l->key.data.str, "primary")) {
 											if (!lexeme_get_country(arg_l, db, &culture.primary)) {
-												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", culture.name.text);
+												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", string_text(&culture.name));
 												err = ERROR_RETURN;
 											}
 										} else if (string_equal_c(&arg_l->key.data.str, "first_names")) {
 											if (!arg_l->compound || buf_len(arg_l->values) < 1) {
-												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", culture.name.text);
+												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", string_text(&culture.name));
 												err = ERROR_RETURN;
 											} else {
+												buf_reserve(culture.first_names, buf_len(culture.first_names) + buf_len(arg_l->values));
 												for_buf(fn, arg_l->values) { // for each first name...
 													struct lexeme_t *first_name_l = arg_l->values[fn];
 													if ((first_name_l->key.type == ALPHANUMERIC || first_name_l->key.type == STRING) && !string_empty(&first_name_l->key.data.str) && !first_name_l->compound)
-														buf_push(culture.first_names, string_make(first_name_l->key.data.str.text));
+														buf_push(culture.first_names, string_make(string_text(&first_name_l->key.data.str)));
 													else {
-														fprintf(stdout, "[read_cultures] Invalid first name (expected alphanumeric or string for %s): ", culture.name.text);
+														fprintf(stdout, "[read_cultures] Invalid first name (expected alphanumeric or string for %s): ", string_text(&culture.name));
 														token_print(stdout, &arg_l->key);
 														fprintf(stdout, "\n");
 														err = ERROR_RETURN;
@@ -793,15 +725,16 @@ int read_cultures(struct database_t *db, const char *filename) {
 											}
 										} else if (string_equal_c(&arg_l->key.data.str, "last_names")) {
 											if (!arg_l->compound || buf_len(arg_l->values) < 1) {
-												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", culture.name.text);
+												fprintf(stdout, "[read_cultures] Could not read primary TAG for %s\n", string_text(&culture.name));
 												err = ERROR_RETURN;
 											} else {
+												buf_reserve(culture.last_names, buf_len(culture.last_names) + buf_len(arg_l->values));
 												for_buf(fn, arg_l->values) { // for each last name...
 													struct lexeme_t *last_name_l = arg_l->values[fn];
 													if ((last_name_l->key.type == ALPHANUMERIC || last_name_l->key.type == STRING) && !string_empty(&last_name_l->key.data.str) && !last_name_l->compound)
-														buf_push(culture.last_names, string_make(last_name_l->key.data.str.text));
+														buf_push(culture.last_names, string_make(string_text(&last_name_l->key.data.str)));
 													else {
-														fprintf(stdout, "[read_cultures] Invalid last name (expected alphanumeric or string for %s): ", culture.name.text);
+														fprintf(stdout, "[read_cultures] Invalid last name (expected alphanumeric or string for %s): ", string_text(&culture.name));
 														token_print(stdout, &arg_l->key);
 														fprintf(stdout, "\n");
 														err = ERROR_RETURN;
@@ -810,22 +743,22 @@ int read_cultures(struct database_t *db, const char *filename) {
 											}
 										} else {
 											fprintf(stdout, "[read_cultures] Unrecognised alphanumeric (expected definition of culture %s): %s.\n",
-												culture.name.text, arg_l->key.data.str.text);
+												string_text(&culture.name), string_text(&arg_l->key.data.str));
 											err = ERROR_RETURN;
 										}
 									} else {
-										fprintf(stdout, "[read_cultures] Invalid token (expected alphanumeric culture specifications for %s): ", culture.name.text);
+										fprintf(stdout, "[read_cultures] Invalid token (expected alphanumeric culture specifications for %s): ", string_text(&culture.name));
 										token_print(stdout, &arg_l->key);
 										fprintf(stdout, "\n");
 										err = ERROR_RETURN;
 									}
 								}
-								database_add_culture(db, &culture);
-								culture_group_add_culture(&group, (struct culture_t *)buf_len(db->cultures));
+								culture.group = database_next_culture_group_ref(db);
+								culture_group_add_culture(&group, database_add_culture(db, &culture));
 							}
 						}
 					} else {
-						fprintf(stdout, "[read_cultures] Invalid token (expected alphanumeric culture definition for %s): ", group.name.text);
+						fprintf(stdout, "[read_cultures] Invalid token (expected alphanumeric culture definition for %s): ", string_text(&group.name));
 						token_print(stdout, &group_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
@@ -843,35 +776,29 @@ int read_cultures(struct database_t *db, const char *filename) {
 
 	lexeme_delete(root_l);
 
-	for_buf(i, db->culture_groups) {
-		struct culture_group_t *group = &db->culture_groups[i];
-		for_buf(j, group->cultures) {
-			group->cultures[j] = &db->cultures[(size_t)group->cultures[j] - 1];
-			group->cultures[j]->group = group;
-		}
-	}
-
 	fprintf(stdout, "[read_cultures] Loaded %zu cultures into %zu culture groups.\n", buf_len(db->cultures), buf_len(db->culture_groups));
 	return err;
 }
 
-int read_single_country_defines(struct database_t *db, struct country_t *country) {
+/* path is scratch space for the file's path, shared by all the countries */
+int read_single_country_defines(struct database_t *db, struct country_t *country, string_builder_t *path) {
 	assert(db && "read_single_country_defines: db == 0");
 	assert(country && "read_single_country_defines: country == 0");
-	string filename = string_make(MOD_FOLDER "common/");
-	string_append(&filename, &country->defines_location);
+	assert(path && "read_single_country_defines: path == 0");
+	builder_clear(path);
+	builder_append_c(path, MOD_FOLDER "common/");
+	builder_append(path, &country->defines_location);
 	struct lexeme_t *root_l = lexeme_new();
-	if (lexer_process_file(filename.text, root_l)) {
-		string_clear(&filename);
+	if (lexer_process_file(builder_text(path), root_l)) {
 		lexeme_delete(root_l);
 		return ERROR_RETURN;
 	}
-	string_clear(&filename);
 	int err = 0;
 	for_buf(i, root_l->values) {	// for each definition...
 		struct lexeme_t *arg_l = root_l->values[i];
 		if (arg_l->key.type == ALPHANUMERIC) {
-			if (string_equal_c(&arg_l->key.data.str, "color")) {
+			switch (keyword_lookup_string(&country_define_keywords, &arg_l->key.data.str)) {
+			case COUNTRY_DEFINE_KEY_color: {
 				u8 col[3] = { 0 };
 				if (lexeme_get_color(arg_l, col))
 					country->color = to_color(col);
@@ -879,22 +806,23 @@ int read_single_country_defines(struct database_t *db, struct country_t *country
 					fprintf(stdout, "[read_single_country_defines] Could not read color for %s\n", country->tag.text);
 					err = ERROR_RETURN;
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "graphical_culture")) {
+			} break;
+			case COUNTRY_DEFINE_KEY_graphical_culture: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_single_country_defines] Could not read graphical_culture alphanumeric for %s\n", country->tag.text);
 					err = ERROR_RETURN;
 				} else {
-					enum graphical_culture_t gc;
-					for (gc = 0; gc < GRAPHICAL_CULTURE_COUNT && !string_equal_c(&tmp, graphical_culture_strings[gc]); ++gc);
-					if (gc == GRAPHICAL_CULTURE_COUNT) {
+					const int gc = keyword_lookup_string(&graphical_culture_keywords, &tmp);
+					if (gc < 0) {
 						fprintf(stdout, "[read_single_country_defines] Unknown graphical culture (unit) type for %s: %s\n",
-							country->tag.text, tmp.text);
+							country->tag.text, string_text(&tmp));
 						err = ERROR_RETURN;
 					} else country->graphical_culture = gc;
 				}
 				string_clear(&tmp);
-			} else if (string_equal_c(&arg_l->key.data.str, "party")) {
+			} break;
+			case COUNTRY_DEFINE_KEY_party: {
 				if (!arg_l->compound) {
 					fprintf(stdout, "[read_single_country_defines] Invalid party lexeme for %s.\n", country->tag.text);
 					err = ERROR_RETURN;
@@ -905,40 +833,46 @@ int read_single_country_defines(struct database_t *db, struct country_t *country
 				for_buf(j, arg_l->values) {
 					struct lexeme_t *party_l = arg_l->values[j];
 					if (party_l->key.type == ALPHANUMERIC) {
-						if (string_equal_c(&party_l->key.data.str, "name")) {
+						switch (keyword_lookup_string(&party_keywords, &party_l->key.data.str)) {
+						case PARTY_KEY_name: {
 							if (!lexeme_get_string(party_l, &party.name)) {
 								fprintf(stdout, "[read_single_country_defines] Could not read party name string for %s\n", country->tag.text);
 								err = ERROR_RETURN;
 							}
 							completion--;
-						} else if (string_equal_c(&party_l->key.data.str, "start_date")) {
+						} break;
+						case PARTY_KEY_start_date: {
 							if (!lexeme_get_date(party_l, &party.start)) {
 								fprintf(stdout, "[read_single_country_defines] Could not read party start date for %s\n", country->tag.text);
 								err = ERROR_RETURN;
 							}
 							completion--;
-						} else if (string_equal_c(&party_l->key.data.str, "end_date")) {
+						} break;
+						case PARTY_KEY_end_date: {
 							if (!lexeme_get_date(party_l, &party.end)) {
 								fprintf(stdout, "[read_single_country_defines] Could not read party end date for %s\n", country->tag.text);
 								err = ERROR_RETURN;
 							}
 							completion--;
-						} else if (string_equal_c(&party_l->key.data.str, "ideology")) {
+						} break;
+						case PARTY_KEY_ideology: {
 							string tmp = { 0 };
 							if (!lexeme_get_alphanumeric(party_l, &tmp)) {
 								fprintf(stdout, "[read_single_country_defines] Could not read ideology alphanumeric for %s\n", country->tag.text);
 								err = ERROR_RETURN;
 							} else {
 								struct ideology_t *i = database_get_ideology(db, &tmp);
-								if (i) party.ideology = i;
+								if (i) party.ideology = database_ideology_ref(db, i);
 								else fprintf(stdout, "[read_single_country_defines] Unknown ideology for %s: %s\n",
-									country->tag.text, tmp.text);
+									country->tag.text, string_text(&tmp));
 							}
 							string_clear(&tmp);
 							completion--;
-						} else if (string_equal_c(&party_l->key.data.str, "social_policy")) {
+						} break;
+						case PARTY_KEY_social_policy: {
 							/* (issue added in HPM, here I just skip over it) */
-						} else {
+						} break;
+						default: {
 							struct issue_group_t *group = database_get_issue_group(db, &party_l->key.data.str);
 							if (group) {
 								string tmp = { 0 };
@@ -948,21 +882,21 @@ int read_single_country_defines(struct database_t *db, struct country_t *country
 								} else {
 									struct issue_t *issue = database_get_issue(db, &tmp);
 									if (issue) {
-										if (issue->group != group) {
-											fprintf(stdout, "[read_single_country_defines] Issue group mismatch: %s is claimed to be in %s, while actually being ", issue->name.text, group->name.text);
-											if (issue->group) fprintf(stdout, "in %s", issue->group->name.text);
+										if (database_issue_group(db, issue->group) != group) {
+											fprintf(stdout, "[read_single_country_defines] Issue group mismatch: %s is claimed to be in %s, while actually being ", string_text(&issue->name), string_text(&group->name));
+											if (issue->group.index) fprintf(stdout, "in %s", string_text(&database_issue_group(db, issue->group)->name));
 											else fprintf(stdout, "empty");
 											fprintf(stdout, "\n");
 											err = ERROR_RETURN;
 										}
 										const size_t index = database_issue_group_index(db, group);
 										if (party.issues == 0) party_issues_init(db, &party);
-										if (party.issues[index]) fprintf(stdout, "[read_single_country_defines] Changing %s policy from %s to %s for %s\n",
-											group->name.text, party.issues[index]->name.text, issue->name.text, party.name.text);
-										party.issues[index] = issue;
+										if (party.issues[index].index) fprintf(stdout, "[read_single_country_defines] Changing %s policy from %s to %s for %s\n",
+											string_text(&group->name), string_text(&database_issue(db, party.issues[index])->name), string_text(&issue->name), string_text(&party.name));
+										party.issues[index] = database_issue_ref(db, issue);
 									} else {
 										fprintf(stdout, "[read_single_country_defines] Unknown issue for %s for %s: %s\n",
-											group->name.text, country->tag.text, tmp.text);
+											string_text(&group->name), country->tag.text, string_text(&tmp));
 										err = ERROR_RETURN;
 									}
 								}
@@ -970,41 +904,45 @@ int read_single_country_defines(struct database_t *db, struct country_t *country
 								completion--;
 							} else {
 								fprintf(stdout, "[read_single_country_defines] Unrecognised alphanumeric in definition of %s party in %s: ",
-									party.name.text, country->tag.text);
+									string_text(&party.name), country->tag.text);
 								token_print(stdout, &party_l->key);
 								fprintf(stdout, "\n");
 								err = ERROR_RETURN;
 							}
+						} break;
 						}
 					} else {
 						fprintf(stdout, "[read_single_country_defines] Invalid token (expected alphanumeric for definition of party %s in %s): ",
-							party.name.text, country->tag.text);
+							string_text(&party.name), country->tag.text);
 						token_print(stdout, &party_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
 					}
 				}
 				if (completion) fprintf(stdout, "[read_single_country_defines] Incomplete party: %s in %s, %d items missing\n",
-					party.name.text, country->tag.text, completion);
+					string_text(&party.name), country->tag.text, completion);
 				country_add_party(country, &party);
-			} else if (string_equal_c(&arg_l->key.data.str, "unit_names")) {
+			} break;
+			case COUNTRY_DEFINE_KEY_unit_names: {
 				// TODO proper unit names reading
-			} else {
+			} break;
+			default: {
 				struct government_type_t *gov = database_get_government_type(db, &arg_l->key.data.str);
 				if (gov) {
 					u8 col[3] = { 0 };
 					if (lexeme_get_color(arg_l, col))
 						fprintf(stdout, "[read_single_country_defines] read unique %s color for %s: %d %d %d\n",
-							gov->name.text, country->tag.text, col[0], col[1], col[2]);
+							string_text(&gov->name), country->tag.text, col[0], col[1], col[2]);
 					else {
-						fprintf(stdout, "[read_single_country_defines] Could not read %s color for %s\n", gov->name.text, country->tag.text);
+						fprintf(stdout, "[read_single_country_defines] Could not read %s color for %s\n", string_text(&gov->name), country->tag.text);
 						err = ERROR_RETURN;
 					}
 				} else {
 					fprintf(stdout, "[read_single_country_defines] Unrecognised alphanumeric (expected definition of %s): %s.\n",
-						country->tag.text, arg_l->key.data.str.text);
+						country->tag.text, string_text(&arg_l->key.data.str));
 					err = ERROR_RETURN;
 				}
+			} break;
 			}
 		} else {
 			fprintf(stdout, "[read_single_country_defines] Invalid token (expected alphanumeric country defines definition): ");
@@ -1021,13 +959,15 @@ int read_single_country_defines(struct database_t *db, struct country_t *country
 int read_country_defines(struct database_t *db) {
 	assert(db && "read_country_defines: db == 0");
 	int err = 0;
+	string_builder_t path = { 0 };
 	for (int i = 0; i < buf_len(db->countries); ++i) {
-		err |= read_single_country_defines(db, &db->countries[i]);
+		err |= read_single_country_defines(db, &db->countries[i], &path);
 		if (err) {
 			fprintf(stdout, "[read_country_defines] Failed to load defines for %s.\n", db->countries[i].tag.text);
 			break;
 		}
 	}
+	builder_free(&path);
 	if (err == 0) fprintf(stdout, "[read_country_defines] Successfully loaded all country defines\n");
 	return err;
 }
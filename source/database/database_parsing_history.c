@@ -1,4 +1,5 @@
 #include "database_parsing.h"
+#include "database_schema.h"
 
 #include "assert_opt.h"
 #include "memory_opt.h"
@@ -24,10 +25,10 @@ int read_province_history(struct database_t *db, const char *filepath, const cha
 	}
 	string tmp = { 0 };
 	string_extract(&tmp, filename, pos);
-	assert(tmp.text && "read_province_history: tmp.text == 0");
-	const int prov_id = atoi(tmp.text);
+	assert(!string_empty(&tmp) && "read_province_history: tmp is empty");
+	const int prov_id = atoi(string_text(&tmp));
 	if (prov_id < 1) {
-		fprintf(stdout, "[read_province_history] province history file invalid province id %s (%d) (for %s)\n", tmp.text, prov_id, filename);
+		fprintf(stdout, "[read_province_history] province history file invalid province id %s (%d) (for %s)\n", string_text(&tmp), prov_id, filename);
 		return ERROR_RETURN;
 	}
 	string_clear(&tmp);
@@ -49,27 +50,41 @@ int read_province_history(struct database_t *db, const char *filepath, const cha
 		lexeme_delete(root_l);
 		return ERROR_RETURN;
 	}
+	char prov_name[16];
+	snprintf(prov_name, sizeof(prov_name), "%d", prov->id);
 	int err = 0;
 	for_buf(i, root_l->values) {	// for each definition...
 		struct lexeme_t *arg_l = root_l->values[i];
 		if (arg_l->key.type == ALPHANUMERIC) {
-			if (string_equal_c(&arg_l->key.data.str, "owner")) {
+			const int key = keyword_lookup_string(&province_history_keywords, &arg_l->key.data.str);
+			if (key < 0) {
+				fprintf(stdout, "[read_province_history] Unrecognised alphanumeric in definition of %d: %s\n",
+					prov->id, string_text(&arg_l->key.data.str));
+				err_break;
+			}
+			if (schema_has_field(&province_history_schema, key)) {
+				if (schema_apply_lexeme(&province_history_schema, prov, key, arg_l, "read_province_history", prov_name)) err = ERROR_RETURN;
+			} else switch (key) {
+			case PROVINCE_HISTORY_KEY_owner: {
 				if (!lexeme_get_country(arg_l, db, &prov->owner)) {
 					fprintf(stdout, "[read_province_history] Could not read owner TAG for province %d\n", prov->id);
 					err = ERROR_RETURN;
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "controller")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_controller: {
 				if (!lexeme_get_country(arg_l, db, &prov->controller)) {
 					fprintf(stdout, "[read_province_history] Could not read controller TAG for province %d\n", prov->id);
 					err = ERROR_RETURN;
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "add_core")) {
-				struct country_t *country = 0;
+			} break;
+			case PROVINCE_HISTORY_KEY_add_core: {
+				struct country_ref_t country = { 0 };
 				if (!lexeme_get_country(arg_l, db, &country)) {
 					fprintf(stdout, "[read_province_history] Could not read add_core TAG for province %d\n", prov->id);
 					err = ERROR_RETURN;
-				} else province_add_core(prov, country);
-			} else if (string_equal_c(&arg_l->key.data.str, "trade_goods")) {
+				} else province_add_core(db, prov, country);
+			} break;
+			case PROVINCE_HISTORY_KEY_trade_goods: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_province_history] Could not read trade_goods alphanumeric for province %d\n", prov->id);
@@ -77,68 +92,40 @@ int read_province_history(struct database_t *db, const char *filepath, const cha
 				} else {
 					struct trade_good_t *good = database_get_trade_good(db, &tmp);
 					if (good) {
-						if (prov->rgo) fprintf(stdout, "[read_province_history] replacing rgo in province %d (%s to %s)\n",
-							prov->id, prov->rgo->name.text, good->name.text);
-						prov->rgo = good;
+						if (prov->rgo.index) fprintf(stdout, "[read_province_history] replacing rgo in province %d (%s to %s)\n",
+							prov->id, string_text(&database_trade_good(db, prov->rgo)->name), string_text(&good->name));
+						prov->rgo = database_trade_good_ref(db, good);
 					} else
 						fprintf(stdout, "[read_province_history] unrecognised rgo for province %d: %s\n",
-							prov->id, tmp.text);
+							prov->id, string_text(&tmp));
 				}
 				string_clear(&tmp);
-			} else if (string_equal_c(&arg_l->key.data.str, "life_rating")) {
-				int tmp = 0;
-				if (!lexeme_get_int(arg_l, &tmp)) {
-					fprintf(stdout, "[read_province_history] Could not read life_rating int for province %d\n", prov->id);
-					err = ERROR_RETURN;
-				} else prov->life_rating = tmp;
-			} else if (string_equal_c(&arg_l->key.data.str, "railroad")) {
-				int tmp = 0;
-				if (!lexeme_get_int(arg_l, &tmp)) {
-					fprintf(stdout, "[read_province_history] Could not read railroad int for province %d\n", prov->id);
-					err = ERROR_RETURN;
-				} else prov->railroad = tmp;
-			} else if (string_equal_c(&arg_l->key.data.str, "naval_base")) {
-				int tmp = 0;
-				if (!lexeme_get_int(arg_l, &tmp)) {
-					fprintf(stdout, "[read_province_history] Could not read naval_base int for province %d\n", prov->id);
-					err = ERROR_RETURN;
-				} else prov->naval_base = tmp;
-			} else if (string_equal_c(&arg_l->key.data.str, "fort")) {
-				int tmp = 0;
-				if (!lexeme_get_int(arg_l, &tmp)) {
-					fprintf(stdout, "[read_province_history] Could not read fort int for province %d\n", prov->id);
-					err = ERROR_RETURN;
-				} else prov->fort = tmp;
-			} else if (string_equal_c(&arg_l->key.data.str, "colonial") || string_equal_c(&arg_l->key.data.str, "colony")) {
-				int tmp = 0;
-				if (!lexeme_get_int(arg_l, &tmp)) {
-					fprintf(stdout, "[read_province_history] Could not read colonial int for province %d\n", prov->id);
-					err = ERROR_RETURN;
-				} else prov->colonial = tmp;
-			} else if (string_equal_c(&arg_l->key.data.str, "set_province_flag")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_set_province_flag: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_province_history] Could not read province flag alphanumeric for province %d\n", prov->id);
 					err = ERROR_RETURN;
 				} else {
-					if (province_has_flag(prov, &tmp)) {
-						fprintf(stdout, "[read_province_history] Repeated province flag %s for province %d\n", tmp.text, prov->id);
+					if (!province_add_flag(db, prov, &tmp)) {
+						fprintf(stdout, "[read_province_history] Repeated province flag %s for province %d\n", string_text(&tmp), prov->id);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
-					} else buf_push(prov->flags, tmp);
+					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "state_building")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_state_building: {
 				// TODO WHAT TO DO WITH BUILDINGS ????
-			} else if (string_equal_c(&arg_l->key.data.str, "party_loyalty")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_party_loyalty: {
 				// TODO WHAT TO DO WITH LOYALTY ????
-			} else if (string_equal_c(&arg_l->key.data.str, "is_slave")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_is_slave: {
 				// TODO WHAT TO DO WITH IS_SLAVE ????
-			} else if (string_equal_c(&arg_l->key.data.str, "terrain")) {
+			} break;
+			case PROVINCE_HISTORY_KEY_terrain: {
 				// TODO WHAT TO DO WITH TERRAIN ????
-			} else {
-				fprintf(stdout, "[read_province_history] Unrecognised alphanumeric in definition of %d: %s\n",
-					prov->id, arg_l->key.data.str.text);
-				err_break;
+			} break;
 			}
 		} else if (arg_l->key.type == DATE_TOKEN) {
 			// TODO proper date block reading
@@ -208,7 +195,11 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 	for_buf(i, root_l->values) {	// for each definition...
 		struct lexeme_t *arg_l = root_l->values[i];
 		if (arg_l->key.type == ALPHANUMERIC) {
-			if (string_equal_c(&arg_l->key.data.str, "capital")) {
+			const int key = keyword_lookup_string(&country_history_keywords, &arg_l->key.data.str);
+			if (schema_has_field(&country_history_schema, key)) {
+				if (schema_apply_lexeme(&country_history_schema, country, key, arg_l, "read_country_history", country->tag.text)) err = ERROR_RETURN;
+			} else switch (key) {
+			case COUNTRY_HISTORY_KEY_capital: {
 				int tmp = 0;
 				if (!lexeme_get_int(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read province ID for capital of %s\n", country->tag.text);
@@ -216,16 +207,17 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 				} else {
 					struct province_t *prov = database_get_province(db, tmp);
 					if (prov) {
-						if (country->capital) fprintf(stdout, "[read_country_history] changing %s's capital from %d to %d\n",
-							country->tag.text, country->capital->id, prov->id);
-						country->capital = prov;
+						if (country->capital.index) fprintf(stdout, "[read_country_history] changing %s's capital from %d to %d\n",
+							country->tag.text, database_province(db, country->capital)->id, prov->id);
+						country->capital = database_province_ref(db, prov);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised province %d for %s's capital\n",
 							prov->id, country->tag.text);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "primary_culture")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_primary_culture: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read alphanumeric for primary culture of %s\n", country->tag.text);
@@ -234,17 +226,18 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					struct culture_t *culture = database_get_culture(db, &tmp);
 					if (culture) {
 						string_clear(&tmp);
-						if (country->primary_culture) fprintf(stdout, "[read_country_history] changing %s's primary culture from %s to %s\n",
-							country->tag.text, country->primary_culture->name.text, culture->name.text);
-						country->primary_culture = culture;
+						if (country->primary_culture.index) fprintf(stdout, "[read_country_history] changing %s's primary culture from %s to %s\n",
+							country->tag.text, string_text(&database_culture(db, country->primary_culture)->name), string_text(&culture->name));
+						country->primary_culture = database_culture_ref(db, culture);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised primary culture %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "culture")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_culture: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read alphanumeric for accepted culture of %s\n", country->tag.text);
@@ -253,17 +246,18 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					struct culture_t *culture = database_get_culture(db, &tmp);
 					if (culture) {
 						string_clear(&tmp);
-						if (country_has_accepted(country, culture)) fprintf(stdout, "[read_country_history] Adding %s as an accepted culture for %s again\n",
-							culture->name.text, country->tag.text);
-						else country_add_accepted_culture(country, culture);
+						if (country_has_accepted(country, database_culture_ref(db, culture))) fprintf(stdout, "[read_country_history] Adding %s as an accepted culture for %s again\n",
+							string_text(&culture->name), country->tag.text);
+						else country_add_accepted_culture(country, database_culture_ref(db, culture));
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised accepted culture %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "religion")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_religion: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read alphanumeric for religion of %s\n", country->tag.text);
@@ -272,17 +266,18 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					struct religion_t *religion = database_get_religion(db, &tmp);
 					if (religion) {
 						string_clear(&tmp);
-						if (country->religion) fprintf(stdout, "[read_country_history] changing %s's religion from %s to %s\n",
-							country->tag.text, country->religion->name.text, religion->name.text);
-						country->religion = religion;
+						if (country->religion.index) fprintf(stdout, "[read_country_history] changing %s's religion from %s to %s\n",
+							country->tag.text, string_text(&database_religion(db, country->religion)->name), string_text(&religion->name));
+						country->religion = database_religion_ref(db, religion);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised religion %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "government")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_government: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read alphanumeric for government type of %s\n", country->tag.text);
@@ -291,22 +286,18 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					struct government_type_t *gov = database_get_government_type(db, &tmp);
 					if (gov) {
 						string_clear(&tmp);
-						if (country->government) fprintf(stdout, "[read_country_history] changing %s's government type from %s to %s\n",
-							country->tag.text, country->government->name.text, gov->name.text);
-						country->government = gov;
+						if (country->government.index) fprintf(stdout, "[read_country_history] changing %s's government type from %s to %s\n",
+							country->tag.text, string_text(&database_government_type(db, country->government)->name), string_text(&gov->name));
+						country->government = database_government_type_ref(db, gov);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised government type %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "plurality")) {
-				if (!lexeme_get_int_or_decimal(arg_l, &country->plurality)) {
-					fprintf(stdout, "[read_country_history] Could not read plurality int or decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "nationalvalue")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_nationalvalue: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read national value alphanumeric for %s\n", country->tag.text);
@@ -315,54 +306,31 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					struct national_value_t *nv = database_get_national_value(db, &tmp);
 					if (nv) {
 						string_clear(&tmp);
-						if (country->nv) fprintf(stdout, "[read_country_history] changing %s's national value from %s to %s\n",
-							country->tag.text, country->nv->name.text, nv->name.text);
-						country->nv = nv;
+						if (country->nv.index) fprintf(stdout, "[read_country_history] changing %s's national value from %s to %s\n",
+							country->tag.text, string_text(&database_national_value(db, country->nv)->name), string_text(&nv->name));
+						country->nv = database_national_value_ref(db, nv);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised national value %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "literacy")) {
-				if (!lexeme_get_decimal(arg_l, &country->literacy)) {
-					fprintf(stdout, "[read_country_history] Could not read literacy decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "non_state_culture_literacy")) {
-				if (!lexeme_get_decimal(arg_l, &country->non_state_culture_literacy)) {
-					fprintf(stdout, "[read_country_history] Could not read non_state_culture_literacy decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "civilized")) {
-				if (!lexeme_get_bool(arg_l, &country->civilized)) {
-					fprintf(stdout, "[read_country_history] Could not read civilized bool for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "is_releasable_vassal")) {
-				if (!lexeme_get_bool(arg_l, &country->is_releasable_vassal)) {
-					fprintf(stdout, "[read_country_history] Could not read is_releasable_vassal bool for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "prestige")) {
-				if (!lexeme_get_int_or_decimal(arg_l, &country->prestige)) {
-					fprintf(stdout, "[read_country_history] Could not read prestige int or decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "set_country_flag")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_set_country_flag: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read country flag alphanumeric for %s\n", country->tag.text);
 					err = ERROR_RETURN;
 				} else {
-					if (country_has_flag(country, &tmp)) {
-						fprintf(stdout, "[read_country_history] Repeated country flag %s for %s\n", tmp.text, country->tag.text);
+					if (!country_add_flag(db, country, &tmp)) {
+						fprintf(stdout, "[read_country_history] Repeated country flag %s for %s\n", string_text(&tmp), country->tag.text);
 						string_clear(&tmp);
 						err = ERROR_RETURN;
-					} else buf_push(country->flags, tmp);
+					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "ruling_party")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_ruling_party: {
 				string tmp = { 0 };
 				if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
 					fprintf(stdout, "[read_country_history] Could not read ruling_party alphanumeric for %s\n", country->tag.text);
@@ -372,15 +340,16 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					if (party) {
 						string_clear(&tmp);
 						if (country->ruling_party) fprintf(stdout, "[read_country_history] changing %s's ruling party from %s to %s\n",
-							country->tag.text, country->ruling_party->name.text, party->name.text);
-						country->ruling_party = party;
+							country->tag.text, string_text(&country_ruling_party(country)->name), string_text(&party->name));
+						country->ruling_party = (u16)(party - country->parties + 1);
 					} else {
 						fprintf(stdout, "[read_country_history] Unrecognised party %s for %s\n",
-							tmp.text, country->tag.text);
+							string_text(&tmp), country->tag.text);
 						err = ERROR_RETURN;
 					}
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "upper_house")) {
+			} break;
+			case COUNTRY_HISTORY_KEY_upper_house: {
 				size_t ideologies_left = buf_len(db->ideologies);
 				for_buf(j, arg_l->values) {
 					struct lexeme_t *ideo_l = arg_l->values[j];
@@ -390,11 +359,11 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 							const size_t idx = database_ideology_index(db, ideo);
 							if (country->upper_house == 0) country_upper_house_init(db, country);
 							if (!lexeme_get_int_or_decimal(ideo_l, &country->upper_house[idx])) {
-								fprintf(stdout, "[read_country_history] Could not read upper house %s count for %s\n", ideo->name.text, country->tag.text);
+								fprintf(stdout, "[read_country_history] Could not read upper house %s count for %s\n", string_text(&ideo->name), country->tag.text);
 								err = ERROR_RETURN;
 							} else ideologies_left--;
 						} else {
-							fprintf(stdout, "[read_country_history] Invalid upper house ideology for %s: %s\n", country->tag.text, ideo_l->key.data.str.text);
+							fprintf(stdout, "[read_country_history] Invalid upper house ideology for %s: %s\n", country->tag.text, string_text(&ideo_l->key.data.str));
 							err = ERROR_RETURN;
 						}
 					} else {
@@ -408,59 +377,41 @@ int read_country_history(struct database_t *db, const char *filepath, const char
 					fprintf(stdout, "[read_country_history] Upper house for %s missing %zu ideologies\n", country->tag.text, ideologies_left);
 					err = ERROR_RETURN;
 				}
-			} else if (string_equal_c(&arg_l->key.data.str, "consciousness")) {
-				if (!lexeme_get_int_or_decimal(arg_l, &country->consciousness)) {
-					fprintf(stdout, "[read_province_history] Could not read consciousness int or decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "nonstate_consciousness")) {
-				if (!lexeme_get_int_or_decimal(arg_l, &country->nonstate_consciousness)) {
-					fprintf(stdout, "[read_province_history] Could not read nonstate_consciousness int or decimal for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "last_election")) {
-				if (!lexeme_get_date(arg_l, &country->last_election)) {
-					fprintf(stdout, "[read_province_history] Could not read last_election date for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else if (string_equal_c(&arg_l->key.data.str, "oob")) {
-				if (!lexeme_get_string(arg_l, &country->oob_location)) {
-					fprintf(stdout, "[read_province_history] Could not read oob string for %s\n", country->tag.text);
-					err = ERROR_RETURN;
-				}
-			} else {
+			} break;
+			default: {
 				struct reform_group_t *rg = database_get_reform_group(db, &arg_l->key.data.str);
 				if (rg) {
 					string tmp = { 0 };
 					if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
-						fprintf(stdout, "[read_province_history] Could not read %s reform for %s\n", rg->name.text, country->tag.text);
+						fprintf(stdout, "[read_province_history] Could not read %s reform for %s\n", string_text(&rg->name), country->tag.text);
 						err = ERROR_RETURN;
 					} else {
 						struct reform_t *ref = database_get_reform(db, &tmp);
 						if (ref) {
 							string_clear(&tmp);
-							if (ref->group != rg) {
+							if (database_reform_group(db, ref->group) != rg) {
 								fprintf(stdout, "[read_country_history] Reform group mismatch in history of %s: %s vs %s\n",
-									country->tag.text, rg->name.text, ref->group ? ref->group->name.text : "NO_GROUP");
+									country->tag.text, string_text(&rg->name), ref->group.index ? string_text(&database_reform_group(db, ref->group)->name) : "NO_GROUP");
 								err = ERROR_RETURN;
 							}
 							const size_t index = database_reform_group_index(db, rg);
 							if (country->reforms == 0) country_reforms_init(db, country);
-							if (country->reforms[index]) fprintf(stdout, "[read_country_history] Changing %s reform from %s to %s for %s\n",
-								rg->name.text, country->reforms[index]->name.text, ref->name.text, country->tag.text);
-							country->reforms[index] = ref;
+							if (country->reforms[index].index) fprintf(stdout, "[read_country_history] Changing %s reform from %s to %s for %s\n",
+								string_text(&rg->name), string_text(&database_reform(db, country->reforms[index])->name), string_text(&ref->name), country->tag.text);
+							country->reforms[index] = database_reform_ref(db, ref);
 						} else {
 							fprintf(stdout, "[read_country_history] Unrecognised reform (in group %s) in history of %s: %s\n",
-								rg->name.text, country->tag.text, arg_l->key.data.str.text);
+								string_text(&rg->name), country->tag.text, string_text(&arg_l->key.data.str));
 							string_clear(&tmp);
 							err = ERROR_RETURN;
 						}
 					}
 				} else {
 					fprintf(stdout, "[read_country_history] Unrecognised alphanumeric in history of %s: %s\n",
-						country->tag.text, arg_l->key.data.str.text);
+						country->tag.text, string_text(&arg_l->key.data.str));
 					err = ERROR_RETURN;
 				}
+			} break;
 			}
 		} else if (arg_l->key.type == DATE_TOKEN) {
 			// TODO proper date block reading
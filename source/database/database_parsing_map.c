@@ -2,46 +2,52 @@
 
 #include "assert_opt.h"
 #include "memory_opt.h"
+#include "token_array.h"
+
+#include <string.h>
 
 /* MAP: province definitions, default.map(sea starts), states, province shapes */
 
 int read_province_defines(struct database_t *db, const char *filename) {
 	assert(db && "read_province_defines: db == 0");
 	assert(filename && "read_province_defines: filename == 0");
-	struct token_source_t src = { 0 };
-	int err = token_source_init(&src, filename);
-	if_err_ret
-	struct token_t token = { 0 };
-	while (token_source_next(&src, &token)) {
-		if (token.type == INT_TOKEN) {
-			if (token.data.i <= 0 || token.data.i >= 1 << 16) {
-				fprintf(stdout, "[read_province_defines] Invalid province id (%d). [line:%zu]\n", token.data.i, src.line_number);
+	token_array_t array = { 0 };
+	int err = token_array_load(&array, filename);
+	if (err) {
+		token_array_free(&array);
+		return err;
+	}
+	/* one province per line at most (the first is the column headers) */
+	if (buf_len(array.tokens)) buf_reserve(db->provinces, buf_len(db->provinces) + buf_back(array.tokens)->line);
+	token_cursor_t cursor;
+	token_cursor_init(&cursor, &array);
+	const compact_token_t *token;
+	while ((token = token_cursor_next(&cursor))) {
+		if (token->type == INT_TOKEN) {
+			if (token->data.i <= 0 || token->data.i >= 1 << 16) {
+				fprintf(stdout, "[read_province_defines] Invalid province id (%d). [line:%u]\n", token->data.i, token->line);
 				err_break;
 			}
-			if (database_get_province(db, token.data.i)) {
-				fprintf(stdout, "[read_province_defines] Duplicate province id (%d). [line:%zu]\n", token.data.i, src.line_number);
+			if (database_get_province(db, token->data.i)) {
+				fprintf(stdout, "[read_province_defines] Duplicate province id (%d). [line:%u]\n", token->data.i, token->line);
 				err_break;
 			}
 			struct province_t province = { 0 };
-			province.id = (u16)token.data.i;
+			province.id = (u16)token->data.i;
 			u8 col[3] = { 0 };
-			if (token_source_get_color(&src, col, true, __func__, "province color")) err_break;
+			if (token_cursor_get_color(&cursor, col, true, __func__, "province color")) err_break;
 			province.color = to_color(col);
 			struct province_t *tmp_province = database_get_province_col(db, province.color);
 			if (tmp_province) {
 				fprintf(stdout, "[read_province_defines] Duplicate province color id %06x for provinces %d and %d. [line:%zu]\n",
-					province.color, tmp_province->id, province.id, src.line_number);
+					province.color, tmp_province->id, province.id, token_cursor_line(&cursor));
 				err_break;
 			}
 			database_add_province(db, &province);
-			token_source_clear_line(&src);
-		} else {
-			token_free(&token);
-			token_source_clear_line(&src);
 		}
+		token_cursor_skip_line(&cursor);
 	}
-	token_free(&token);
-	token_source_free(&src);
+	token_array_free(&array);
 
 	fprintf(stdout, "[read_province_defines] Loaded %zu provinces.\n", buf_len(db->provinces));
 	return err;
@@ -101,7 +107,7 @@ int read_sea_starts(struct database_t *db, const char *filename) {
 			} else if (string_equal_c(&arg_l->key.data.str, "border_cutoff")) {
 				// TODO WHAT TO DO WITH THIS VALUE?
 			} else {
-				fprintf(stdout, "[read_sea_starts] Unknown alphanumeric %s in default.map.\n", arg_l->key.data.str.text);
+				fprintf(stdout, "[read_sea_starts] Unknown alphanumeric %s in default.map.\n", string_text(&arg_l->key.data.str));
 				err = ERROR_RETURN;
 			}
 		} else {
@@ -128,12 +134,13 @@ int read_sea_starts(struct database_t *db, const char *filename) {
 
 void update_province_states(struct database_t *db) {
 	assert(db && "update_province_states: db == 0");
-	assert(db->load_status.map.states && db->load_status.map.province_defines && "[update_province_states] cannot update provinces' state pointers before both are all loaded");
+	assert(db->load_status.map.states && db->load_status.map.province_defines && "[update_province_states] cannot update provinces' states before both are all loaded");
+	const struct state_ref_t none = { 0 };
 	for (int i = 0; i < buf_len(db->provinces); ++i)
-		db->provinces[i].state = 0;
+		db->provinces[i].state = none;
 	for (int i = 0; i < buf_len(db->states); ++i)
-		for (int j = 0; j < buf_len(db->states[i].provinces); ++j)
-			db->states[i].provinces[j]->state = &db->states[i];
+		for_svec(j, db->states[i].provinces)
+			database_province(db, svec_at(db->states[i].provinces, j))->state = database_state_ref(db, &db->states[i]);
 }
 int read_states(struct database_t *db, const char *filename) {
 	assert(db && "read_states: db == 0");
@@ -144,25 +151,27 @@ int read_states(struct database_t *db, const char *filename) {
 		return ERROR_RETURN;
 	}
 	int err = 0;
+	buf_reserve(db->states, buf_len(db->states) + buf_len(root_l->values));
 	for_buf(i, root_l->values) {	// for each state...
 		struct lexeme_t *state_l = root_l->values[i];
 		if (state_l->key.type == ALPHANUMERIC) {
 			if (database_get_state(db, &state_l->key.data.str)) {
-				fprintf(stdout, "[read_states] Duplicate state id (%s).\n", state_l->key.data.str.text);
+				fprintf(stdout, "[read_states] Duplicate state id (%s).\n", string_text(&state_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct state_t new_state = { 0 };
 				string_set(&new_state.name, &state_l->key.data.str);
+				svec_reserve(new_state.provinces, buf_len(state_l->values));
 				for_buf(j, state_l->values) {
 					struct lexeme_t *prov_l = state_l->values[j];
 					if (prov_l->key.type == INT_TOKEN) {
 						struct province_t *prov = database_get_province(db, prov_l->key.data.i);
 						if (prov) {
-							if (state_contains_province(&new_state, prov)) fprintf(stdout, "[read_states] Duplicate province id (%d) in state %s.\n",
-								prov->id, new_state.name.text);
-							else state_add_province(&new_state, prov);
+							if (state_contains_province(&new_state, database_province_ref(db, prov))) fprintf(stdout, "[read_states] Duplicate province id (%d) in state %s.\n",
+								prov->id, string_text(&new_state.name));
+							else state_add_province(&new_state, database_province_ref(db, prov));
 						} else {
-							fprintf(stdout, "[read_states] Invalid province id (%d) for state %s.\n", prov_l->key.data.i, new_state.name.text);
+							fprintf(stdout, "[read_states] Invalid province id (%d) for state %s.\n", prov_l->key.data.i, string_text(&new_state.name));
 							err = ERROR_RETURN;
 						}
 					} else {
@@ -191,24 +200,40 @@ int read_states(struct database_t *db, const char *filename) {
 int read_province_shapes(struct database_t *db, const char *filename) {
 	assert(db && "read_province_shapes: db == 0");
 	assert(filename && "read_province_shapes: filename == 0");
-	int err = RB_load_image_bmp(&db->map.province_col, filename);
+	/* colours are decoded one row at a time straight from the mapped file, only the ids are kept */
+	bmp_file_t bmp;
+	int err = RB_bmp_open(&bmp, filename);
 	if_err_ret
-	db->map.width = db->map.province_col.width;
-	db->map.height = db->map.province_col.height;
-	db->map.size = db->map.province_col.size;
-	RB_alloc_resize_pixels(&db->map.province_id, db->map.width, db->map.height);
-	int left = 0;
-	for (int i = 0; i < db->map.size; ++i) {
-		u32 col = db->map.province_col.pixels[i];
-		if (i >= db->map.width && db->map.province_col.pixels[i - db->map.width] == col)
-			db->map.province_id.pixels[i] = db->map.province_id.pixels[i - db->map.width];
-		else if ((i % db->map.width) != 0 && db->map.province_col.pixels[i - 1] == col)
-			db->map.province_id.pixels[i] = db->map.province_id.pixels[i - 1];
-		else {
-			struct province_t *prov = database_get_province_col(db, col);
-			db->map.province_id.pixels[i] = prov ? prov->id : 0xFF0000;
+	db->map.width = bmp.width;
+	db->map.height = bmp.height;
+	db->map.size = bmp.width * bmp.height;
+	if (RB_alloc_resize_pixels(&db->map.province_id, db->map.width, db->map.height)) {
+		fprintf(stdout, "[read_province_shapes] failed to allocate province id map (%d x %d)\n", db->map.width, db->map.height);
+		RB_bmp_close(&bmp);
+		return ERROR_RETURN;
+	}
+	const scratch_mark_t mark = scratch_mark();
+	u32 *prev_row = scratch_alloc(sizeof(u32) * db->map.width);
+	u32 *row = scratch_alloc(sizeof(u32) * db->map.width);
+	u32 *ids = db->map.province_id.pixels;
+	for (s32 y = 0; y < db->map.height; ++y) {
+		RB_bmp_read_row(&bmp, y, row);
+		for (s32 x = 0; x < db->map.width; ++x) {
+			const u32 col = row[x];
+			if (y > 0 && prev_row[x] == col)
+				ids[x] = ids[x - db->map.width];
+			else if (x > 0 && row[x - 1] == col)
+				ids[x] = ids[x - 1];
+			else {
+				struct province_t *prov = database_get_province_col(db, col);
+				ids[x] = prov ? prov->id : 0xFF0000;
+			}
 		}
+		ids += db->map.width;
+		SWAP(prev_row, row);
 	}
+	scratch_reset(mark);
+	RB_bmp_close(&bmp);
 	return 0;
 }
 
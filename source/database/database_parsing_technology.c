@@ -22,7 +22,7 @@ int read_technology_groups(database_t *db, const char *filename) {
 			} else if (string_equal_c(&token.data.str, "schools") {
 
 			} else {
-				fprintf(stdout, "[read_units] Unrecognised alphanumeric (expected tech folders or schools): %s [line:%zu]\n", token.data.str.text, src.line_number);
+				fprintf(stdout, "[read_units] Unrecognised alphanumeric (expected tech folders or schools): %s [line:%zu]\n", string_text(&token.data.str), src.line_number);
 					err_break;
 			}
 		} else {
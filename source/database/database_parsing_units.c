@@ -1,9 +1,10 @@
 #include "database_parsing.h"
+#include "database_schema.h"
 
 #include "assert_opt.h"
 #include "memory_opt.h"
 
-void read_trade_good_list(struct database_t *db, double **list, struct lexeme_t *lex) {
+void read_trade_good_list(struct database_t *db, decimal_t **list, struct lexeme_t *lex) {
 	assert(db && "read_trade_good_list: db == 0");
 	assert(list && "read_trade_good_list: list == 0");
 	assert(lex && "read_trade_good_list: lex == 0");
@@ -21,11 +22,11 @@ void read_trade_good_list(struct database_t *db, double **list, struct lexeme_t
 		} else {
 			const struct trade_good_t *good = database_get_trade_good(db, &good_l->key.data.str);
 			if (good) {
-				double tmp = 0.0;
+				decimal_t tmp = DECIMAL_ZERO;
 				if (!lexeme_get_int_or_decimal(good_l, &tmp))
-					fprintf(stdout, "[read_trade_good_list] Invalid trade good (%s) amount (must be int or decimal)\n", good->name.text);
+					fprintf(stdout, "[read_trade_good_list] Invalid trade good (%s) amount (must be int or decimal)\n", string_text(&good->name));
 				else add_to_trade_good_list(db, *list, good, tmp, true);
-			} else fprintf(stdout, "[read_trade_good_list] Invalid trade good: %s\n", good_l->key.data.str.text);
+			} else fprintf(stdout, "[read_trade_good_list] Invalid trade good: %s\n", string_text(&good_l->key.data.str));
 		}
 	}
 }
@@ -43,7 +44,7 @@ int read_unit(struct database_t *db, const char *filepath, const char *filename)
 		struct lexeme_t *unit_l = root_l->values[i];
 		if (lexeme_is_named_group(unit_l)) {
 			if (database_get_unit(db, &unit_l->key.data.str)) {
-				fprintf(stdout, "[read_unit] Duplicate unit with name: %s\n", unit_l->key.data.str.text);
+				fprintf(stdout, "[read_unit] Duplicate unit with name: %s\n", string_text(&unit_l->key.data.str));
 				err = ERROR_RETURN;
 			} else {
 				struct unit_t unit = { 0 }; //unit_default();
@@ -51,235 +52,23 @@ int read_unit(struct database_t *db, const char *filepath, const char *filename)
 				for_buf(j, unit_l->values) {	// for each unit arg...
 					struct lexeme_t *arg_l = unit_l->values[j];
 					if (arg_l->key.type == ALPHANUMERIC) {
-						if (string_equal_c(&arg_l->key.data.str, "icon")) {
-							int tmp = 0;
-							if (!lexeme_get_int(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Icon for %s is not an integer\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else unit.icon = tmp;
-						} else if (string_equal_c(&arg_l->key.data.str, "naval_icon")) {
-							int tmp = 0;
-							if (!lexeme_get_int(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Naval icon for %s is not an integer\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else unit.naval_icon = tmp;
-						} else if (string_equal_c(&arg_l->key.data.str, "type")) {
-							string tmp = { 0 };
-							if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Could not read terrain type alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else {
-								enum unit_terrain_type_t tt;
-								for (tt = 0; tt < UNIT_TERRAIN_TYPE_COUNT && !string_equal_c(&tmp, unit_terrain_type_strings[tt]); ++tt);
-								if (tt == UNIT_TERRAIN_TYPE_COUNT) {
-									fprintf(stdout, "[read_unit] Unknown terrain type for %s: %s\n",
-										unit.name.text, tmp.text);
-									err = ERROR_RETURN;
-								} else unit.type = tt;
-							}
-							string_clear(&tmp);
-						} else if (string_equal_c(&arg_l->key.data.str, "unit_type")) {
-							string tmp = { 0 };
-							if (!lexeme_get_alphanumeric(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Could not read unit type alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else {
-								enum unit_type_t ut;
-								for (ut = 0; ut < UNIT_TYPE_COUNT && !string_equal_c(&tmp, unit_type_strings[ut]); ++ut);
-								if (ut == UNIT_TYPE_COUNT) {
-									fprintf(stdout, "[read_unit] Unknown unit type for %s: %s\n",
-										unit.name.text, tmp.text);
-									err = ERROR_RETURN;
-								} else unit.unit_type = ut;
-							}
-							string_clear(&tmp);
-						} else if (string_equal_c(&arg_l->key.data.str, "sprite")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.sprite)) {
-								fprintf(stdout, "[read_unit] Could not read sprite alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "move_sound")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.move_sound)) {
-								fprintf(stdout, "[read_unit] Could not read move_sound alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "select_sound")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.select_sound)) {
-								fprintf(stdout, "[read_unit] Could not read select_sound alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "sprite_override")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.sprite_override)) {
-								fprintf(stdout, "[read_unit] Could not read sprite_override alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "sprite_mount")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.sprite_mount)) {
-								fprintf(stdout, "[read_unit] Could not read sprite_mount alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "sprite_mount_attach_node")) {
-							if (!lexeme_get_alphanumeric(arg_l, &unit.sprite_mount_attach_node)) {
-								fprintf(stdout, "[read_unit] Could not read sprite_mount_attach_node alphanumeric for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "capital")) {
-							if (!lexeme_get_bool(arg_l, &unit.capital)) {
-								fprintf(stdout, "[read_unit] Could not read capital bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "sail")) {
-							if (!lexeme_get_bool(arg_l, &unit.sail)) {
-								fprintf(stdout, "[read_unit] Could not read sail bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "active")) {
-							if (!lexeme_get_bool(arg_l, &unit.active)) {
-								fprintf(stdout, "[read_unit] Could not read active bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "transport")) {
-							if (!lexeme_get_bool(arg_l, &unit.transport)) {
-								fprintf(stdout, "[read_unit] Could not read transport bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "floating_flag")) {
-							if (!lexeme_get_bool(arg_l, &unit.floating_flag)) {
-								fprintf(stdout, "[read_unit] Could not read floating_flag bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "can_build_overseas")) {
-							if (!lexeme_get_bool(arg_l, &unit.can_build_overseas)) {
-								fprintf(stdout, "[read_unit] Could not read can_build_overseas bool for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "colonial_points")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.colonial_points)) {
-								fprintf(stdout, "[read_unit] Could not read colonial points int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "priority")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.priority)) {
-								fprintf(stdout, "[read_unit] Could not read priority int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "max_strength")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.max_strength)) {
-								fprintf(stdout, "[read_unit] Could not read max_strength int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "default_organisation")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.default_organisation)) {
-								fprintf(stdout, "[read_unit] Could not read default_organisation int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "maximum_speed")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.maximum_speed)) {
-								fprintf(stdout, "[read_unit] Could not read maximum_speed int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "weighted_value")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.weighted_value)) {
-								fprintf(stdout, "[read_unit] Could not read weighted_value int or decimal for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "build_time")) {
-							if (!lexeme_get_int(arg_l, &unit.build_time)) {
-								fprintf(stdout, "[read_unit] Could not read build_time int for %s\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "build_cost")) {
+						const int key = keyword_lookup_string(&unit_keywords, &arg_l->key.data.str);
+						if (schema_has_field(&unit_schema, key)) {
+							if (schema_apply_lexeme(&unit_schema, &unit, key, arg_l, "read_unit", string_text(&unit.name))) err = ERROR_RETURN;
+						} else switch (key) {
+						case UNIT_KEY_build_cost: {
 							read_trade_good_list(db, &unit.build_cost, arg_l);
-						} else if (string_equal_c(&arg_l->key.data.str, "min_port_level")) {
-							int tmp = 0;
-							if (!lexeme_get_int(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Minimum port level for %s is not an integer\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else unit.min_port_level = tmp;
-						} else if (string_equal_c(&arg_l->key.data.str, "limit_per_port")) {
-							int tmp = 0;
-							if (!lexeme_get_int(arg_l, &tmp)) {
-								fprintf(stdout, "[read_unit] Limit per port for %s is not an integer\n", unit.name.text);
-								err = ERROR_RETURN;
-							} else unit.limit_per_port = tmp;
-						} else if (string_equal_c(&arg_l->key.data.str, "supply_consumption_score")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.supply_consumption_score)) {
-								fprintf(stdout, "[read_unit] Supply consumption score for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "supply_consumption")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.supply_consumption)) {
-								fprintf(stdout, "[read_unit] Supply consumption for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "supply_cost")) {
+						} break;
+						case UNIT_KEY_supply_cost: {
 							read_trade_good_list(db, &unit.supply_cost, arg_l);
-						} else if (string_equal_c(&arg_l->key.data.str, "reconnaissance")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.reconnaissance)) {
-								fprintf(stdout, "[read_unit] Reconnaissance for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "attack")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.attack)) {
-								fprintf(stdout, "[read_unit] Attack for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "defence")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.defence)) {
-								fprintf(stdout, "[read_unit] Defence for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "discipline")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.discipline)) {
-								fprintf(stdout, "[read_unit] Discipline for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "support")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.support)) {
-								fprintf(stdout, "[read_unit] Support for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "maneuver")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.maneuver)) {
-								fprintf(stdout, "[read_unit] Maneuver for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "siege")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.siege)) {
-								fprintf(stdout, "[read_unit] Siege for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "hull")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.hull)) {
-								fprintf(stdout, "[read_unit] Hull for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "gun_power")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.gun_power)) {
-								fprintf(stdout, "[read_unit] Gun power for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "fire_range")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.fire_range)) {
-								fprintf(stdout, "[read_unit] Fire range for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "evasion")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.evasion)) {
-								fprintf(stdout, "[read_unit] Evasion for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else if (string_equal_c(&arg_l->key.data.str, "torpedo_attack")) {
-							if (!lexeme_get_int_or_decimal(arg_l, &unit.torpedo_attack)) {
-								fprintf(stdout, "[read_unit] Torpedo attack for %s is not an integer or decimal\n", unit.name.text);
-								err = ERROR_RETURN;
-							}
-						} else {
-							fprintf(stdout, "[read_unit] Unrecognised unit specification for %s: %s\n", unit.name.text, arg_l->key.data.str.text);
+						} break;
+						default: {
+							fprintf(stdout, "[read_unit] Unrecognised unit specification for %s: %s\n", string_text(&unit.name), string_text(&arg_l->key.data.str));
 							err = ERROR_RETURN;
+						} break;
 						}
 					} else {
-						fprintf(stdout, "[read_unit] Invalid token (expected alphanumeric unit definition for %s): ", unit.name.text);
+						fprintf(stdout, "[read_unit] Invalid token (expected alphanumeric unit definition for %s): ", string_text(&unit.name));
 						token_print(stdout, &arg_l->key);
 						fprintf(stdout, "\n");
 						err = ERROR_RETURN;
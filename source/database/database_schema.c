@@ -0,0 +1,181 @@
+#include "database_schema.h"
+#include "database_parsing.h"
+
+#include "assert_opt.h"
+
+/* TABLES */
+
+#define TG struct trade_good_t
+internal const field_desc_t trade_good_fields[TRADE_GOOD_KEY_COUNT] = {
+	[TRADE_GOOD_KEY_cost] = FIELD_FLAGS(TG, cost, FIELD_DECIMAL_OR_INT, FIELD_REQUIRED),
+	[TRADE_GOOD_KEY_color] = FIELD_FLAGS(TG, color, FIELD_COLOR, FIELD_REQUIRED),
+	[TRADE_GOOD_KEY_available_from_start] = FIELD(TG, available_from_start, FIELD_BOOL),
+	[TRADE_GOOD_KEY_tradeable] = FIELD(TG, tradeable, FIELD_BOOL),
+	[TRADE_GOOD_KEY_money] = FIELD(TG, money, FIELD_BOOL),
+	[TRADE_GOOD_KEY_overseas_penalty] = FIELD(TG, overseas_penalty, FIELD_BOOL)
+};
+#undef TG
+const schema_t trade_good_schema = { "trade good", &trade_good_keywords, trade_good_fields };
+
+/* build_cost and supply_cost are trade good lists, read_unit reads them itself */
+#define UN struct unit_t
+internal const field_desc_t unit_fields[UNIT_KEY_COUNT] = {
+	[UNIT_KEY_icon] = FIELD(UN, icon, FIELD_INT),
+	[UNIT_KEY_naval_icon] = FIELD(UN, naval_icon, FIELD_INT),
+	[UNIT_KEY_type] = FIELD_KEYWORD_SET(UN, type, &unit_terrain_type_keywords),
+	[UNIT_KEY_unit_type] = FIELD_KEYWORD_SET(UN, unit_type, &unit_type_keywords),
+	[UNIT_KEY_sprite] = FIELD(UN, sprite, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_move_sound] = FIELD(UN, move_sound, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_select_sound] = FIELD(UN, select_sound, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_sprite_override] = FIELD(UN, sprite_override, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_sprite_mount] = FIELD(UN, sprite_mount, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_sprite_mount_attach_node] = FIELD(UN, sprite_mount_attach_node, FIELD_ALPHANUMERIC),
+	[UNIT_KEY_capital] = FIELD(UN, capital, FIELD_BOOL),
+	[UNIT_KEY_sail] = FIELD(UN, sail, FIELD_BOOL),
+	[UNIT_KEY_active] = FIELD(UN, active, FIELD_BOOL),
+	[UNIT_KEY_transport] = FIELD(UN, transport, FIELD_BOOL),
+	[UNIT_KEY_floating_flag] = FIELD(UN, floating_flag, FIELD_BOOL),
+	[UNIT_KEY_can_build_overseas] = FIELD(UN, can_build_overseas, FIELD_BOOL),
+	[UNIT_KEY_colonial_points] = FIELD(UN, colonial_points, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_priority] = FIELD(UN, priority, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_max_strength] = FIELD(UN, max_strength, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_default_organisation] = FIELD(UN, default_organisation, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_maximum_speed] = FIELD(UN, maximum_speed, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_weighted_value] = FIELD(UN, weighted_value, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_build_time] = FIELD(UN, build_time, FIELD_INT),
+	[UNIT_KEY_min_port_level] = FIELD(UN, min_port_level, FIELD_INT),
+	[UNIT_KEY_limit_per_port] = FIELD(UN, limit_per_port, FIELD_INT),
+	[UNIT_KEY_supply_consumption_score] = FIELD(UN, supply_consumption_score, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_supply_consumption] = FIELD(UN, supply_consumption, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_reconnaissance] = FIELD(UN, reconnaissance, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_attack] = FIELD(UN, attack, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_defence] = FIELD(UN, defence, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_discipline] = FIELD(UN, discipline, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_support] = FIELD(UN, support, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_maneuver] = FIELD(UN, maneuver, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_siege] = FIELD(UN, siege, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_hull] = FIELD(UN, hull, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_gun_power] = FIELD(UN, gun_power, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_fire_range] = FIELD(UN, fire_range, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_evasion] = FIELD(UN, evasion, FIELD_DECIMAL_OR_INT),
+	[UNIT_KEY_torpedo_attack] = FIELD(UN, torpedo_attack, FIELD_DECIMAL_OR_INT)
+};
+#undef UN
+const schema_t unit_schema = { "unit", &unit_keywords, unit_fields };
+
+#define PR struct province_t
+internal const field_desc_t province_history_fields[PROVINCE_HISTORY_KEY_COUNT] = {
+	[PROVINCE_HISTORY_KEY_life_rating] = FIELD(PR, life_rating, FIELD_INT),
+	[PROVINCE_HISTORY_KEY_railroad] = FIELD(PR, railroad, FIELD_INT),
+	[PROVINCE_HISTORY_KEY_naval_base] = FIELD(PR, naval_base, FIELD_INT),
+	[PROVINCE_HISTORY_KEY_fort] = FIELD(PR, fort, FIELD_INT),
+	[PROVINCE_HISTORY_KEY_colonial] = FIELD(PR, colonial, FIELD_INT),
+	[PROVINCE_HISTORY_KEY_colony] = FIELD(PR, colonial, FIELD_INT)
+};
+#undef PR
+const schema_t province_history_schema = { "province", &province_history_keywords, province_history_fields };
+
+#define CO struct country_t
+internal const field_desc_t country_history_fields[COUNTRY_HISTORY_KEY_COUNT] = {
+	[COUNTRY_HISTORY_KEY_plurality] = FIELD(CO, plurality, FIELD_DECIMAL_OR_INT),
+	[COUNTRY_HISTORY_KEY_literacy] = FIELD(CO, literacy, FIELD_DECIMAL),
+	[COUNTRY_HISTORY_KEY_non_state_culture_literacy] = FIELD(CO, non_state_culture_literacy, FIELD_DECIMAL),
+	[COUNTRY_HISTORY_KEY_civilized] = FIELD(CO, civilized, FIELD_BOOL),
+	[COUNTRY_HISTORY_KEY_is_releasable_vassal] = FIELD(CO, is_releasable_vassal, FIELD_BOOL),
+	[COUNTRY_HISTORY_KEY_prestige] = FIELD(CO, prestige, FIELD_DECIMAL_OR_INT),
+	[COUNTRY_HISTORY_KEY_consciousness] = FIELD(CO, consciousness, FIELD_DECIMAL_OR_INT),
+	[COUNTRY_HISTORY_KEY_nonstate_consciousness] = FIELD(CO, nonstate_consciousness, FIELD_DECIMAL_OR_INT),
+	[COUNTRY_HISTORY_KEY_last_election] = FIELD(CO, last_election, FIELD_DATE),
+	[COUNTRY_HISTORY_KEY_oob] = FIELD(CO, oob_location, FIELD_STRING)
+};
+#undef CO
+const schema_t country_history_schema = { "country", &country_history_keywords, country_history_fields };
+
+/* READING */
+
+internal const char *field_type_names[FIELD_TYPE_COUNT] = {
+	"none", "int", "decimal", "int or decimal", "bool", "color", "alphanumeric", "string", "date", "alphanumeric"
+};
+
+internal void field_store_int(void *field, u16 size, int i) {
+	switch (size) {
+	case 1: *(u8 *)field = (u8)i; break;
+	case 2: *(u16 *)field = (u16)i; break;
+	default: {
+		assert(size == sizeof(int) && "field_store_int: unsupported int size");
+		*(int *)field = i;
+	} break;
+	}
+}
+
+int schema_apply_lexeme(const schema_t *schema, void *object, int key, struct lexeme_t *arg_l, const char *func_name, const char *object_name) {
+	assert(schema && "schema_apply_lexeme: schema == 0");
+	assert(object && "schema_apply_lexeme: object == 0");
+	assert(arg_l && "schema_apply_lexeme: arg_l == 0");
+	assert(schema_has_field(schema, key) && "schema_apply_lexeme: key has no field");
+	const field_desc_t *desc = &schema->fields[key];
+	void *field = (u8 *)object + desc->offset;
+	boolean ok = false;
+	switch (desc->type) {
+	case FIELD_INT: {
+		int tmp = 0;
+		ok = lexeme_get_int(arg_l, &tmp);
+		if (ok) field_store_int(field, desc->size, tmp);
+	} break;
+	case FIELD_DECIMAL: {
+		ok = lexeme_get_decimal(arg_l, (decimal_t *)field);
+	} break;
+	case FIELD_DECIMAL_OR_INT: {
+		ok = lexeme_get_int_or_decimal(arg_l, (decimal_t *)field);
+	} break;
+	case FIELD_BOOL: {
+		ok = lexeme_get_bool(arg_l, (boolean *)field);
+	} break;
+	case FIELD_COLOR: {
+		u8 col[3] = { 0 };
+		ok = lexeme_get_color(arg_l, col);
+		if (ok) *(u32 *)field = to_color(col);
+	} break;
+	case FIELD_ALPHANUMERIC: {
+		ok = lexeme_get_alphanumeric(arg_l, (string *)field);
+	} break;
+	case FIELD_STRING: {
+		ok = lexeme_get_string(arg_l, (string *)field);
+	} break;
+	case FIELD_DATE: {
+		ok = lexeme_get_date(arg_l, (date_t *)field);
+	} break;
+	case FIELD_KEYWORD: {
+		string tmp = { 0 };
+		ok = lexeme_get_alphanumeric(arg_l, &tmp);
+		if (ok) {
+			const int index = keyword_lookup_string(desc->keywords, &tmp);
+			if (index < 0) {
+				fprintf(stdout, "[%s] Unknown %s for %s %s: %s\n", func_name, schema->keywords->strings[key], schema->name, object_name, string_text(&tmp));
+				string_clear(&tmp);
+				return ERROR_RETURN;
+			}
+			field_store_int(field, desc->size, index);
+		}
+		string_clear(&tmp);
+	} break;
+	}
+	if (!ok) {
+		fprintf(stdout, "[%s] Could not read %s %s for %s %s\n", func_name, schema->keywords->strings[key],
+			field_type_names[desc->type], schema->name, object_name);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+int schema_check_required(const schema_t *schema, u64 seen, const char *func_name, const char *object_name) {
+	assert(schema && "schema_check_required: schema == 0");
+	int missing = 0;
+	for (u32 key = 0; key < schema->keywords->count && key < 64; ++key) {
+		if ((schema->fields[key].flags & FIELD_REQUIRED) && !(seen & ((u64)1 << key))) {
+			fprintf(stdout, "[%s] Missing %s for %s %s\n", func_name, schema->keywords->strings[key], schema->name, object_name);
+			++missing;
+		}
+	}
+	return missing;
+}
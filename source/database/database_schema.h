@@ -0,0 +1,68 @@
+#pragma once
+
+#include "database.h"
+#include "lexer.h"
+#include "database_keys.h"
+
+#include <stddef.h>
+
+/* SCHEMAS
+	A table saying, for each key of a reader's keyword set, what type of value it takes and where in the
+	struct being read it goes, so the simple "key = value" fields are all read by one loop instead of a
+	hand written case each. Anything that needs more than storing the value (looking up a country, adding
+	to a list...) has no entry and stays in the reader's switch. */
+
+enum field_type_t {
+	FIELD_NONE = 0,		/* not in the schema, the reader handles it */
+	FIELD_INT,			/* into an int of the field's size (u8, s8, int...) */
+	FIELD_DECIMAL,
+	FIELD_DECIMAL_OR_INT,	/* into a decimal_t */
+	FIELD_BOOL,
+	FIELD_COLOR,		/* into a u32, see to_color */
+	FIELD_ALPHANUMERIC,	/* into a string */
+	FIELD_STRING,		/* into a string */
+	FIELD_DATE,
+	FIELD_KEYWORD,		/* an alphanumeric from the field's keyword set, its index goes into an int or enum */
+	FIELD_TYPE_COUNT
+};
+
+#define FIELD_REQUIRED 0x1
+
+typedef struct field_desc_s {
+	u8 type;		/* enum field_type_t */
+	u8 flags;
+	u16 size;
+	u32 offset;
+	const keyword_set_t *keywords;	/* FIELD_KEYWORD only */
+} field_desc_t;
+
+#define FIELD(object_type, member, field_type) { .type = (field_type), .size = sizeof(((object_type *)0)->member), .offset = offsetof(object_type, member) }
+#define FIELD_FLAGS(object_type, member, field_type, field_flags) { .type = (field_type), .flags = (field_flags), .size = sizeof(((object_type *)0)->member), .offset = offsetof(object_type, member) }
+#define FIELD_KEYWORD_SET(object_type, member, set) { .type = FIELD_KEYWORD, .size = sizeof(((object_type *)0)->member), .offset = offsetof(object_type, member), .keywords = (set) }
+
+typedef struct schema_s {
+	const char *name;		/* what the object is, for messages */
+	const keyword_set_t *keywords;
+	const field_desc_t *fields;	/* keywords->count of them, indexed by key */
+} schema_t;
+
+extern const schema_t trade_good_schema;
+extern const schema_t unit_schema;
+extern const schema_t province_history_schema;
+extern const schema_t country_history_schema;
+
+/* key is the index from keyword_lookup, so -1 (not a key at all) is fine */
+internal inline boolean schema_has_field(const schema_t *schema, int key) {
+	return key >= 0 && (u32)key < schema->keywords->count && schema->fields[key].type != FIELD_NONE;
+}
+
+/* reads the value of arg_l into the key's field of object, returns 0 if successful
+	object_name is only used in messages */
+int schema_apply_lexeme(const schema_t *schema, void *object, int key, struct lexeme_t *arg_l, const char *func_name, const char *object_name);
+
+/* seen has a bit set for each key read (keys past 63 aren't tracked), prints a message for every FIELD_REQUIRED
+	field without one and returns the number missing */
+int schema_check_required(const schema_t *schema, u64 seen, const char *func_name, const char *object_name);
+internal inline void schema_mark_seen(u64 *seen, int key) {
+	if (key >= 0 && key < 64) *seen |= (u64)1 << key;
+}
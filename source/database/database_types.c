@@ -31,28 +31,28 @@ template_free_named(national_value)
 
 /* TRADE GOODS */
 struct trade_good_t trade_good_default(void) {
-	local const struct trade_good_t ret = { .cost = 1.0, .color = 0xFF0000, .available_from_start = true, .overseas_penalty = false, .money = false, .tradeable = true };
+	local const struct trade_good_t ret = { .cost = DECIMAL_CONST(1.0), .color = 0xFF0000, .available_from_start = true, .overseas_penalty = false, .money = false, .tradeable = true };
 	return ret;
 }
 template_free_named(trade_good)
-double *create_trade_good_list(const struct database_t *db) {
+decimal_t *create_trade_good_list(const struct database_t *db) {
 	assert(db && "create_trade_good_list: db == 0");
 	assert(db->trade_goods && "create_trade_good_list: db->trade_goods == 0");
-	double *ret = calloc_s(buf_len(db->trade_goods) * sizeof(double));
+	decimal_t *ret = calloc_s(buf_len(db->trade_goods) * sizeof(decimal_t));
 	assert(ret && "create_trade_good_list: calloc_s failed");
 	return ret;
 }
-void add_to_trade_good_list(struct database_t *db, double *list, const struct trade_good_t *good, double amount, boolean warn_repeated) {
+void add_to_trade_good_list(struct database_t *db, decimal_t *list, const struct trade_good_t *good, decimal_t amount, boolean warn_repeated) {
 	assert(db && "add_to_trade_good_list: db == 0");
 	assert(list && "add_to_trade_good_list: list == 0");
 	assert(good && "add_to_trade_good_list: good == 0");
-	if (amount == 0.0) {
-		fprintf(stdout, "[add_to_trade_good_list] Adding 0 %s to a trade good list.", good->name.text);
+	if (amount == DECIMAL_ZERO) {
+		fprintf(stdout, "[add_to_trade_good_list] Adding 0 %s to a trade good list.", string_text(&good->name));
 		return;
 	}
 	size_t idx = database_trade_good_index(db, good);
 	assert(0 <= idx && idx < buf_len(list) && "add_to_trade_good_list: good not in database's trade good list");
-	if (warn_repeated && list[idx] != 0.0) fprintf(stdout, "[add_to_trade_good_list] %s repeated in trade good list.", good->name.text);
+	if (warn_repeated && list[idx] != DECIMAL_ZERO) fprintf(stdout, "[add_to_trade_good_list] %s repeated in trade good list.", string_text(&good->name));
 	list[idx] += amount;
 }
 
@@ -92,7 +92,7 @@ void party_issues_init(const struct database_t *db, struct party_t *party) {
 	assert(party && "party_init: party == 0");
 	assert(db->load_status.common.issues && "party_init: issues must be loaded before parties");
 	assert(party->issues == 0 && "party_init: party->issues is already allocated");
-	party->issues = calloc_s(buf_len(db->issue_groups) * sizeof(struct issue_t *));
+	party->issues = calloc_s(buf_len(db->issue_groups) * sizeof(struct issue_ref_t));
 }
 void party_free(struct party_t *party) {
 	assert(party && "party_free: party == 0");
@@ -121,14 +121,14 @@ void country_upper_house_init(const struct database_t *db, struct country_t *cou
 	assert(country && "country_upper_house_init: country == 0");
 	assert(db->load_status.common.ideologies && "country_upper_house_init: ideologies must be loaded before country histories");
 	assert(country->upper_house == 0 && "country_upper_house_init: country->upper_house is already allocated");
-	country->upper_house = calloc_s(buf_len(db->ideologies) * sizeof(double));
+	country->upper_house = calloc_s(buf_len(db->ideologies) * sizeof(decimal_t));
 }
 void country_reforms_init(const struct database_t *db, struct country_t *country) {
 	assert(db && "country_reforms_init: db == 0");
 	assert(country && "country_reforms_init: country == 0");
 	assert(db->load_status.common.issues && "country_reforms_init: reforms must be loaded before country histories");
 	assert(country->reforms == 0 && "country_reforms_init: country->reforms is already allocated");
-	country->reforms = calloc_s(buf_len(db->reform_groups) * sizeof(struct reform_t *));
+	country->reforms = calloc_s(buf_len(db->reform_groups) * sizeof(struct reform_ref_t));
 }
 void country_free(struct country_t *country) {
 	assert(country && "country_free: country == 0");
@@ -137,12 +137,14 @@ void country_free(struct country_t *country) {
 	for_buf(i, country->parties)
 		party_free(&country->parties[i]);
 	buf_free(country->parties);
-	buf_free(country->accepted_cultures);
+	svec_free(country->accepted_cultures);
 	free_s(country->upper_house);
 	free_s(country->reforms);
 	for_buf(i, country->flags)
 		string_clear(&country->flags[i]);
 	buf_free(country->flags);
+	bitset_free(&country->accepted_bits);
+	bitset_free(&country->flag_bits);
 }
 void country_add_party(struct country_t *country, const struct party_t *party) {
 	assert(country && "country_add_party: country == 0");
@@ -157,73 +159,93 @@ struct party_t *country_get_party(struct country_t *country, const string *party
 			return &country->parties[i];
 	return 0;
 }
-void country_add_accepted_culture(struct country_t *country, struct culture_t *culture) {
+struct party_t *country_ruling_party(struct country_t *country) {
+	assert(country && "country_ruling_party: country == 0");
+	return country->ruling_party ? &country->parties[country->ruling_party - 1] : 0;
+}
+void country_add_accepted_culture(struct country_t *country, struct culture_ref_t culture) {
 	assert(country && "country_add_accepted_culture: country == 0");
-	assert(culture && "country_add_accepted_culture: culture == 0");
-	buf_push(country->accepted_cultures, culture);
+	assert(culture.index && "country_add_accepted_culture: no culture");
+	svec_push(country->accepted_cultures, culture);
+	bitset_set(&country->accepted_bits, culture.index - 1);
 }
-boolean country_has_accepted(const struct country_t *country, const struct culture_t *culture) {
+boolean country_has_accepted(const struct country_t *country, struct culture_ref_t culture) {
 	assert(country && "country_has_accepted: country == 0");
-	assert(culture && "country_has_accepted: culture == 0");
-	for_buf(i, country->accepted_cultures)
-		if (country->accepted_cultures[i] == culture) return true;
-	return false;
+	assert(culture.index && "country_has_accepted: no culture");
+	return bitset_contains(country->accepted_bits, culture.index - 1);
+}
+boolean country_add_flag(struct database_t *db, struct country_t *country, string *flag) {
+	assert(country && "country_add_flag: country == 0");
+	assert(flag && "country_add_flag: flag == 0");
+	const int id = database_intern_flag(db, flag);
+	if (bitset_contains(country->flag_bits, id)) return false;
+	bitset_set(&country->flag_bits, id);
+	buf_push(country->flags, string_move(flag));
+	return true;
 }
-boolean country_has_flag(const struct country_t *country, const string *flag) {
+boolean country_has_flag(const struct database_t *db, const struct country_t *country, const string *flag) {
 	assert(country && "country_has_flag: country == 0");
 	assert(flag && "country_has_flag: flag == 0");
-	for_buf(i, country->flags)
-		if (string_equal(&country->flags[i], flag)) return true;
-	return false;
+	const int id = database_flag_id(db, flag);
+	return id >= 0 && bitset_contains(country->flag_bits, id);
 }
 
 /* PROVINCE */
 void province_free(struct province_t *province) {
 	assert(province && "province_free: country == 0");
-	buf_free(province->cores);
+	svec_free(province->cores);
 	for_buf(i, province->flags)
 		string_clear(&province->flags[i]);
 	buf_free(province->flags);
+	bitset_free(&province->core_bits);
+	bitset_free(&province->flag_bits);
 }
-boolean province_has_core(const struct province_t *province, const struct country_t *country) {
+boolean province_has_core(const struct province_t *province, struct country_ref_t country) {
 	assert(province && "province_has_core: province == 0");
-	assert(country && "province_has_core: country == 0");
-	for_buf(i, province->cores)
-		if (province->cores[i] == country) return true;
-	return false;
+	assert(country.index && "province_has_core: no country");
+	return bitset_contains(province->core_bits, country.index - 1);
 }
-void province_add_core(struct province_t *province, struct country_t *country) {
+void province_add_core(struct database_t *db, struct province_t *province, struct country_ref_t country) {
 	assert(province && "province_add_core: province == 0");
-	assert(country && "province_add_core: country == 0");
+	assert(country.index && "province_add_core: no country");
 	if (province_has_core(province, country)) {
-		fprintf(stdout, "[province_add_core] readding %s core to province %d\n", country->tag.text, province->id);
+		fprintf(stdout, "[province_add_core] readding %s core to province %d\n", database_country(db, country)->tag.text, province->id);
 		return;
 	}
-	buf_push(province->cores, country);
+	svec_push(province->cores, country);
+	bitset_set(&province->core_bits, country.index - 1);
 }
-boolean province_has_flag(const struct province_t *province, const string *flag) {
+boolean province_add_flag(struct database_t *db, struct province_t *province, string *flag) {
+	assert(province && "province_add_flag: province == 0");
+	assert(flag && "province_add_flag: flag == 0");
+	const int id = database_intern_flag(db, flag);
+	if (bitset_contains(province->flag_bits, id)) return false;
+	bitset_set(&province->flag_bits, id);
+	buf_push(province->flags, string_move(flag));
+	return true;
+}
+boolean province_has_flag(const struct database_t *db, const struct province_t *province, const string *flag) {
 	assert(province && "province_has_flag: province == 0");
 	assert(flag && "province_has_flag: flag == 0");
-	for_buf(i, province->flags)
-		if (string_equal(&province->flags[i], flag)) return true;
-	return false;
+	const int id = database_flag_id(db, flag);
+	return id >= 0 && bitset_contains(province->flag_bits, id);
 }
 
 #define template_free_named_ref_list(type, list_type, list_name) void type##_free(struct type##_t *type) {\
 														assert(type && #type "_free: " #type " == 0");	\
 														string_clear(&type->name);						\
-														buf_free(type->list_name); }
+														svec_free(type->list_name); }
 
-#define template_list_add_ref(type, list_type, list_name) void type##_add_##list_type(struct type##_t *type, struct list_type##_t *list_type) {	\
+#define template_list_add_ref(type, list_type, list_name) void type##_add_##list_type(struct type##_t *type, struct list_type##_ref_t list_type) {	\
 									assert(type && #type "_add_" #list_type ": " #type " == 0");								\
-									assert(list_type && #type "_add_" #list_type ": " #list_type " == 0");						\
-									buf_push(type->list_name, list_type); }
+									assert(list_type.index && #type "_add_" #list_type ": no " #list_type);						\
+									svec_push(type->list_name, list_type); }
 
-#define template_list_contains_ref(type, list_type, list_name) boolean type##_contains_##list_type(const struct type##_t *type, const struct list_type##_t *list_type) {	\
+#define template_list_contains_ref(type, list_type, list_name) boolean type##_contains_##list_type(const struct type##_t *type, struct list_type##_ref_t list_type) {	\
 																assert(type && #type "_contains_" #list_type ": " #type " == 0");							\
-																assert(list_type && #type "_contains_" #list_type ": " #list_type " == 0");					\
-																for_buf(i, type->list_name)																	\
-																	if (type->list_name[i] == list_type) return true;										\
+																assert(list_type.index && #type "_contains_" #list_type ": no " #list_type);				\
+																for_svec(i, type->list_name)																\
+																	if (svec_at(type->list_name, i).index == list_type.index) return true;					\
 																return false; }
 
 	for_all_database_ref_lists(template_free_named_ref_list)
@@ -0,0 +1,155 @@
+#include "directory.h"
+
+#include "assert_opt.h"
+#include "memory_opt.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* path is the folder being walked with the file's name on the end, starting at name */
+internal void directory_add_entry(directory_entry_t **entries, const string_builder_t *path, size_t name, u64 size) {
+	directory_entry_t entry = { 0 };
+	string_extract(&entry.path, builder_text(path), builder_length(path));
+	entry.name = name;
+	entry.size = size;
+	buf_push(*entries, entry);
+}
+
+/* folder holds the path being walked: each entry's name is appended to it and cut off again, so the walk
+	allocates once per file (its entry's path) rather than building every path from scratch */
+#ifdef _WIN32
+internal int directory_list_recursive(string_builder_t *folder, directory_entry_t **entries) {
+	const size_t folder_length = builder_length(folder);
+	builder_append_c(folder, "/*");
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA(builder_text(folder), &found);
+	builder_truncate(folder, folder_length);
+	if (find == INVALID_HANDLE_VALUE) {
+		fprintf(stdout, "[directory_list_files] Could not open folder: %s\n", builder_text(folder));
+		return ERROR_RETURN;
+	}
+	int err = 0;
+	do {
+		if (found.cFileName[0] == '.') continue;
+		builder_append_c(folder, "/");
+		builder_append_c(folder, found.cFileName);
+		if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			if (directory_list_recursive(folder, entries)) err = ERROR_RETURN;
+		} else directory_add_entry(entries, folder, folder_length + 1, ((u64)found.nFileSizeHigh << 32) | found.nFileSizeLow);
+		builder_truncate(folder, folder_length);
+	} while (FindNextFileA(find, &found));
+	FindClose(find);
+	return err;
+}
+#else
+internal int directory_list_recursive(string_builder_t *folder, directory_entry_t **entries) {
+	DIR *dir = opendir(builder_text(folder));
+	if (!dir) {
+		fprintf(stdout, "[directory_list_files] Could not open folder: %s\n", builder_text(folder));
+		return ERROR_RETURN;
+	}
+	const size_t folder_length = builder_length(folder);
+	int err = 0;
+	struct dirent *found;
+	while ((found = readdir(dir))) {
+		if (found->d_name[0] == '.') continue;
+		builder_append_c(folder, "/");
+		builder_append_c(folder, found->d_name);
+		/* relative to the open folder, so the path isn't looked up again for every entry */
+		struct stat st;
+		if (fstatat(dirfd(dir), found->d_name, &st, 0)) {
+			fprintf(stdout, "[directory_list_files] Could not stat %s\n", builder_text(folder));
+			err = ERROR_RETURN;
+		} else if (S_ISDIR(st.st_mode)) {
+			if (directory_list_recursive(folder, entries)) err = ERROR_RETURN;
+		} else if (S_ISREG(st.st_mode)) directory_add_entry(entries, folder, folder_length + 1, (u64)st.st_size);
+		builder_truncate(folder, folder_length);
+	}
+	closedir(dir);
+	return err;
+}
+#endif
+
+internal int directory_entry_compare(const void *a, const void *b) {
+	return strcmp(string_text(&((const directory_entry_t *)a)->path), string_text(&((const directory_entry_t *)b)->path));
+}
+
+int directory_list_files(const char *base_folder, directory_entry_t **entries) {
+	assert(base_folder && "directory_list_files: base_folder == 0");
+	assert(entries && "directory_list_files: entries == 0");
+	const size_t first = buf_len(*entries);
+	string_builder_t folder = { 0 };
+	builder_append_c(&folder, base_folder);
+	const int err = directory_list_recursive(&folder, entries);
+	builder_free(&folder);
+	if (buf_len(*entries) > first)
+		qsort(*entries + first, buf_len(*entries) - first, sizeof(directory_entry_t), directory_entry_compare);
+	return err;
+}
+
+void directory_list_free(directory_entry_t **entries) {
+	assert(entries && "directory_list_free: entries == 0");
+	for_buf(i, *entries) string_clear(&(*entries)[i].path);
+	buf_free(*entries);
+}
+
+#if defined(_WIN32)
+/* PrefetchVirtualMemory is Windows 8 and later, so it is looked up rather than linked: without it there's no hint */
+typedef struct prefetch_range_s {
+	void *address;
+	SIZE_T size;
+} prefetch_range_t;
+typedef BOOL(WINAPI *prefetch_virtual_memory_t)(HANDLE process, ULONG_PTR count, prefetch_range_t *ranges, ULONG flags);
+
+internal prefetch_virtual_memory_t prefetch_virtual_memory(void) {
+	/* racing calls all look up the same address, func is written before looked_up says it's there */
+	local volatile u32 looked_up = 0;
+	local prefetch_virtual_memory_t func = 0;
+	if (!atomic_load_u32(&looked_up)) {
+		HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+		func = kernel32 ? (prefetch_virtual_memory_t)(void *)GetProcAddress(kernel32, "PrefetchVirtualMemory") : 0;
+		atomic_store_u32(&looked_up, 1);
+	}
+	return func;
+}
+void directory_prefetch(const directory_entry_t *entry) {
+	assert(entry && "directory_prefetch: entry == 0");
+	if (entry->size == 0) return;
+	prefetch_virtual_memory_t prefetch = prefetch_virtual_memory();
+	if (!prefetch) return;
+	platform_file_map_t map;
+	if (platform_map_file(&map, string_text(&entry->path))) return;
+	/* starts the reads and returns, the pages go to the standby list and stay cached after the view is unmapped */
+	prefetch_range_t range = { (void *)map.data, map.size };
+	prefetch(GetCurrentProcess(), 1, &range, 0);
+	platform_unmap_file(&map);
+}
+#else
+void directory_prefetch(const directory_entry_t *entry) {
+	assert(entry && "directory_prefetch: entry == 0");
+	if (entry->size == 0) return;
+	const int fd = open(string_text(&entry->path), O_RDONLY);
+	if (fd < 0) return;
+	/* starts the reads and returns, the pages stay cached after the file is closed */
+	posix_fadvise(fd, 0, (off_t)entry->size, POSIX_FADV_WILLNEED);
+	close(fd);
+}
+#endif
+
+void directory_prefetch_next(const directory_entry_t *entries, size_t count, size_t index) {
+	assert((entries || !count) && "directory_prefetch_next: entries == 0");
+	/* the first call gets the whole window going, later ones top it up by one */
+	const size_t begin = index == 0 ? 0 : index + DIRECTORY_PREFETCH_AHEAD - 1;
+	const size_t end = index + DIRECTORY_PREFETCH_AHEAD < count ? index + DIRECTORY_PREFETCH_AHEAD : count;
+	for (size_t i = begin; i < end; ++i) directory_prefetch(&entries[i]);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "types.h"
+#include "string_wrapper.h"
+
+#include <stddef.h>
+
+/* Lists the files in a folder tree up front, so callers can sort, filter and share them out between threads
+	instead of recursing through the file system as they go. Entries whose names start with '.' (., .. and
+	things like .git) are left out. */
+
+typedef struct directory_entry_s {
+	string path;		/* base_folder/.../name */
+	size_t name;		/* where the file name starts in path */
+	u64 size;
+} directory_entry_t;
+
+internal inline const char *directory_entry_name(const directory_entry_t *entry) {
+	return string_text(&entry->path) + entry->name;
+}
+
+/* appends every file under base_folder (recursively) to entries (a stretchy buffer), sorted by path.
+	Returns 0 if successful, entries must be freed with directory_list_free either way. */
+int directory_list_files(const char *base_folder, directory_entry_t **entries);
+void directory_list_free(directory_entry_t **entries);
+
+/* PREFETCH
+	Asks the OS to start reading files into the page cache ahead of time, so a loader working through a list
+	overlaps its parsing with the disk instead of waiting on every open. Only a hint: it does nothing where it
+	isn't supported and never fails. */
+#define DIRECTORY_PREFETCH_AHEAD 16
+
+void directory_prefetch(const directory_entry_t *entry);
+/* for going through entries in order: call before reading entries[index], it keeps the next
+	DIRECTORY_PREFETCH_AHEAD files on their way in */
+void directory_prefetch_next(const directory_entry_t *entries, size_t count, size_t index);
@@ -0,0 +1,114 @@
+#include "fixed_point.h"
+
+#include "platform.h"
+#include "assert_opt.h"
+
+internal const u64 powers_of_ten[] = {
+	1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+	10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+	1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+	10000000000000000000ull
+};
+
+fixed_t fixed_from_double(double d) {
+	if (d != d) return 0;
+	const double scaled = d * (double)FIXED_ONE;
+	/* 2^63 is exact as a double, anything at or past it doesn't fit */
+	if (scaled >= 9223372036854775807.0) return FIXED_MAX;
+	if (scaled <= -9223372036854775807.0) return FIXED_MIN;
+	return (fixed_t)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+boolean fixed_from_digits(u64 mantissa, u32 fraction_digits, boolean negative, fixed_t *f) {
+	assert(f && "fixed_from_digits: f == 0");
+	u64 value;
+	if (fraction_digits <= FIXED_FRACTION_DIGITS) {
+		const u64 scale = powers_of_ten[FIXED_FRACTION_DIGITS - fraction_digits];
+		if (mantissa > (u64)INT64_MAX / scale) return false;
+		value = mantissa * scale;
+	} else if (fraction_digits - FIXED_FRACTION_DIGITS >= sizeof(powers_of_ten) / sizeof(powers_of_ten[0])) {
+		value = 0; /* mantissa < 2^64 is less than half of 10^20 */
+	} else {
+		const u64 divisor = powers_of_ten[fraction_digits - FIXED_FRACTION_DIGITS];
+		const u64 remainder = mantissa % divisor;
+		value = mantissa / divisor;
+		if (remainder >= divisor - remainder) value++; /* remainder * 2 >= divisor without overflowing */
+	}
+	*f = negative ? -(fixed_t)value : (fixed_t)value;
+	return true;
+}
+
+boolean fixed_parse(const char *text, size_t length, fixed_t *f) {
+	assert((text || !length) && "fixed_parse: text == 0");
+	assert(f && "fixed_parse: f == 0");
+	size_t pos = 0;
+	const boolean negative = length > 0 && text[0] == '-';
+	if (negative) pos++;
+	u64 value = 0;
+	u32 fraction_digits = 0;
+	boolean point = false, round_up = false;
+	for (; pos < length; ++pos) {
+		if (text[pos] == '.') {
+			if (point) return false;
+			point = true;
+		} else if ('0' <= text[pos] && text[pos] <= '9') {
+			/* rounding half away from zero only depends on the first digit past the precision */
+			if (fraction_digits == FIXED_FRACTION_DIGITS) {
+				round_up = text[pos] >= '5';
+				break;
+			}
+			if (value > ((u64)INT64_MAX - 9) / 10) return false;
+			value = value * 10 + (u64)(text[pos] - '0');
+			fraction_digits += point;
+		} else return false;
+	}
+	for (; pos < length; ++pos)
+		if (text[pos] == '.' ? point : (text[pos] < '0' || '9' < text[pos])) return false;
+	if (!fixed_from_digits(value, fraction_digits, negative, f)) return false;
+	if (round_up) {
+		if (*f == FIXED_MAX || *f == FIXED_MIN) return false;
+		*f += negative ? -1 : 1;
+	}
+	return true;
+}
+
+fixed_t fixed_mul(fixed_t a, fixed_t b) {
+#ifdef __SIZEOF_INT128__
+	return (fixed_t)((__int128)a * b / FIXED_ONE);
+#else
+	/* split a so neither product overflows for values up to ~10^8 */
+	return (a / FIXED_ONE) * b + (a % FIXED_ONE) * b / FIXED_ONE;
+#endif
+}
+fixed_t fixed_div(fixed_t a, fixed_t b) {
+	assert(b && "fixed_div: division by zero");
+#ifdef __SIZEOF_INT128__
+	return (fixed_t)((__int128)a * FIXED_ONE / b);
+#else
+	return (a / b) * FIXED_ONE + (a % b) * FIXED_ONE / b;
+#endif
+}
+fixed_t fixed_sum(const fixed_t *values, size_t count) {
+	assert((values || !count) && "fixed_sum: values == 0");
+	fixed_t sum = 0;
+	for (size_t i = 0; i < count; ++i)
+		sum += values[i];
+	return sum;
+}
+
+size_t fixed_sprint(char *const buffer, size_t buffer_count, fixed_t f) {
+	assert(buffer && "fixed_sprint: buffer == 0");
+	/* the magnitude as unsigned, so FIXED_MIN works too */
+	const u64 magnitude = f < 0 ? 0ull - (u64)f : (u64)f;
+	const u64 whole = magnitude / (u64)FIXED_ONE;
+	u64 fraction = magnitude % (u64)FIXED_ONE;
+	if (!fraction)
+		return sprintf_s(buffer, buffer_count, "%s%llu", f < 0 ? "-" : "", (unsigned long long)whole);
+	int digits = FIXED_FRACTION_DIGITS;
+	while (fraction % 10 == 0) {
+		fraction /= 10;
+		digits--;
+	}
+	return sprintf_s(buffer, buffer_count, "%s%llu.%0*llu", f < 0 ? "-" : "", (unsigned long long)whole,
+		digits, (unsigned long long)fraction);
+}
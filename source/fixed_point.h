@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.h"
+
+#include <stddef.h>
+
+/* Fixed point numbers with 5 decimal places, stored as a count of 1/100000ths in 64 bits (about +-92 billion).
+	Script decimals have at most 3-5 fractional digits, so they are held exactly, and sums of them are exact
+	and the same on every platform, unlike doubles. */
+
+typedef s64 fixed_t;
+
+#define FIXED_FRACTION_DIGITS 5
+#define FIXED_ONE ((fixed_t)100000)
+#define FIXED_MAX INT64_MAX
+#define FIXED_MIN INT64_MIN
+/* a fixed_t constant from a decimal literal, rounded to the nearest 1/100000, usable in static initialisers */
+#define FIXED_CONST(x) ((fixed_t)((x) * 100000.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+internal inline fixed_t fixed_from_int(s64 i) { return i * FIXED_ONE; }
+/* rounds to the nearest 1/100000, half away from zero, and saturates at FIXED_MIN/FIXED_MAX */
+fixed_t fixed_from_double(double d);
+internal inline double fixed_to_double(fixed_t f) { return (double)f / (double)FIXED_ONE; }
+/* the integer part, rounded towards zero */
+internal inline s64 fixed_to_int(fixed_t f) { return f / FIXED_ONE; }
+/* from the digits of a decimal literal: mantissa is every digit as one integer, fraction_digits of them came
+	after the point. Extra fractional digits are rounded half away from zero. Returns false on overflow. */
+boolean fixed_from_digits(u64 mantissa, u32 fraction_digits, boolean negative, fixed_t *f);
+/* the same from the text of a decimal literal ("-12.345", any number of digits), returns false if it isn't one or overflows */
+boolean fixed_parse(const char *text, size_t length, fixed_t *f);
+
+/* products and quotients are rounded towards zero */
+fixed_t fixed_mul(fixed_t a, fixed_t b);
+fixed_t fixed_div(fixed_t a, fixed_t b);
+/* exact as long as it doesn't overflow, a plain integer loop the compiler can vectorise */
+fixed_t fixed_sum(const fixed_t *values, size_t count);
+
+/* prints up to 5 decimal places without trailing zeros, e.g. "-1.25" */
+size_t fixed_sprint(char *const buffer, size_t buffer_count, fixed_t f);
+
+/* DECIMAL
+	The type of decimal values in the database, fixed_t when built with DECIMAL_FIXED_POINT (the CMake option
+	of the same name), otherwise double. Code working on database values should only use these helpers. */
+#ifdef DECIMAL_FIXED_POINT
+typedef fixed_t decimal_t;
+#define DECIMAL_CONST(x) FIXED_CONST(x)
+internal inline decimal_t decimal_from_int(s64 i) { return fixed_from_int(i); }
+internal inline decimal_t decimal_from_fixed(fixed_t f) { return f; }
+internal inline decimal_t decimal_from_double(double d) { return fixed_from_double(d); }
+internal inline fixed_t decimal_to_fixed(decimal_t d) { return d; }
+internal inline double decimal_to_double(decimal_t d) { return fixed_to_double(d); }
+#else
+typedef double decimal_t;
+#define DECIMAL_CONST(x) (x)
+internal inline decimal_t decimal_from_int(s64 i) { return (double)i; }
+internal inline decimal_t decimal_from_fixed(fixed_t f) { return fixed_to_double(f); }
+internal inline decimal_t decimal_from_double(double d) { return d; }
+internal inline fixed_t decimal_to_fixed(decimal_t d) { return fixed_from_double(d); }
+internal inline double decimal_to_double(decimal_t d) { return d; }
+#endif
+#define DECIMAL_ZERO DECIMAL_CONST(0.0)
@@ -0,0 +1,664 @@
+#include "types.h"
+
+#include "render.h"
+#include "render_thread.h"
+#include "camera.h"
+#include "pixel_convert.h"
+#include "png_stream.h"
+#include "profiler.h"
+#include "parser.h"
+#include "token_array.h"
+#include "text_scan.h"
+#include "validator.h"
+#include "database.h"
+#include "lexer.h"
+#include "platform.h"
+#include "assert_opt.h"
+#include "memory_opt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Console entry point for running the engine without a window, used for benchmarks and batch jobs.
+	Usage: Vic2Headless <mode> [args...] */
+
+#define BENCH_MAP_DIMS 5616, 2160
+#define BENCH_SCREEN_WIDTH 1280
+#define BENCH_SCREEN_HEIGHT 720
+#define BENCH_DEFAULT_FRAMES 500
+#define BENCH_DEFAULT_TOKENIZER_MB 100
+
+/* fills rb with a patchwork of flat coloured "provinces", roughly the size of the real province map */
+internal int make_synthetic_map(RenderBuffer *rb) {
+	if (RB_resize(rb, BENCH_MAP_DIMS)) return ERROR_RETURN;
+	u32 seed = 0x12345678;
+	for (s32 y = 0; y < rb->height; ++y) {
+		for (s32 x = 0; x < rb->width; ++x) {
+			const u32 cell = (u32)(x / 24) * 7919u + (u32)(y / 18) * 104729u;
+			rb->pixels[x + y * rb->width] = (cell * 2654435761u ^ seed) & 0xFFFFFF;
+		}
+	}
+	return 0;
+}
+
+internal u64 render_map(RenderBuffer *rb, const camera_t *cam, void *user) {
+	const RenderBuffer *map = (const RenderBuffer *)user;
+	RB_clear(rb);
+	vec2 corner = { .x = 0, .y = 0 };
+	vec2 dims = { .x = map->width, .y = map->height };
+	world_to_screen_quad(cam, &corner, &dims);
+	return RB_draw_renderbuffer_sample(rb, corner.x, corner.y, dims.x, dims.y, map);
+}
+
+internal void pan_camera(camera_t *cam, int frame) {
+	cam->pos.x = (float)((frame * 13) % 5616);
+	cam->pos.y = (float)((frame * 7) % 2160);
+}
+
+/* the presenting half of a frame, as winmain.c does it but without the blit. add_sample is false if the
+	caller timed the render itself */
+internal boolean present_frame(render_thread_t *rt, profiler_t *profiler, boolean add_sample) {
+	render_frame_t *frame = render_thread_acquire(rt);
+	if (!frame) return false;
+	if (add_sample) profiler_add(profiler, PROFILE_SAMPLE, frame->render_ticks);
+	profiler_add(profiler, PROFILE_PIXELS, frame->pixels);
+	profiler_draw_overlay(profiler, &frame->rb);
+	render_thread_release(rt);
+	return true;
+}
+
+/* renders frames synchronously, then again with the render thread while this thread plays the presenter */
+internal int mode_render(int argc, char **argv) {
+	const int frame_count = argc > 0 ? atoi(argv[0]) : BENCH_DEFAULT_FRAMES;
+	if (frame_count <= 0) {
+		fprintf(stdout, "[mode_render] Invalid frame count: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	RenderBuffer map = { 0 };
+	if (make_synthetic_map(&map)) {
+		fprintf(stdout, "[mode_render] Failed to allocate synthetic map\n");
+		return ERROR_RETURN;
+	}
+	camera_t cam = { .pos = { .x = 0, .y = 0 }, .zoom = 0.4f, .screen_dims = { .x = BENCH_SCREEN_WIDTH, .y = BENCH_SCREEN_HEIGHT } };
+	render_thread_t rt;
+	if (render_thread_init(&rt, render_map, &map)) {
+		RB_free_pixels(&map);
+		return ERROR_RETURN;
+	}
+
+	profiler_t profiler;
+
+	/* headless: render and present on this thread, the render counts as the sample stage */
+	profiler_init(&profiler);
+	u64 start = platform_ticks();
+	for (int i = 0; i <= frame_count; ++i) {
+		profiler_begin_frame(&profiler);
+		if (i == frame_count) break;
+		pan_camera(&cam, i);
+		render_thread_set_camera(&rt, &cam);
+		profiler_mark(&profiler, PROFILE_TICK);
+		render_thread_render_once(&rt);
+		profiler_mark(&profiler, PROFILE_SAMPLE);
+		present_frame(&rt, &profiler, false);
+		profiler_mark(&profiler, PROFILE_PRESENT);
+	}
+	double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	fprintf(stdout, "[render] sync: %d frames of %dx%d, %.1f fps\n", frame_count,
+		cam.screen_dims.x, cam.screen_dims.y, frame_count / seconds);
+	profiler_print(&profiler, stdout);
+
+	/* threaded: publish a camera every iteration and present whatever has finished */
+	const u64 frames_before = rt.frames_rendered;
+	int presented = 0;
+	if (render_thread_start(&rt) == 0) {
+		profiler_init(&profiler);
+		start = platform_ticks();
+		for (int i = 0; presented < frame_count; ++i) {
+			profiler_begin_frame(&profiler);
+			pan_camera(&cam, i);
+			render_thread_set_camera(&rt, &cam);
+			profiler_mark(&profiler, PROFILE_TICK);
+			while (!present_frame(&rt, &profiler, true))
+				thread_yield();
+			presented++;
+			profiler_mark(&profiler, PROFILE_PRESENT);
+		}
+		profiler_begin_frame(&profiler);
+		seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		render_thread_stop(&rt);
+		fprintf(stdout, "[render] threaded: %d frames presented (%llu rendered), %.1f fps\n", presented,
+			(unsigned long long)(rt.frames_rendered - frames_before), presented / seconds);
+		profiler_print(&profiler, stdout);
+	}
+
+	render_thread_free(&rt);
+	RB_free_pixels(&map);
+	return 0;
+}
+
+internal boolean has_extension(const char *filename, const char *ext) {
+	const size_t len = strlen(filename), ext_len = strlen(ext);
+	return len >= ext_len && !strcmp(filename + len - ext_len, ext);
+}
+
+/* times the image loaders on the given files, or the row converters on synthetic data if there are none */
+internal int mode_image(int argc, char **argv) {
+	fprintf(stdout, "[image] converters: %s, %u threads\n", pixel_convert_isa(), platform_cpu_count());
+	if (argc == 0) {
+		const s32 width = 5616, height = 2160;
+		const size_t count = (size_t)width * height;
+		u8 *src = malloc_s(count * 4);
+		u32 *dest = malloc_s(count * sizeof(u32));
+		for (size_t i = 0; i < count * 4; ++i) src[i] = (u8)(i * 31 + (i >> 12));
+		static const char *format_names[PIXEL_FORMAT_COUNT] = { "bgr24", "abgr32", "rgba32" };
+		for (pixel_format_t format = 0; format < PIXEL_FORMAT_COUNT; ++format) {
+			const ptrdiff_t stride = (ptrdiff_t)width * pixel_format_size(format);
+			pixel_convert_image(format, dest, src, stride, width, height); /* warm up */
+			const int repeats = 10;
+			const u64 start = platform_ticks();
+			for (int i = 0; i < repeats; ++i)
+				pixel_convert_image(format, dest, src + (height - 1) * stride, -stride, width, height);
+			const double seconds = platform_ticks_to_seconds(platform_ticks() - start) / repeats;
+			fprintf(stdout, "[image] %-6s %dx%d: %.3f ms, %.2f GB/s written\n", format_names[format], width, height,
+				1000.0 * seconds, (double)(count * sizeof(u32)) / seconds / 1e9);
+		}
+		free_s(dest);
+		free_s(src);
+		return 0;
+	}
+	int ret = 0;
+	for (int i = 0; i < argc; ++i) {
+		RenderBuffer rb = { 0 };
+		const u64 start = platform_ticks();
+		const int err = has_extension(argv[i], ".png") ? RB_load_image_png(&rb, argv[i]) : RB_load_image_bmp(&rb, argv[i]);
+		const double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		if (err) {
+			ret = ERROR_RETURN;
+			continue;
+		}
+		fprintf(stdout, "[image] %s: %dx%d in %.3f ms\n", argv[i], rb.width, rb.height, 1000.0 * seconds);
+		RB_free_pixels(&rb);
+	}
+	return ret;
+}
+
+/* exports the synthetic map scaled up with the streaming PNG writer */
+internal int mode_export_png(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stdout, "[mode_export_png] Missing output filename\n");
+		return ERROR_RETURN;
+	}
+	const s32 scale = argc > 1 ? atoi(argv[1]) : 4;
+	const u32 threads = argc > 2 ? (u32)atoi(argv[2]) : 0;
+	if (scale <= 0) {
+		fprintf(stdout, "[mode_export_png] Invalid scale: %s\n", argv[1]);
+		return ERROR_RETURN;
+	}
+	RenderBuffer map = { 0 };
+	if (make_synthetic_map(&map)) {
+		fprintf(stdout, "[mode_export_png] Failed to allocate synthetic map\n");
+		return ERROR_RETURN;
+	}
+	const u64 start = platform_ticks();
+	const int err = png_write_renderbuffer_scaled(argv[0], &map, scale, scale, threads);
+	const double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	if (!err) {
+		const double megapixels = (double)map.width * scale * (double)map.height * scale / 1e6;
+		fprintf(stdout, "[export-png] %s: %dx%d (%.1f MP) in %.3f s, %.1f MP/s\n", argv[0], map.width * scale,
+			map.height * scale, megapixels, seconds, megapixels / seconds);
+	}
+	RB_free_pixels(&map);
+	return err;
+}
+
+internal const char *bench_tags[] = { "ENG", "FRA", "PRU", "RUS", "AUS", "USA", "OTT", "SPA" };
+
+/* writes entry i of a synthetic script, returns the number of bytes written or a negative value on error */
+typedef int(*script_entry_func_t)(FILE *fp, u32 i);
+
+/* a province definition with every token type, comments and blank lines */
+internal int write_province_entry(FILE *fp, u32 i) {
+	local const char *goods[] = { "grain", "cattle", "iron", "coal", "wool", "tropical_wood", "silk", "precious_metal" };
+	const char *tag = bench_tags[i % 8], *other = bench_tags[(i * 5 + 3) % 8];
+	return fprintf(fp,
+		"# province %u\n"
+		"%u = {\n"
+		"\towner = %s\n\tcontroller = %s\n\tadd_core = %s\n\tadd_core = %s\n"
+		"\ttrade_goods = %s\n\tlife_rating = %u\n\tcolonial = %u\n"
+		"\tname = \"Province %u\" -- renamed later\n"
+		"\tcolor = { %u %u %u }\n\tweight = %u.%03u\n\tmodifier = -%u.%02u\n"
+		"\t%u.%u.%u = {\n\t\towner = %s\n\t\tfort = %u\n\t\tnaval_base = %u\n\t}\n"
+		"}\n\n",
+		i, i + 1, tag, tag, tag, other, goods[i % 8], 10 + i % 30, i % 3, i, i * 37 % 256, i * 91 % 256, i * 13 % 256,
+		i % 10, i * 7 % 1000, i % 4, i * 11 % 100, 1836 + i % 100, 1 + i % 12, 1 + i % 28, other, i % 7, i % 2);
+}
+/* dated history blocks and pop sizes, mostly dates, ints and decimals */
+internal int write_history_entry(FILE *fp, u32 i) {
+	const char *tag = bench_tags[i % 8], *other = bench_tags[(i * 3 + 1) % 8];
+	return fprintf(fp,
+		"%u.%u.%u = { owner = %s controller = %s add_core = %s }\n"
+		"%u.%u.%u = {\n\tremove_core = %s\n\trevolt_risk = %u.%u\n\tliteracy = 0.%03u\n}\n"
+		"farmers = { culture = british religion = protestant size = %u militancy = %u.%03u }\n"
+		"%u.%u.%u = { prestige = -%u.%02u consciousness = %u.%u }\n",
+		1836 + i % 100, 1 + i % 12, 1 + i % 28, tag, tag, tag,
+		1840 + i % 96, 1 + (i * 7) % 12, 1 + (i * 5) % 28, other, i % 10, i % 10, i * 37 % 1000,
+		1000 + i * 91 % 90000, i % 10, i * 13 % 1000,
+		1850 + i % 86, 1 + (i * 11) % 12, 1 + (i * 3) % 28, i % 50, i * 17 % 100, i % 10, i % 10);
+}
+
+/* writes roughly size bytes of entries */
+internal int write_synthetic_script(const char *filename, size_t size, script_entry_func_t write_entry) {
+	FILE *fp;
+	if (fopen_s(&fp, filename, "w")) {
+		fprintf(stdout, "[write_synthetic_script] Failed to open file: %s\n", filename);
+		return ERROR_RETURN;
+	}
+	size_t written = 0;
+	for (u32 i = 0; written < size; ++i) {
+		const int ret = write_entry(fp, i);
+		if (ret < 0) {
+			fprintf(stdout, "[write_synthetic_script] Failed to write file: %s\n", filename);
+			fclose(fp);
+			return ERROR_RETURN;
+		}
+		written += (size_t)ret;
+	}
+	fclose(fp);
+	return 0;
+}
+
+/* tokenizes filename through token_source, the way the database loader reads files */
+internal int time_token_source(const char *mode_name, const char *filename, int megabytes, u64 *token_count) {
+	struct token_source_t src = { 0 };
+	if (token_source_init(&src, filename)) return ERROR_RETURN;
+	u64 counts[DATE_TOKEN + 1] = { 0 }, total = 0;
+	struct token_t token = { 0 };
+	const u64 start = platform_ticks();
+	while (token_source_next(&src, &token)) {
+		counts[token.type]++;
+		total++;
+	}
+	const double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	const size_t lines = src.line_number;
+	token_free(&token);
+	token_source_free(&src);
+
+	fprintf(stdout, "[%s] %d MB, %zu lines, %llu tokens in %.3f s: %.1f MB/s, %.1f M tokens/s\n", mode_name,
+		megabytes, lines, (unsigned long long)total, seconds, megabytes / seconds, total / seconds / 1e6);
+	fprintf(stdout, "[%s] alphanumeric %llu, symbol %llu, string %llu, int %llu, decimal %llu, date %llu, unknown %llu\n", mode_name,
+		(unsigned long long)counts[ALPHANUMERIC], (unsigned long long)counts[SYMBOL], (unsigned long long)counts[STRING],
+		(unsigned long long)counts[INT_TOKEN], (unsigned long long)counts[DECIMAL_TOKEN], (unsigned long long)counts[DATE_TOKEN],
+		(unsigned long long)counts[UNKNOWN]);
+	*token_count = total;
+	return 0;
+}
+
+/* tokenizes filename into a token_array_t, on this thread then on a worker, and walks it with a cursor */
+internal int time_token_array(const char *mode_name, const char *filename, int megabytes, u64 expected_count) {
+	token_array_t array;
+	u64 start = platform_ticks();
+	if (token_array_load(&array, filename)) {
+		token_array_free(&array);
+		return ERROR_RETURN;
+	}
+	const double load_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	u64 counts[DATE_TOKEN + 1] = { 0 }, total = 0;
+	token_cursor_t cursor;
+	token_cursor_init(&cursor, &array);
+	start = platform_ticks();
+	const compact_token_t *token;
+	while ((token = token_cursor_next(&cursor))) {
+		counts[token->type]++;
+		total++;
+	}
+	const double walk_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	token_array_free(&array);
+
+	start = platform_ticks();
+	int ret = token_array_load_async(&array, filename);
+	const double launch_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	if (!ret) ret = token_array_wait(&array);
+	const double async_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	const size_t async_count = buf_len(array.tokens);
+	token_array_free(&array);
+	if (ret) return ret;
+
+	fprintf(stdout, "[%s] token array: %llu tokens (%zu bytes each) built in %.3f s: %.1f MB/s, walked in %.3f s: %.1f M tokens/s\n",
+		mode_name, (unsigned long long)total, sizeof(compact_token_t), load_seconds, megabytes / load_seconds,
+		walk_seconds, total / walk_seconds / 1e6);
+	fprintf(stdout, "[%s] token array on a worker thread: %.3f ms to start, %.3f s until ready\n",
+		mode_name, launch_seconds * 1000.0, async_seconds);
+	if (total != expected_count || async_count != expected_count) {
+		fprintf(stdout, "[%s] Token array has %llu/%zu tokens, token_source found %llu\n", mode_name,
+			(unsigned long long)total, async_count, (unsigned long long)expected_count);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+/* a NUL (or any byte no token starts with) has to be stepped over, not scanned forever: the scanners should
+	find the 6 tokens around it, and the strict one the NUL too */
+internal int check_unreadable_bytes(void) {
+	local const char text[] = "a = 1\0\nb = 2\n";
+	const size_t size = sizeof(text) - 1;
+	int counts[2] = { 0 };
+	for (int strict = 0; strict < 2; ++strict) {
+		size_t pos = 0, line_number = 1;
+		struct token_view_t view;
+		while ((strict ? token_scan_next_strict : token_scan_next)(text, size, &pos, &line_number, &view))
+			if (++counts[strict] > (int)size) break;
+	}
+	if (counts[0] != 6 || counts[1] != 7) {
+		fprintf(stdout, "[check_unreadable_bytes] Scanned %d tokens (strict: %d) around a NUL, expected 6 (7)\n", counts[0], counts[1]);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+/* the bytes of a file that can't be tokenized are shown escaped, so a log of them stays text */
+internal int check_escaped_bytes(void) {
+	local const char text[] = "a\0b\tc\x7F";
+	string_builder_t escaped = { 0 };
+	builder_append_escaped(&escaped, text, sizeof(text) - 1);
+	const boolean same = !strcmp(builder_text(&escaped), "a\\x00b\tc\\x7F");
+	if (!same) fprintf(stdout, "[check_escaped_bytes] Escaped to \"%s\", expected \"a\\x00b\\tc\\x7F\"\n", builder_text(&escaped));
+	builder_free(&escaped);
+	return same ? 0 : ERROR_RETURN;
+}
+
+/* edge cases of the tokenizer that the benchmarks don't exercise */
+internal int mode_self_check(int argc, char **argv) {
+	(void)argc; (void)argv;
+	int ret = 0;
+	if (check_unreadable_bytes()) ret = ERROR_RETURN;
+	if (check_escaped_bytes()) ret = ERROR_RETURN;
+	fprintf(stdout, "[self-check] %s\n", ret ? "Failed" : "Passed");
+	return ret;
+}
+
+/* tokenizes a synthetic script file, after timing the raw scanners over it */
+internal int mode_bench_tokenizer(int argc, char **argv) {
+	const int megabytes = argc > 0 ? atoi(argv[0]) : BENCH_DEFAULT_TOKENIZER_MB;
+	const char *filename = argc > 1 ? argv[1] : "bench_tokenizer.txt";
+	if (megabytes <= 0) {
+		fprintf(stdout, "[mode_bench_tokenizer] Invalid size: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	if (write_synthetic_script(filename, (size_t)megabytes << 20, write_province_entry)) return ERROR_RETURN;
+
+	/* the raw scanners over the whole file in memory: every token boundary, then every line end */
+	platform_file_map_t map;
+	if (platform_map_file(&map, filename) == 0) {
+		const char *text = (const char *)map.data;
+		u64 spans = 0, lines = 0;
+		u64 start = platform_ticks();
+		for (size_t pos = 0; pos < map.size; ++pos, ++spans)
+			pos += scan_token_end(text + pos, map.size - pos);
+		const double token_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		start = platform_ticks();
+		for (size_t pos = 0; pos < map.size; ++pos, ++lines)
+			pos += scan_line_end(text + pos, map.size - pos);
+		const double line_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		fprintf(stdout, "[bench-tokenizer] %s scan: token ends %.2f GB/s (%llu), line ends %.2f GB/s (%llu)\n",
+			text_scan_isa(), map.size / token_seconds / 1e9, (unsigned long long)spans,
+			map.size / line_seconds / 1e9, (unsigned long long)lines);
+		/* the whole buffer path: every block's token end mask, then the same token ends by going through their set bits */
+		u32 *end_masks = malloc_s(scan_mask_count(map.size) * sizeof(u32));
+		start = platform_ticks();
+		scan_token_end_masks(text, map.size, end_masks);
+		const double mask_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		u64 masked_spans = 0;
+		start = platform_ticks();
+		for (size_t k = 0; k < scan_mask_count(map.size); ++k)
+			for (u32 mask = end_masks[k]; mask && k * SCAN_MASK_BYTES + scan_lowest_set_bit(mask) < map.size; mask &= mask - 1)
+				masked_spans++;
+		const double walk_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		free_s(end_masks);
+		fprintf(stdout, "[bench-tokenizer] %s masks: classified %.2f GB/s, token ends from them %.2f GB/s (%llu), both %.2f GB/s\n",
+			text_scan_isa(), map.size / mask_seconds / 1e9, map.size / walk_seconds / 1e9, (unsigned long long)masked_spans,
+			map.size / (mask_seconds + walk_seconds) / 1e9);
+		if (masked_spans != spans) {
+			fprintf(stdout, "[bench-tokenizer] Token ends from masks (%llu) don't match the scanner's (%llu)\n", (unsigned long long)masked_spans, (unsigned long long)spans);
+			platform_unmap_file(&map);
+			remove(filename);
+			return ERROR_RETURN;
+		}
+		platform_unmap_file(&map);
+	}
+
+	u64 token_count = 0;
+	int ret = time_token_source("bench-tokenizer", filename, megabytes, &token_count);
+	if (!ret) ret = time_token_array("bench-tokenizer", filename, megabytes, token_count);
+	remove(filename);
+	return ret;
+}
+
+/* tokenizes a synthetic history file, where most tokens are dates and numbers */
+internal int mode_bench_history(int argc, char **argv) {
+	const int megabytes = argc > 0 ? atoi(argv[0]) : BENCH_DEFAULT_TOKENIZER_MB;
+	const char *filename = argc > 1 ? argv[1] : "bench_history.txt";
+	if (megabytes <= 0) {
+		fprintf(stdout, "[mode_bench_history] Invalid size: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	if (write_synthetic_script(filename, (size_t)megabytes << 20, write_history_entry)) return ERROR_RETURN;
+	u64 token_count = 0;
+	const int ret = time_token_source("bench-history", filename, megabytes, &token_count);
+	remove(filename);
+	return ret;
+}
+
+/* the size of every block the lexeme tree under lex holds, in the order they were allocated in */
+internal void collect_lexeme_sizes(const struct lexeme_t *lex, u32 **sizes) {
+	buf_push(*sizes, (u32)sizeof(struct lexeme_t));
+	if ((lex->key.type == ALPHANUMERIC || lex->key.type == STRING) && string_on_heap(&lex->key.data.str))
+		buf_push(*sizes, (u32)string_length(&lex->key.data.str) + 1);
+	if (lex->values) buf_push(*sizes, (u32)(offsetof(buffer_t, buf) + buf_cap(lex->values) * sizeof(lex->values[0])));
+	for_buf(i, lex->values) collect_lexeme_sizes(lex->values[i], sizes);
+}
+
+/* allocates every size, then frees them all in the same order, like building then deleting a lexeme tree */
+internal void time_allocator(const char *allocator, const u32 *sizes, void **blocks, boolean pool) {
+	u64 start = platform_ticks();
+	for_buf(i, sizes) blocks[i] = pool ? pool_alloc(sizes[i]) : malloc_s(sizes[i]);
+	const double alloc_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	start = platform_ticks();
+	for_buf(i, sizes) {
+		if (pool) pool_free(blocks[i], sizes[i]);
+		else free_s(blocks[i]);
+	}
+	const double free_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	fprintf(stdout, "[bench-alloc] %-6s allocator: %zu blocks allocated in %.3f s, freed in %.3f s\n", allocator, buf_len(sizes), alloc_seconds, free_seconds);
+}
+
+/* lexes a synthetic script file, then replays the allocations its lexeme tree made with malloc and with the pool,
+	so the two are compared on the same mix of sizes without the rest of the lexer's work in the times */
+internal int mode_bench_alloc(int argc, char **argv) {
+	const int megabytes = argc > 0 ? atoi(argv[0]) : BENCH_DEFAULT_TOKENIZER_MB;
+	const char *filename = argc > 1 ? argv[1] : "bench_alloc.txt";
+	if (megabytes <= 0) {
+		fprintf(stdout, "[mode_bench_alloc] Invalid size: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	if (write_synthetic_script(filename, (size_t)megabytes << 20, write_province_entry)) return ERROR_RETURN;
+	struct lexeme_t *root = lexeme_new();
+	u64 start = platform_ticks();
+	const int ret = lexer_process_file(filename, root);
+	const double parse_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	remove(filename);
+	u32 *sizes = 0;
+	if (!ret) collect_lexeme_sizes(root, &sizes);
+	start = platform_ticks();
+	lexeme_delete(root);
+	const double free_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	if (ret) return ret;
+	fprintf(stdout, "[bench-alloc] lexed in %.3f s (%.1f MB/s), freed in %.3f s\n", parse_seconds, megabytes / parse_seconds, free_seconds);
+	void **blocks = malloc_s(buf_len(sizes) * sizeof(void *));
+	/* twice each, the second pool run reuses the slabs of the first */
+	for (int i = 0; i < 2; ++i) time_allocator("malloc", sizes, blocks, false);
+	for (int i = 0; i < 2; ++i) time_allocator("pool", sizes, blocks, true);
+	free_s(blocks);
+	buf_free(sizes);
+	return 0;
+}
+
+/* the temporaries of drawing a triangle or a map mode: a couple of buffers of a few hundred bytes to a few
+	kilobytes, written and read once then thrown away */
+#define BENCH_SCRATCH_MAX_BYTES 8192
+internal u64 scratch_pattern(boolean use_scratch, int count) {
+	u32 seed = 1;
+	u64 checksum = 0;
+	for (int i = 0; i < count; ++i) {
+		seed = seed * 1664525u + 1013904223u;
+		const size_t size_a = 64 + (seed >> 8) % BENCH_SCRATCH_MAX_BYTES, size_b = 64 + (seed >> 4) % (BENCH_SCRATCH_MAX_BYTES / 4);
+		const scratch_mark_t mark = scratch_mark();
+		u8 *a = use_scratch ? scratch_alloc(size_a) : malloc_s(size_a);
+		u8 *b = use_scratch ? scratch_alloc(size_b) : malloc_s(size_b);
+		memset(a, (int)i, size_a);
+		memset(b, (int)seed, size_b);
+		checksum += a[size_a - 1] + b[size_b / 2];
+		if (use_scratch) scratch_reset(mark);
+		else {
+			free_s(b);
+			free_s(a);
+		}
+	}
+	return checksum;
+}
+internal int mode_bench_scratch(int argc, char **argv) {
+	const int count = argc > 0 ? atoi(argv[0]) : 1000000;
+	if (count <= 0) {
+		fprintf(stdout, "[mode_bench_scratch] Invalid count: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	u64 checksums[2];
+	for (int s = 0; s < 2; ++s) {
+		const u64 start = platform_ticks();
+		checksums[s] = scratch_pattern(s == 1, count);
+		const double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		fprintf(stdout, "[bench-scratch] %-7s %d pairs of temporaries in %.3f s: %.1f ns per pair\n",
+			s ? "scratch" : "malloc", count, seconds, 1e9 * seconds / count);
+	}
+	scratch_release();
+	if (checksums[0] != checksums[1]) {
+		fprintf(stdout, "[mode_bench_scratch] Checksums differ\n");
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+/* syntax checks every script file in a mod folder */
+internal int mode_validate(int argc, char **argv) {
+	if (argc < 1) {
+		fprintf(stdout, "[mode_validate] Missing mod folder\n");
+		return ERROR_RETURN;
+	}
+	const int threads = argc > 1 ? atoi(argv[1]) : 0;
+	if (threads < 0) {
+		fprintf(stdout, "[mode_validate] Invalid thread count: %s\n", argv[1]);
+		return ERROR_RETURN;
+	}
+	validate_stats_t stats;
+	const int ret = validate_folder(argv[0], (u32)threads, &stats);
+	const double megabytes = stats.bytes / (1024.0 * 1024.0);
+	fprintf(stdout, "[validate] %u files (%u failed, %u skipped), %.1f MB, %llu tokens: listed in %.3f s, checked in %.3f s on %u threads",
+		stats.files, stats.failed, stats.skipped, megabytes, (unsigned long long)stats.tokens, stats.list_seconds, stats.check_seconds, stats.threads);
+	if (stats.files && stats.check_seconds > 0) fprintf(stdout, ": %.0f files/s, %.1f MB/s", stats.files / stats.check_seconds, megabytes / stats.check_seconds);
+	fprintf(stdout, "\n");
+	return ret;
+}
+
+/* loads the database from MOD_FOLDER, the same way the window does on startup */
+internal int mode_load(int argc, char **argv) {
+	(void)argc; (void)argv;
+	struct database_t db = { 0 };
+	const u64 start = platform_ticks();
+	const int ret = database_load_all(&db);
+	const double seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	fprintf(stdout, "[load] %s %s in %.3f s:\n", ret ? "Failed to load" : "Loaded", MOD_FOLDER, seconds);
+#define template_list_count(type, plural) if (buf_len(db.plural)) fprintf(stdout, "\t%zu " #plural "\n", buf_len(db.plural));
+	for_all_database_lists(template_list_count)
+#undef template_list_count
+	database_memory_report(stdout, &db);
+	memory_profile_report(stdout, 20);
+	database_free_all(&db);
+	return ret;
+}
+
+internal int mode_mapmode(int argc, char **argv) {
+	const int repeats = argc > 0 ? atoi(argv[0]) : 10;
+	if (repeats <= 0) {
+		fprintf(stdout, "[mode_mapmode] Invalid repeat count: %s\n", argv[0]);
+		return ERROR_RETURN;
+	}
+	struct database_t db = { 0 };
+	int ret = database_load_all(&db);
+	if (ret || !db.map.size) {
+		fprintf(stdout, "[mode_mapmode] Failed to load %s\n", MOD_FOLDER);
+		database_free_all(&db);
+		return ERROR_RETURN;
+	}
+	const struct { const char *name; map_mode_t callback; map_palette_t palette; } map_modes[] = {
+		{ "owner", map_mode_owner, map_palette_owner },
+		{ "rgo", map_mode_rgo, map_palette_rgo },
+		{ "state", map_mode_state, map_palette_state },
+	};
+	RenderBuffer by_callback = { 0 }, by_palette = { 0 };
+	fprintf(stdout, "[mapmode] %d x %d map, %zu provinces, %d repeats:\n", db.map.width, db.map.height, buf_len(db.provinces), repeats);
+	for (size_t m = 0; m < sizeof(map_modes) / sizeof(map_modes[0]); ++m) {
+		u64 start = platform_ticks();
+		for (int i = 0; i < repeats; ++i) database_apply_mapmode(&db, &by_callback, map_modes[m].callback);
+		const double callback_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		start = platform_ticks();
+		for (int i = 0; i < repeats; ++i) database_apply_palette(&db, &by_palette, map_modes[m].palette);
+		const double palette_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+		const boolean same = !memcmp(by_callback.pixels, by_palette.pixels, by_callback.size * sizeof(u32));
+		fprintf(stdout, "\t%-6s callback %.2f ms, palette %.2f ms (%.1fx)%s\n", map_modes[m].name,
+			1000.0 * callback_seconds / repeats, 1000.0 * palette_seconds / repeats,
+			palette_seconds > 0.0 ? callback_seconds / palette_seconds : 0.0, same ? "" : ", pixels differ!");
+		if (!same) ret = ERROR_RETURN;
+	}
+	RB_free_pixels(&by_callback);
+	RB_free_pixels(&by_palette);
+	database_free_all(&db);
+	return ret;
+}
+
+typedef int(*headless_mode_func_t)(int argc, char **argv);
+typedef struct headless_mode_s {
+	const char *name;
+	headless_mode_func_t func;
+	const char *usage;
+} headless_mode_t;
+
+internal const headless_mode_t modes[] = {
+	{ "render", mode_render, "render [frames]: time map rendering, with and without the render thread" },
+	{ "export-png", mode_export_png, "export-png <file> [scale] [threads]: write the synthetic map scaled up with the streaming PNG encoder" },
+	{ "bench-tokenizer", mode_bench_tokenizer, "bench-tokenizer [MB] [file]: tokenize a synthetic script file of the given size (written to file, then deleted)" },
+	{ "bench-history", mode_bench_history, "bench-history [MB] [file]: tokenize a synthetic, date heavy history file of the given size" },
+	{ "bench-alloc", mode_bench_alloc, "bench-alloc [MB] [file]: lex a synthetic script file, then time the allocations of its lexeme tree with malloc and with the pool allocator" },
+	{ "bench-scratch", mode_bench_scratch, "bench-scratch [count]: allocate and throw away short lived buffers with malloc, then with the scratch arena" },
+	{ "self-check", mode_self_check, "self-check: run the tokenizer edge case checks, exits with failure if any fails" },
+	{ "validate", mode_validate, "validate <mod folder> [threads]: syntax check every script file in the folder, exits with failure if any file has errors" },
+	{ "load", mode_load, "load: load the database from the MOD_FOLDER set when configuring, and time it" },
+	{ "mapmode", mode_mapmode, "mapmode [repeats]: load the database, then time drawing each map mode province by province and from a palette" },
+	{ "image", mode_image, "image [files...]: time loading .bmp/.png files, or pixel conversion if no files are given" },
+};
+
+int main(int argc, char **argv) {
+	if (argc >= 2) {
+		for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+			if (!strcmp(argv[1], modes[i].name)) {
+				const int ret = modes[i].func(argc - 2, argv + 2);
+				check_memory_leaks();
+				return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+			}
+		}
+		fprintf(stdout, "Unknown mode: %s\n", argv[1]);
+	}
+	fprintf(stdout, "Usage: %s <mode> [args...]\nModes:\n", argc ? argv[0] : "Vic2Headless");
+	for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i)
+		fprintf(stdout, "\t%s\n", modes[i].usage);
+	return EXIT_FAILURE;
+}
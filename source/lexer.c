@@ -3,8 +3,9 @@
 #include "assert_opt.h"
 #include "memory_opt.h"
 #include "parser.h"
+#include "directory.h"
 
-#include <windows.h>
+#include <string.h>
 
 boolean token_is_data(const struct token_t *token) {
 	return token->type == ALPHANUMERIC || token->type == STRING || token->type == INT_TOKEN || token->type == DECIMAL_TOKEN || token->type == DATE_TOKEN;
@@ -46,9 +47,9 @@ struct lexeme_t *lexeme_new_int(int i, boolean compound) {
 	ret->compound = compound;
 	return ret;
 }
-struct lexeme_t *lexeme_new_decimal(double d, boolean compound) {
+struct lexeme_t *lexeme_new_decimal(decimal_t d, boolean compound) {
 	struct lexeme_t *ret = lexeme_new();
-	token_init_decimal(&ret->key, d);
+	token_init_decimal(&ret->key, decimal_to_double(d), decimal_to_fixed(d));
 	ret->compound = compound;
 	return ret;
 }
@@ -157,7 +158,7 @@ boolean lexeme_get_bool(const struct lexeme_t *root, boolean *b) {
 	if (string_equal_c(&root->values[0]->key.data.str, "yes")) *b = true;
 	else if (string_equal_c(&root->values[0]->key.data.str, "no")) *b = false;
 	else {
-		fprintf(stdout, "[lexeme_get_color] Invalid bool value: %s\n", root->values[0]->key.data.str.text);
+		fprintf(stdout, "[lexeme_get_color] Invalid bool value: %s\n", string_text(&root->values[0]->key.data.str));
 		return false;
 	}
 	return true;
@@ -182,25 +183,22 @@ boolean lexeme_get_int(const struct lexeme_t *root, int *i) {
 	*i = root->values[0]->key.data.i;
 	return true;
 }
-boolean lexeme_get_decimal(const struct lexeme_t *root, double *d) {
+boolean lexeme_get_decimal(const struct lexeme_t *root, decimal_t *d) {
 	assert(root && "lexeme_get_decimal: root == 0");
 	assert(d && "lexeme_get_decimal: d == 0");
 	if (root->compound || root->values == 0 || buf_len(root->values) != 1 || root->values[0]->key.type != DECIMAL_TOKEN) {
 		fprintf(stdout, "[lexeme_get_decimal] Invalid decimal: must have exactly 1 decimal value\n");
 		return false;
 	}
-	*d = root->values[0]->key.data.d;
+	*d = token_decimal(&root->values[0]->key);
 	return true;
 }
-boolean lexeme_get_int_or_decimal(const struct lexeme_t *root, double *d) {
+boolean lexeme_get_int_or_decimal(const struct lexeme_t *root, decimal_t *d) {
 	assert(root && "lexeme_get_int_or_decimal: root == 0");
 	assert(d && "lexeme_get_int_or_decimal: d == 0");
 	if (!root->compound && root->values && buf_len(root->values) == 1) {
-		if (root->values[0]->key.type == DECIMAL_TOKEN) {
-			*d = root->values[0]->key.data.d;
-			return true;
-		} else if (root->values[0]->key.type == INT_TOKEN) {
-			*d = (double)root->values[0]->key.data.i;
+		if (root->values[0]->key.type == DECIMAL_TOKEN || root->values[0]->key.type == INT_TOKEN) {
+			*d = token_decimal(&root->values[0]->key);
 			return true;
 		}
 	}
@@ -253,7 +251,7 @@ int lexeme_read_compound(struct token_source_t *src, struct lexeme_t *parent) {
 		}
 	}
 	token_free(&token);
-	fprintf(stdout, "lexeme_read_compound: unclosed { brackets [line:% zu | % s]\n", src->line_number, src->filename.text);
+	fprintf(stdout, "lexeme_read_compound: unclosed { brackets [line:% zu | % s]\n", src->line_number, string_text(&src->filename));
 	return false;
 }
 
@@ -271,7 +269,7 @@ int lexeme_read(struct token_source_t *src, struct lexeme_t *lex) {
 	if (!token_is_data(&token)) {
 		fprintf(stdout, "[lexeme_read] Invalid token (expected data key): ");
 		token_print(stdout, &token);
-		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, src->filename.text);
+		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, string_text(&src->filename));
 		return false;
 	}
 	lex->key = token_move(&token);
@@ -290,7 +288,7 @@ int lexeme_read(struct token_source_t *src, struct lexeme_t *lex) {
 			fprintf(stdout, "[lexeme_read] Invalid token (expected data value or '{'): ");
 			token_print(stdout, &token);
 			token_free(&token);
-			fprintf(stdout, " [line:%zu|%s]\n", src->line_number, src->filename.text);
+			fprintf(stdout, " [line:%zu|%s]\n", src->line_number, string_text(&src->filename));
 			return false;
 		}
 	} else return true;
@@ -390,33 +388,23 @@ int lexer_check_file(const char *filepath, const char *filename) {
 	return err;
 }
 internal int internal_lexer_check_all_in_folder(const char *base_folder, int *files_read) {
-	WIN32_FIND_DATA foundFile;
-	HANDLE hFind = NULL;
-	char sPath[2048];
-	/* Specify a file mask. *.* = We want everything! */
-	sprintf_s(sPath, 2048, "%s/*.*", base_folder);
-	if ((hFind = FindFirstFile(sPath, &foundFile)) == INVALID_HANDLE_VALUE) {
+	directory_entry_t *entries = 0;
+	if (directory_list_files(base_folder, &entries) && buf_len(entries) == 0) {
 		fprintf(stdout, "[lexer_check_all_in_folder] could not find base folder: %s\n", base_folder);
+		directory_list_free(&entries);
 		return ERROR_RETURN;
 	}
 	int err = 0;
-	do {
-		if (strcmp(foundFile.cFileName, ".") != 0 && strcmp(foundFile.cFileName, "..") != 0) {
-			/* Build up our file path using the passed in [sDir] and the file/foldername we just found: */
-			sprintf_s(sPath, 2048, "%s/%s", base_folder, foundFile.cFileName);
-
-			/* Is the entity a File or Folder? */
-			if (foundFile.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)	/* Folder */
-				internal_lexer_check_all_in_folder(sPath, files_read);
-			else														/* File */
-				if (lexer_check_file(sPath, foundFile.cFileName)) {
-					err++;
-					fprintf(stdout, "[lexer_check_all_in_folder] Failed to read file: %s\n\t(at %s)\n", foundFile.cFileName, sPath);
-				} else
-					*files_read += 1;
-		}
-	} while (FindNextFile(hFind, &foundFile));
-	FindClose(hFind);
+	for_buf(i, entries) {
+		directory_prefetch_next(entries, buf_len(entries), i);
+		const directory_entry_t *entry = &entries[i];
+		if (lexer_check_file(string_text(&entry->path), directory_entry_name(entry))) {
+			err++;
+			fprintf(stdout, "[lexer_check_all_in_folder] Failed to read file: %s\n\t(at %s)\n", directory_entry_name(entry), string_text(&entry->path));
+		} else
+			*files_read += 1;
+	}
+	directory_list_free(&entries);
 	return err;
 }
 int lexer_check_all_in_folder(const char *base_folder) {
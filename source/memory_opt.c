@@ -1,5 +1,7 @@
 #include "memory_opt.h"
 
+#include "platform.h"
+
 //#include "maths.h"
 
 #include <stdio.h>
@@ -7,90 +9,453 @@
 #include <string.h>
 #include <stdarg.h>
 
-static int malloc_count = 0;
-static int realloc_count = 0;
-static int free_count = 0;
+/* updated atomically, so worker threads can allocate too */
+static u32 malloc_count = 0;
+static u32 realloc_count = 0;
+static u32 free_count = 0;
+
+#ifdef MEMORY_PROFILE
+/* every block starts with a header saying how big it is and which site made it, so frees can be taken off the
+	right site. 16 bytes keeps the block as aligned as malloc made it. */
+typedef struct memory_header_s {
+	u64 size;
+	u32 site;
+	u32 pad;
+} memory_header_t;
+_Static_assert(sizeof(memory_header_t) == 16, "memory_header_t should be 16 bytes");
+
+#define MEMORY_MAX_SITES 4096	/* power of two */
+#define MEMORY_SITE_FREE 0
+#define MEMORY_SITE_CLAIMED 1
+#define MEMORY_SITE_READY 2
+
+typedef struct memory_site_s {
+	volatile u32 state;
+	const char *file, *func;
+	int line;
+	volatile u64 allocs, bytes;	/* reallocs count as an alloc of the new size */
+	volatile u64 live_bytes, peak_live_bytes;
+} memory_site_t;
+
+static memory_site_t memory_sites[MEMORY_MAX_SITES];
+static volatile u64 memory_live_bytes = 0, memory_peak_live_bytes = 0, memory_total_bytes = 0;
+/* allocations by size, bucket i holds sizes in [2^i, 2^(i+1)) */
+#define MEMORY_HISTOGRAM_BUCKETS 40
+static volatile u64 memory_histogram[MEMORY_HISTOGRAM_BUCKETS];
+
+/* the same file and line is always the same site, the first thread to see it claims a slot */
+internal u32 memory_site_index(const char *file, int line, const char *func) {
+	size_t hash = ((size_t)file >> 4) * 31 + (size_t)line * 2654435761u;
+	for (u32 probe = 0; probe < MEMORY_MAX_SITES; ++probe) {
+		const u32 i = (u32)(hash + probe) & (MEMORY_MAX_SITES - 1);
+		memory_site_t *site = &memory_sites[i];
+		u32 state = atomic_load_u32(&site->state);
+		if (state == MEMORY_SITE_FREE && atomic_cas_u32(&site->state, MEMORY_SITE_FREE, MEMORY_SITE_CLAIMED)) {
+			site->file = file;
+			site->line = line;
+			site->func = func;
+			atomic_store_u32(&site->state, MEMORY_SITE_READY);
+			return i;
+		}
+		while ((state = atomic_load_u32(&site->state)) == MEMORY_SITE_CLAIMED) thread_yield();
+		if (site->line == line && (site->file == file || strcmp(site->file, file) == 0)) return i;
+	}
+	assert(false && "memory_site_index: out of sites, increase MEMORY_MAX_SITES");
+	return 0;
+}
+
+internal void memory_raise_peak(volatile u64 *peak, u64 value) {
+	u64 old = atomic_load_u64(peak);
+	while (value > old && !atomic_cas_u64(peak, old, value)) old = atomic_load_u64(peak);
+}
 
-void *malloc_s(size_t size) {
+internal void memory_track_alloc(memory_header_t *header, u64 size, const char *file, int line, const char *func) {
+	header->size = size;
+	header->site = memory_site_index(file, line, func);
+	memory_site_t *site = &memory_sites[header->site];
+	atomic_add_u64(&site->allocs, 1);
+	atomic_add_u64(&site->bytes, size);
+	memory_raise_peak(&site->peak_live_bytes, atomic_add_u64(&site->live_bytes, size) + size);
+	memory_raise_peak(&memory_peak_live_bytes, atomic_add_u64(&memory_live_bytes, size) + size);
+	atomic_add_u64(&memory_total_bytes, size);
+	u32 bucket = 0;
+	while (bucket + 1 < MEMORY_HISTOGRAM_BUCKETS && (size >> (bucket + 1))) bucket++;
+	atomic_add_u64(&memory_histogram[bucket], 1);
+}
+internal void memory_track_free(const memory_header_t *header) {
+	atomic_add_u64(&memory_sites[header->site].live_bytes, (u64)0 - header->size);
+	atomic_add_u64(&memory_live_bytes, (u64)0 - header->size);
+}
+#define memory_header(ptr) ((memory_header_t *)(ptr) - 1)
+#define MEMORY_HEADER_SIZE sizeof(memory_header_t)
+#else
+#define MEMORY_HEADER_SIZE 0
+#endif
+
+void *malloc_at(size_t size MEMORY_SITE_PARAMS) {
 	if (size == 0) {
 		fprintf(stdout, "[malloc_s] size 0 request\n");
 		return 0;
 	}
-	void *ret = malloc(size);
+	void *ret = malloc(MEMORY_HEADER_SIZE + size);
 	assert(ret && "[malloc_s] malloc failed");
-	malloc_count++;
+	atomic_add_u32(&malloc_count, 1);
+#ifdef MEMORY_PROFILE
+	memory_track_alloc((memory_header_t *)ret, size, site_file, site_line, site_func);
+	ret = (memory_header_t *)ret + 1;
+#endif
 	return ret;
 }
-void *calloc_s(size_t size) {
+void *calloc_at(size_t size MEMORY_SITE_PARAMS) {
 	if (size == 0) {
 		fprintf(stdout, "[calloc_s] size 0 request\n");
 		return 0;
 	}
-	void *ret = calloc(size, 1);
+	void *ret = calloc(MEMORY_HEADER_SIZE + size, 1);
 	assert(ret && "[calloc_s] calloc failed");
-	malloc_count++;
+	atomic_add_u32(&malloc_count, 1);
+#ifdef MEMORY_PROFILE
+	memory_track_alloc((memory_header_t *)ret, size, site_file, site_line, site_func);
+	ret = (memory_header_t *)ret + 1;
+#endif
 	return ret;
 }
-void *realloc_s(void *ptr, size_t size) {
+void *realloc_at(void *ptr, size_t size MEMORY_SITE_PARAMS) {
 	if (size == 0) {
-		if (ptr) {
-			free(ptr);
-			free_count++;
-		}
+		if (ptr) free_s(ptr);
 		fprintf(stdout, "[realloc_s] size 0 request\n");
 		return 0;
 	}
-	void *ret = realloc(ptr, size);
+#ifdef MEMORY_PROFILE
+	if (ptr) {
+		memory_track_free(memory_header(ptr));
+		ptr = memory_header(ptr);
+	}
+#endif
+	void *ret = realloc(ptr, MEMORY_HEADER_SIZE + size);
 	assert(ret && "[realloc_s] realloc failed");
-	if (ptr) realloc_count++;
+	if (ptr) atomic_add_u32(&realloc_count, 1);
 	else {
 		//fprintf(stdout, "[realloc_s] ptr == 0\n");
-		malloc_count++;
+		atomic_add_u32(&malloc_count, 1);
 	}
+#ifdef MEMORY_PROFILE
+	memory_track_alloc((memory_header_t *)ret, size, site_file, site_line, site_func);
+	ret = (memory_header_t *)ret + 1;
+#endif
 	return ret;
 }
 void free_s(void *ptr) {
 	if (ptr) {
+#ifdef MEMORY_PROFILE
+		memory_track_free(memory_header(ptr));
+		ptr = memory_header(ptr);
+#endif
 		free(ptr);
-		free_count++;
+		atomic_add_u32(&free_count, 1);
+	}
+}
+
+/* POOL */
+#define POOL_CLASS_COUNT 5	/* 16 << class */
+#define POOL_SLAB_SIZE (64 * 1024)
+
+typedef struct pool_block_s {
+	struct pool_block_s *next;
+} pool_block_t;
+
+typedef struct pool_class_s {
+	pool_block_t *free_list;
+	u8 *bump, *bump_end;	/* the part of the current slab not handed out yet */
+} pool_class_t;
+
+/* lives in a slab rather than in thread local storage, so the counts are still there after its thread exits */
+typedef struct pool_thread_s {
+	pool_class_t classes[POOL_CLASS_COUNT];
+	volatile u64 allocs, frees, slab_bytes;	/* only written by the owning thread */
+	struct pool_thread_s *next;
+} pool_thread_t;
+
+static THREAD_LOCAL pool_thread_t *pool_this_thread = 0;
+static pool_thread_t *volatile pool_threads = 0;
+
+internal pool_thread_t *pool_get_thread(void) {
+	if (!pool_this_thread) {
+		pool_thread_t *pool = platform_alloc_pages(sizeof(pool_thread_t));
+		assert(pool && "pool_get_thread: out of memory");
+		pool->next = atomic_exchange_ptr((void *volatile *)&pool_threads, pool);
+		pool_this_thread = pool;
+	}
+	return pool_this_thread;
+}
+
+internal u32 pool_class(size_t size) {
+	u32 c = 0;
+	while ((size_t)16 << c < size) c++;
+	return c;
+}
+
+internal void *pool_take(size_t size) {
+	pool_thread_t *pool = pool_get_thread();
+	pool_class_t *cls = &pool->classes[pool_class(size)];
+	const size_t block_size = (size_t)16 << (cls - pool->classes);
+	pool->allocs++;
+	pool_block_t *block = cls->free_list;
+	if (block) {
+		cls->free_list = block->next;
+		return block;
 	}
+	if (cls->bump == cls->bump_end) {
+		cls->bump = platform_alloc_pages(POOL_SLAB_SIZE);
+		assert(cls->bump && "pool_take: out of memory");
+		cls->bump_end = cls->bump + POOL_SLAB_SIZE;
+		pool->slab_bytes += POOL_SLAB_SIZE;
+	}
+	void *ret = cls->bump;
+	cls->bump += block_size;
+	return ret;
+}
+
+void *pool_alloc_at(size_t size MEMORY_SITE_PARAMS) {
+#ifndef MEMORY_PROFILE
+	if (size && size <= POOL_MAX_SIZE) return pool_take(size);
+#endif
+	return malloc_at(size MEMORY_SITE_PASS);
+}
+void *pool_calloc_at(size_t size MEMORY_SITE_PARAMS) {
+#ifndef MEMORY_PROFILE
+	if (size && size <= POOL_MAX_SIZE) return memset(pool_take(size), 0, size);
+#endif
+	return calloc_at(size MEMORY_SITE_PASS);
+}
+void pool_free(void *ptr, size_t size) {
+	if (!ptr) return;
+#ifndef MEMORY_PROFILE
+	if (size <= POOL_MAX_SIZE) {
+		pool_thread_t *pool = pool_get_thread();
+		pool_block_t *block = (pool_block_t *)ptr;
+		pool_class_t *cls = &pool->classes[pool_class(size)];
+		block->next = cls->free_list;
+		cls->free_list = block;
+		pool->frees++;
+		return;
+	}
+#endif
+	free_s(ptr);
+}
+void *pool_realloc_at(void *ptr, size_t old_size, size_t new_size MEMORY_SITE_PARAMS) {
+	if (!ptr) return pool_alloc_at(new_size MEMORY_SITE_PASS);
+#ifndef MEMORY_PROFILE
+	if (old_size <= POOL_MAX_SIZE || new_size <= POOL_MAX_SIZE) {
+		if (old_size <= POOL_MAX_SIZE && new_size <= POOL_MAX_SIZE && new_size && pool_class(old_size) == pool_class(new_size)) return ptr;
+		void *ret = pool_alloc_at(new_size MEMORY_SITE_PASS);
+		if (ret) memcpy(ret, ptr, MIN(old_size, new_size));
+		pool_free(ptr, old_size);
+		return ret;
+	}
+#endif
+	(void)old_size;
+	return realloc_at(ptr, new_size MEMORY_SITE_PASS);
+}
+
+s64 pool_live_blocks(void) {
+	s64 live = 0;
+	for (pool_thread_t *pool = (pool_thread_t *)atomic_load_ptr((void *volatile *)&pool_threads); pool; pool = pool->next)
+		live += (s64)(pool->allocs - pool->frees);
+	return live;
+}
+
+/* SCRATCH */
+#define SCRATCH_ALIGN 16
+
+typedef struct scratch_chunk_s {
+	struct scratch_chunk_s *next;	/* the chunks after the current one are free for reuse */
+	size_t size, used;				/* both in bytes from the start of the chunk, header included */
+} scratch_chunk_t;
+
+#define SCRATCH_HEADER ((sizeof(scratch_chunk_t) + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1))
+
+static THREAD_LOCAL scratch_chunk_t *scratch_first = 0, *scratch_current = 0;
+
+scratch_mark_t scratch_mark(void) {
+	scratch_mark_t mark = { scratch_current, scratch_current ? scratch_current->used : 0 };
+	return mark;
+}
+void scratch_reset(scratch_mark_t mark) {
+	/* a mark taken before this thread's first allocation goes back to the start */
+	if (mark.chunk) {
+		assert(SCRATCH_HEADER <= mark.used && mark.used <= mark.chunk->size && "scratch_reset: invalid mark");
+		scratch_current = mark.chunk;
+		scratch_current->used = mark.used;
+	} else if (scratch_first) {
+		scratch_current = scratch_first;
+		scratch_current->used = SCRATCH_HEADER;
+	}
+}
+void *scratch_alloc(size_t size) {
+	size = (size + SCRATCH_ALIGN - 1) & ~(size_t)(SCRATCH_ALIGN - 1);
+	scratch_chunk_t *chunk = scratch_current;
+	if (!chunk || chunk->size - chunk->used < size) {
+		scratch_chunk_t *next = chunk ? chunk->next : scratch_first;
+		if (!next || next->size - SCRATCH_HEADER < size) {
+			/* goes in before a next chunk that is too small, which stays there for later */
+			const size_t chunk_size = MAX(SCRATCH_CHUNK_SIZE, SCRATCH_HEADER + size);
+			scratch_chunk_t *fresh = platform_alloc_pages(chunk_size);
+			assert(fresh && "scratch_alloc: out of memory");
+			fresh->size = chunk_size;
+			fresh->next = next;
+			if (chunk) chunk->next = fresh;
+			else scratch_first = fresh;
+			next = fresh;
+		}
+		next->used = SCRATCH_HEADER;
+		scratch_current = chunk = next;
+	}
+	void *ret = (u8 *)chunk + chunk->used;
+	chunk->used += size;
+	return ret;
+}
+void *scratch_calloc(size_t size) {
+	return memset(scratch_alloc(size), 0, size);
+}
+void scratch_release(void) {
+	scratch_chunk_t *chunk = scratch_first;
+	while (chunk) {
+		scratch_chunk_t *next = chunk->next;
+		platform_free_pages(chunk, chunk->size);
+		chunk = next;
+	}
+	scratch_first = scratch_current = 0;
 }
 
 void check_memory_leaks(void) {
-	fprintf(stdout, "[check_memory_leaks] malloc_count = %d, realloc_count = %d, free_count = %d\n", malloc_count, realloc_count, free_count);
-	fprintf(stdout, "[check_memory_leaks] malloc_count - free_count = %d\n", malloc_count - free_count);
+	const u32 mallocs = atomic_load_u32(&malloc_count), reallocs = atomic_load_u32(&realloc_count), frees = atomic_load_u32(&free_count);
+	fprintf(stdout, "[check_memory_leaks] malloc_count = %u, realloc_count = %u, free_count = %u\n", mallocs, reallocs, frees);
+	fprintf(stdout, "[check_memory_leaks] malloc_count - free_count = %d\n", (int)(mallocs - frees));
+#ifdef MEMORY_PROFILE
+	fprintf(stdout, "[check_memory_leaks] %llu bytes still allocated\n", (unsigned long long)atomic_load_u64(&memory_live_bytes));
+#else
+	u64 pool_allocs = 0, pool_frees = 0, slab_bytes = 0;
+	for (pool_thread_t *pool = (pool_thread_t *)atomic_load_ptr((void *volatile *)&pool_threads); pool; pool = pool->next) {
+		pool_allocs += pool->allocs;
+		pool_frees += pool->frees;
+		slab_bytes += pool->slab_bytes;
+	}
+	if (pool_allocs) fprintf(stdout, "[check_memory_leaks] pool_alloc_count = %llu, pool_free_count = %llu (%d still allocated), %llu KB of slabs\n",
+		(unsigned long long)pool_allocs, (unsigned long long)pool_frees, (int)(pool_allocs - pool_frees), (unsigned long long)(slab_bytes >> 10));
+#endif
 }
 
+#ifdef MEMORY_PROFILE
+internal int memory_site_compare(const void *a, const void *b) {
+	const u64 bytes_a = (*(const memory_site_t *const *)a)->bytes, bytes_b = (*(const memory_site_t *const *)b)->bytes;
+	return bytes_a < bytes_b ? 1 : bytes_a > bytes_b ? -1 : 0;
+}
+internal const char *memory_file_name(const char *file) {
+	const char *name = file;
+	for (const char *c = file; *c; ++c)
+		if (*c == '/' || *c == '\\') name = c + 1;
+	return name;
+}
+void memory_profile_report(FILE *const stream, size_t top_sites) {
+	/* a snapshot, good enough while other threads are still allocating */
+	local const memory_site_t *sites[MEMORY_MAX_SITES];
+	size_t count = 0;
+	for (size_t i = 0; i < MEMORY_MAX_SITES; ++i)
+		if (atomic_load_u32(&memory_sites[i].state) == MEMORY_SITE_READY) sites[count++] = &memory_sites[i];
+	qsort(sites, count, sizeof(sites[0]), memory_site_compare);
+	const u64 total = atomic_load_u64(&memory_total_bytes);
+	fprintf(stream, "[memory_profile_report] %llu bytes allocated from %zu sites, %llu live, %llu at peak\n",
+		(unsigned long long)total, count, (unsigned long long)atomic_load_u64(&memory_live_bytes),
+		(unsigned long long)atomic_load_u64(&memory_peak_live_bytes));
+	fprintf(stream, "%12s %6s %10s %12s %12s  site\n", "bytes", "%", "allocs", "live", "peak live");
+	for (size_t i = 0; i < count && i < top_sites; ++i) {
+		const memory_site_t *site = sites[i];
+		fprintf(stream, "%12llu %5.1f%% %10llu %12llu %12llu  %s (%s:%d)\n", (unsigned long long)site->bytes,
+			total ? 100.0 * site->bytes / total : 0.0, (unsigned long long)site->allocs, (unsigned long long)site->live_bytes,
+			(unsigned long long)site->peak_live_bytes, site->func, memory_file_name(site->file), site->line);
+	}
+	fprintf(stream, "[memory_profile_report] allocation sizes:\n");
+	for (u32 i = 0; i < MEMORY_HISTOGRAM_BUCKETS; ++i) {
+		const u64 n = atomic_load_u64(&memory_histogram[i]);
+		if (n) fprintf(stream, "%12llu - %-12llu %llu\n", 1ull << i, (2ull << i) - 1, (unsigned long long)n);
+	}
+}
+#else
+void memory_profile_report(FILE *const stream, size_t top_sites) {
+	(void)stream; (void)top_sites;
+}
+#endif
 
-void *buf__grow(const void *buf, size_t new_len, size_t elem_size) {
+void *buf__grow(const void *buf, size_t new_len, size_t elem_size MEMORY_SITE_PARAMS) {
 	assert(buf_cap(buf) <= (SIZE_MAX - 1) / 2 && "[buf__grow] capacity will overflow");
 	size_t new_cap = MAX(2 * buf_cap(buf), MAX(new_len, 16));
 	assert(new_len <= new_cap && "[buf__grow] capacity will be less than length");
-	assert(new_cap <= (SIZE_MAX - offsetof(buffer_t, buf)) / elem_size && "[buf__grow] capacity will overflow");
+	return buf__set_cap(buf, new_cap, elem_size MEMORY_SITE_PASS);
+}
+void *buf__set_cap(const void *buf, size_t new_cap, size_t elem_size MEMORY_SITE_PARAMS) {
+	assert(new_cap >= buf_len(buf) && "[buf__set_cap] capacity will be less than length");
+	assert(new_cap <= (SIZE_MAX - offsetof(buffer_t, buf)) / elem_size && "[buf__set_cap] capacity will overflow");
 	size_t new_size = offsetof(buffer_t, buf) + new_cap * elem_size;
 	buffer_t *new_buf;
-	if (buf) new_buf = realloc_s(buf__hdr(buf), new_size);
+	if (buf) new_buf = realloc_at(buf__hdr(buf), new_size MEMORY_SITE_PASS);
 	else {
-		new_buf = malloc_s(new_size);
+		new_buf = malloc_at(new_size MEMORY_SITE_PASS);
 		new_buf->len = 0;
 	}
 	new_buf->cap = new_cap;
 	return new_buf->buf;
 }
-char *buf__printf(char *buf, const char *fmt, ...) {
-	va_list args;
-	va_start(args, fmt);
+int svec__set_cap(void *items, u32 *cap, u32 len, size_t elem_size, u32 inline_cap, u32 new_cap MEMORY_SITE_PARAMS) {
+	assert(items && cap && "[svec__set_cap] items == 0");
+	assert(new_cap >= len && "[svec__set_cap] capacity will be less than length");
+	const boolean on_heap = *cap > inline_cap;
+	/* the heap pointer shares its bytes with the inline elements */
+	void *heap = 0;
+	if (on_heap) memcpy(&heap, items, sizeof(void *));
+	if (new_cap <= inline_cap) {
+		if (on_heap) {
+			memcpy(items, heap, len * elem_size);
+			free_s(heap);
+		}
+		*cap = 0;
+		return 0;
+	}
+	if (on_heap) heap = realloc_at(heap, new_cap * elem_size MEMORY_SITE_PASS);
+	else {
+		heap = malloc_at(new_cap * elem_size MEMORY_SITE_PASS);
+		if (heap) memcpy(heap, items, len * elem_size);
+	}
+	assert(heap && "[svec__set_cap] allocation failed");
+	memcpy(items, &heap, sizeof(void *));
+	*cap = new_cap;
+	return 0;
+}
+void svec__free(void *items, u32 cap, u32 inline_cap) {
+	if (cap <= inline_cap) return;
+	void *heap;
+	memcpy(&heap, items, sizeof(void *));
+	free_s(heap);
+}
+char *buf__vprintf(char *buf MEMORY_SITE_PARAMS, const char *fmt, va_list args) {
+	va_list retry;
+	va_copy(retry, args);
 	size_t cap = buf_cap(buf) - buf_len(buf);
 	size_t n = 1 + vsnprintf(buf_end(buf), cap, fmt, args);
-	va_end(args);
 	if (n > cap) {
-		buf_fit(buf, n + buf_len(buf));
-		va_start(args, fmt);
+		if (n + buf_len(buf) > buf_cap(buf)) buf = buf__grow(buf, n + buf_len(buf), 1 MEMORY_SITE_PASS);
 		size_t new_cap = buf_cap(buf) - buf_len(buf);
-		n = 1 + vsnprintf(buf_end(buf), new_cap, fmt, args);
+		n = 1 + vsnprintf(buf_end(buf), new_cap, fmt, retry);
 		assert(n <= new_cap);
-		va_end(args);
 	}
+	va_end(retry);
 	buf__hdr(buf)->len += n - 1;
 	return buf;
 }
+char *buf__printf(char *buf MEMORY_SITE_PARAMS, const char *fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	buf = buf__vprintf(buf MEMORY_SITE_PASS, fmt, args);
+	va_end(args);
+	return buf;
+}
@@ -2,15 +2,83 @@
 
 #include "maths.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 
-void *malloc_s(size_t size);
-void *calloc_s(size_t size);
-void *realloc_s(void *ptr, size_t size);
+#include <stdarg.h>
+#include <stdio.h>
+
+/* ALLOCATION PROFILING
+	Configuring with -DMEMORY_PROFILE=ON makes every allocation record where it was made (file, line and
+	function), so memory_profile_report can rank call sites by bytes allocated and show the peak live bytes
+	and a histogram of allocation sizes. The counters are atomic, so worker threads can allocate too. Off, the
+	call site isn't passed at all and the functions cost what they always have. */
+#ifdef MEMORY_PROFILE
+#define MEMORY_SITE_PARAMS , const char *site_file, int site_line, const char *site_func
+#define MEMORY_SITE_ARGS , __FILE__, __LINE__, __func__
+#define MEMORY_SITE_PASS , site_file, site_line, site_func
+#else
+#define MEMORY_SITE_PARAMS
+#define MEMORY_SITE_ARGS
+#define MEMORY_SITE_PASS
+#endif
+
+#define malloc_s(size) malloc_at((size) MEMORY_SITE_ARGS)
+#define calloc_s(size) calloc_at((size) MEMORY_SITE_ARGS)
+#define realloc_s(ptr, size) realloc_at((ptr), (size) MEMORY_SITE_ARGS)
+void *malloc_at(size_t size MEMORY_SITE_PARAMS);
+void *calloc_at(size_t size MEMORY_SITE_PARAMS);
+void *realloc_at(void *ptr, size_t size MEMORY_SITE_PARAMS);
 void free_s(void *ptr);
 
 void check_memory_leaks(void);
 
+/* POOL
+	Blocks of up to POOL_MAX_SIZE bytes carved out of per-thread slabs, one free list per size class
+	(16/32/64/128/256), so the many tiny allocations of a load (lexemes, key strings, short buffers) never touch
+	malloc or take a lock. Bigger requests fall through to malloc_s. A block has to be freed (or reallocated) with
+	the size it was allocated with; it can be freed on any thread, and goes onto that thread's free list. Slabs
+	are never given back, so memory stays reserved for reuse after a load is freed.
+	Nothing allocates from it by default: lexing a 50 MB script was no faster with lexemes, strings and stretchy
+	buffers in the pool than in malloc (see bench-alloc), so they stay on malloc_s. It is there for code that
+	allocates many same-sized blocks and has measured a gain.
+	With MEMORY_PROFILE every request goes to malloc_s instead, so it shows up under its call site. */
+#define POOL_MAX_SIZE 256
+
+#define pool_alloc(size) pool_alloc_at((size) MEMORY_SITE_ARGS)
+#define pool_calloc(size) pool_calloc_at((size) MEMORY_SITE_ARGS)
+#define pool_realloc(ptr, old_size, new_size) pool_realloc_at((ptr), (old_size), (new_size) MEMORY_SITE_ARGS)
+void *pool_alloc_at(size_t size MEMORY_SITE_PARAMS);
+void *pool_calloc_at(size_t size MEMORY_SITE_PARAMS);
+void *pool_realloc_at(void *ptr, size_t old_size, size_t new_size MEMORY_SITE_PARAMS);
+void pool_free(void *ptr, size_t size);
+/* blocks allocated - blocks freed, over all threads */
+s64 pool_live_blocks(void);
+/* SCRATCH
+	A per-thread bump region for temporaries that die together (a row buffer, a lookup table, a triangle's
+	scanlines): take a mark, allocate, then reset to the mark and everything allocated since is gone at once,
+	with nothing freed one by one. Marks nest; resetting to an older mark drops what newer ones covered too.
+	The region is chunks of SCRATCH_CHUNK_SIZE (bigger requests get a chunk of their own) that are kept for
+	reuse after a reset, so a thread that keeps doing the same work stops allocating. Blocks are 16 byte
+	aligned and only valid on the thread that took them. A thread started with thread_create gives its chunks
+	back when it exits; the chunks don't show up in the memory profile. */
+#define SCRATCH_CHUNK_SIZE (256 * 1024)
+
+typedef struct scratch_mark_s {
+	struct scratch_chunk_s *chunk;
+	size_t used;
+} scratch_mark_t;
+
+scratch_mark_t scratch_mark(void);
+void scratch_reset(scratch_mark_t mark);
+void *scratch_alloc(size_t size);
+void *scratch_calloc(size_t size);
+/* gives back the calling thread's chunks, nothing can be marked or allocated at the time */
+void scratch_release(void);
+
+/* the top_sites call sites that allocated the most bytes, then the size histogram (nothing without MEMORY_PROFILE) */
+void memory_profile_report(FILE *const stream, size_t top_sites);
+
 typedef struct buffer_s {
 	size_t len;
 	size_t cap;
@@ -26,13 +94,51 @@ typedef struct buffer_s {
 #define buf_sizeof(b) ((b) ? buf_len(b)*sizeof(*(b)) : (size_t)0)
 
 #define buf_free(b) ((b) ? (free_s(buf__hdr(b)), (b) = NULL) : 0)
-#define buf_fit(b, n) ((n) <= buf_cap(b) ? 0 : ((b) = buf__grow((b), (n), sizeof(*(b)))))
+#define buf_fit(b, n) ((n) <= buf_cap(b) ? 0 : ((b) = buf__grow((b), (n), sizeof(*(b)) MEMORY_SITE_ARGS)))
 #define buf_push(b, ...) (buf_fit((b), 1 + buf_len(b)), (b)[buf__hdr(b)->len++] = (__VA_ARGS__))
-#define buf_printf(b, ...) ((b) = buf__printf((b), __VA_ARGS__))
+#define buf_printf(b, ...) ((b) = buf__printf((b) MEMORY_SITE_ARGS, __VA_ARGS__))
 #define buf_clear(b) ((b) ? buf__hdr(b)->len = 0 : 0)
+/* exactly n elements of capacity when the count is known up front, instead of doubling up to it */
+#define buf_reserve(b, n) ((n) <= buf_cap(b) ? 0 : ((b) = buf__set_cap((b), (n), sizeof(*(b)) MEMORY_SITE_ARGS)))
+/* gives back the capacity past the length (freeing b if it is empty). b can move, leaving pointers into it dangling */
+#define buf_shrink(b) (buf_len(b) == buf_cap(b) ? 0 : buf_len(b) == 0 ? buf_free(b) : ((b) = buf__set_cap((b), buf_len(b), sizeof(*(b)) MEMORY_SITE_ARGS)))
+/* bytes of capacity allocated but not in use */
+#define buf_waste(b) ((buf_cap(b) - buf_len(b)) * sizeof(*(b)))
 
-void *buf__grow(const void *buf, size_t new_len, size_t elem_size);
-char *buf__printf(char *buf, const char *fmt, ...);
+void *buf__grow(const void *buf, size_t new_len, size_t elem_size MEMORY_SITE_PARAMS);
+void *buf__set_cap(const void *buf, size_t new_cap, size_t elem_size MEMORY_SITE_PARAMS);
+char *buf__vprintf(char *buf MEMORY_SITE_PARAMS, const char *fmt, va_list args);
+char *buf__printf(char *buf MEMORY_SITE_PARAMS, const char *fmt, ...);
 
 #define for_buf(var, b) for (size_t var = 0; var < buf_len(b); ++var)
 
+
+/* SMALL VECTOR
+	A list whose first n elements live inside it, for the short lists objects keep of each other (a province's
+	cores, a state's provinces): only once it outgrows them does it move to the heap, so most lookups stay in
+	the owning struct's cache lines. There's no pointer to itself, so it is copied along with the struct it's in
+	like a stretchy buffer would be (only one copy gets freed). Declare with small_vec(type, n), zero-initialise. */
+#define small_vec(type, n) struct { u32 len, cap; union { type *heap; type slots[n]; } items; }
+
+#define svec__inline_cap(v) ((u32)(sizeof((v).items.slots) / sizeof((v).items.slots[0])))
+#define svec__elem_size(v) sizeof((v).items.slots[0])
+
+#define svec_on_heap(v) ((v).cap > svec__inline_cap(v))
+#define svec_len(v) ((size_t)(v).len)
+#define svec_cap(v) ((size_t)(svec_on_heap(v) ? (v).cap : svec__inline_cap(v)))
+#define svec_items(v) (svec_on_heap(v) ? (v).items.heap : (v).items.slots)
+#define svec_at(v, i) (svec_items(v)[i])
+#define svec_sizeof(v) (svec_len(v) * svec__elem_size(v))
+/* spare slots, inline ones included */
+#define svec_waste(v) ((svec_cap(v) - svec_len(v)) * svec__elem_size(v))
+
+#define svec_reserve(v, n) ((n) <= svec_cap(v) ? 0 : svec__set_cap(&(v).items, &(v).cap, (v).len, svec__elem_size(v), svec__inline_cap(v), (u32)(n) MEMORY_SITE_ARGS))
+#define svec_push(v, ...) (svec_reserve((v), svec_cap(v) == svec_len(v) ? 2 * svec_cap(v) : 0), svec_at((v), (v).len++) = (__VA_ARGS__))
+/* moves it back inline if it fits, otherwise trims the heap block to its length */
+#define svec_shrink(v) (svec_on_heap(v) && (v).len < (v).cap ? svec__set_cap(&(v).items, &(v).cap, (v).len, svec__elem_size(v), svec__inline_cap(v), (v).len MEMORY_SITE_ARGS) : 0)
+#define svec_free(v) (svec__free(&(v).items, (v).cap, svec__inline_cap(v)), (v).len = (v).cap = 0)
+
+int svec__set_cap(void *items, u32 *cap, u32 len, size_t elem_size, u32 inline_cap, u32 new_cap MEMORY_SITE_PARAMS);
+void svec__free(void *items, u32 cap, u32 inline_cap);
+
+#define for_svec(var, v) for (size_t var = 0; var < svec_len(v); ++var)
@@ -2,6 +2,8 @@
 
 #include "assert_opt.h"
 #include "memory_opt.h"
+#include "platform.h"
+#include "text_scan.h"
 
 #include <string.h>
 
@@ -38,12 +40,10 @@ void token_init_alphanumeric(struct token_t *token, const string *str, boolean c
 	assert(token && "token_init_alphanumeric: token == 0");
 	assert(str && "token_init_alphanumeric: str == 0");
 	token->type = ALPHANUMERIC;
-	assert(str->length && "token_init_alphanumeric: str is empty");
+	assert(!string_empty(str) && "token_init_alphanumeric: str is empty");
 	if (copy) {
-		token->data.str.length = str->length;
-		token->data.str.text = malloc_s(str->length + 1);
-		assert(token->data.str.text && "token_init_alphanumeric: malloc failed");
-		memcpy(token->data.str.text, str->text, str->length + 1);
+		token->data.str = (string){ 0 };
+		string_extract(&token->data.str, string_text(str), string_length(str));
 	} else
 		token->data.str = *str;
 }
@@ -64,10 +64,11 @@ void token_init_int(struct token_t *token, int i) {
 	token->type = INT_TOKEN;
 	token->data.i = i;
 }
-void token_init_decimal(struct token_t *token, double d) {
+void token_init_decimal(struct token_t *token, double d, fixed_t fixed) {
 	assert(token && "token_init_decimal: token == 0");
 	token->type = DECIMAL_TOKEN;
 	token->data.d = d;
+	token->data.fixed = fixed;
 }
 void token_init_date(struct token_t *token, const date_t *date) {
 	assert(token && "token_init_decimal: token == 0");
@@ -92,11 +93,11 @@ void token_print(FILE *const stream, const struct token_t *token) {
 	if (token->type == UNKNOWN)
 		fprintf(stream, "UNKOWN");
 	else if (token->type == ALPHANUMERIC)
-		fprintf(stream, "ALPHANUMERIC:%s", token->data.str.text);
+		fprintf(stream, "ALPHANUMERIC:%s", string_text(&token->data.str));
 	else if (token->type == SYMBOL)
 		fprintf(stream, "SYMBOL:%c", token->data.sym);
 	else if (token->type == STRING)
-		fprintf(stream, "STRING:%s", token->data.str.text);
+		fprintf(stream, "STRING:%s", string_text(&token->data.str));
 	else if (token->type == INT_TOKEN)
 		fprintf(stream, "INT:%d", token->data.i);
 	else if (token->type == DECIMAL_TOKEN)
@@ -111,11 +112,11 @@ size_t token_sprint(char *const buffer, size_t buffer_count, const struct token_
 	if (token->type == UNKNOWN)
 		return sprintf_s(buffer, buffer_count, "UNKOWN");
 	else if (token->type == ALPHANUMERIC)
-		return sprintf_s(buffer, buffer_count, "%s", token->data.str.text);
+		return sprintf_s(buffer, buffer_count, "%s", string_text(&token->data.str));
 	else if (token->type == SYMBOL)
 		return sprintf_s(buffer, buffer_count, "%c", token->data.sym);
 	else if (token->type == STRING)
-		return sprintf_s(buffer, buffer_count, "\"%s\"", token->data.str.text);
+		return sprintf_s(buffer, buffer_count, "\"%s\"", string_text(&token->data.str));
 	else if (token->type == INT_TOKEN)
 		return sprintf_s(buffer, buffer_count, "%d", token->data.i);
 	else if (token->type == DECIMAL_TOKEN)
@@ -126,24 +127,114 @@ size_t token_sprint(char *const buffer, size_t buffer_count, const struct token_
 		return sprintf_s(buffer, buffer_count, "ERROR");
 }
 
+/* CHAR_CLASS(c) is a constant expression so the whole table can be built by the compiler */
+#define CHAR_CLASS_BASE(c) ( \
+	((('a' <= (c) && (c) <= 'z') || ('A' <= (c) && (c) <= 'Z') || (c) >= 0x80) ? CHAR_ALPHA : 0) | \
+	(('0' <= (c) && (c) <= '9') ? CHAR_DIGIT : 0) | \
+	(((c) == '=' || (c) == '{' || (c) == '}' || (c) == ';' || (c) == ',') ? CHAR_SYMBOL : 0) | \
+	(((c) == ' ' || (c) == '\t' || (c) == '\v' || (c) == '\f') ? CHAR_WHITESPACE : 0) | \
+	(((c) == '\n' || (c) == '\r') ? CHAR_NEWLINE : 0) | \
+	(((c) == '\'' || (c) == '"') ? CHAR_QUOTE : 0) | \
+	((c) == '#' ? CHAR_COMMENT : 0))
+#define CHAR_CLASS(c) (CHAR_CLASS_BASE(c) | (((CHAR_CLASS_BASE(c) & CHAR_DELIMITER) || (c) == 0) ? 0 : CHAR_TOKEN))
+#define CHAR_CLASS_4(c) CHAR_CLASS(c), CHAR_CLASS((c) + 1), CHAR_CLASS((c) + 2), CHAR_CLASS((c) + 3)
+#define CHAR_CLASS_16(c) CHAR_CLASS_4(c), CHAR_CLASS_4((c) + 4), CHAR_CLASS_4((c) + 8), CHAR_CLASS_4((c) + 12)
+#define CHAR_CLASS_64(c) CHAR_CLASS_16(c), CHAR_CLASS_16((c) + 16), CHAR_CLASS_16((c) + 32), CHAR_CLASS_16((c) + 48)
+const u8 char_class[256] = { CHAR_CLASS_64(0), CHAR_CLASS_64(64), CHAR_CLASS_64(128), CHAR_CLASS_64(192) };
+
+decimal_t token_decimal(const struct token_t *token) {
+	assert(token && "token_decimal: token == 0");
+	assert((token->type == DECIMAL_TOKEN || token->type == INT_TOKEN) && "token_decimal: not a number");
+	if (token->type == INT_TOKEN) return decimal_from_int(token->data.i);
+#ifdef DECIMAL_FIXED_POINT
+	return token->data.fixed;
+#else
+	return token->data.d;
+#endif
+}
+
 boolean is_alpha(char c) {
-	return ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || (c & 0b10000000);
+	return TO_BOOL(char_is(c, CHAR_ALPHA));
 }
 boolean is_number(char c) {
-	return ('0' <= c && c <= '9');
+	return TO_BOOL(char_is(c, CHAR_DIGIT));
 }
 boolean is_alphanumeric(char c) {
 	//return is_alpha(c) || is_number(c) || c == '_' || c == '-' || c == '\'' || c == '.' || c == ':';
-	return !is_symbol(c) && !is_whitespace(c) && !is_string_signifier(c);
+	return !char_is(c, CHAR_SYMBOL | CHAR_WHITESPACE | CHAR_QUOTE);
 }
 boolean is_symbol(char c) {
-	return c == '=' || c == '{' || c == '}' || c == ';' || c == ',';
+	return TO_BOOL(char_is(c, CHAR_SYMBOL));
 }
 boolean is_string_signifier(char c) {
-	return c == '\'' || c == '"';
+	return TO_BOOL(char_is(c, CHAR_QUOTE));
+}
+
+/* exact powers of ten, the largest a double holds exactly is 10^22 */
+internal const double exact_powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define EXACT_MANTISSA_LIMIT (1ull << 53)
+
+/* text[0, length) is an optional '-' then digits with one '.', mantissa is its digits as an integer. If both
+	the mantissa and the power of ten are exact doubles, one division is correctly rounded and matches atof.
+	Anything longer (more than 15 significant digits) falls back to atof. */
+internal double parse_decimal(const char *text, size_t length, boolean negative, u64 mantissa, u32 digits, u32 fraction_digits) {
+	if (digits == 0) return 0.0; /* "." and "-." are no number at all to atof, not -0.0 */
+	if (digits <= 19 && mantissa < EXACT_MANTISSA_LIMIT && fraction_digits <= 22) {
+		const double d = (double)mantissa / exact_powers_of_ten[fraction_digits];
+		return negative ? -d : d;
+	}
+	string tmp = { 0 };
+	string_extract(&tmp, text, length);
+	const double d = atof(string_text(&tmp));
+	string_clear(&tmp);
+	return d;
+}
+
+/* reads digits up to the next '.' or the end of text, wrapping like atoi. *pos ends on the '.' */
+internal u32 parse_date_part(const char *text, size_t length, size_t *pos) {
+	u32 value = 0;
+	for (; *pos < length && text[*pos] != '.'; ++*pos)
+		value = value * 10 + (u32)(text[*pos] - '0');
+	return value;
+}
+/* text[0, length) is an optional '-' then digits with two '.', checked by the same rules as always */
+internal void parse_date(const char *text, size_t length, date_t *date) {
+	const int len = (int)length;
+	*date = date_default();
+	size_t pos = 0;
+	if (text[0] == '-') {
+		pos++;
+		fprintf(stdout, "[parse_token] Cannot have negative year: %.*s\n", len, text);
+	}
+	if (pos < length && text[pos] == '.') {
+		fprintf(stdout, "[parse_token] Date is missing year: %.*s\n", len, text);
+	} else
+		date->year = (u16)parse_date_part(text, length, &pos);
+	pos++;
+	if (pos < length && text[pos] == '.') {
+		fprintf(stdout, "[parse_token] Date is missing month: %.*s\n", len, text);
+	} else {
+		const u8 m = (u8)parse_date_part(text, length, &pos);
+		if (m < 1 || m > 12) {
+			fprintf(stdout, "[parse_token] Invalid month (%d) in %.*s\n", m, len, text);
+		} else date->month = m;
+	}
+	pos++;
+	if (pos < length && text[pos] == '.') {
+		fprintf(stdout, "[parse_token] Date is missing day: %.*s\n", len, text);
+	} else {
+		const u8 d = (u8)parse_date_part(text, length, &pos);
+		if (d < 1 || d > days_per_month[date->month - 1]) {
+			fprintf(stdout, "[parse_token] Invalid day (%d) in %.*s\n", d, len, text);
+		} else date->day = d;
+	}
 }
 
-boolean parse_token(string *str, struct token_t *token) {
+/* end_masks (or 0) are the token end masks of the whole buffer text is offset bytes into */
+internal size_t scan_token_masked(const char *text, size_t size, struct token_view_t *view, const u32 *end_masks, size_t offset) {
 	/*	Token types:
 			- alphanumeric (starting with letter or _)
 			- symbols ({ } = etc)
@@ -151,182 +242,278 @@ boolean parse_token(string *str, struct token_t *token) {
 			- int literal (including -ve)
 			- float literal (including -ve)
 	*/
-	if (is_alphanumeric(str->text[0])) {
+	assert(text && size && "scan_token: text is empty");
+	assert(view && "scan_token: view == 0");
+	view->text = text;
+	const u8 first_class = char_class[(u8)text[0]];
+	if (first_class & CHAR_TOKEN) {
 		size_t length = 1;
-		int points = str->text[0] == '.';
-		boolean can_be_numeric = is_number(str->text[0]) || str->text[0] == '-' || points;
-		while (length < str->length && is_alphanumeric(str->text[length])) {
-			if (can_be_numeric && !is_number(str->text[length])) {
-				if (str->text[length] == '.' && points < 2) points++;
-				else can_be_numeric = false;
-			}
-			length++;
+		int points = text[0] == '.';
+		boolean can_be_numeric = (first_class & CHAR_DIGIT) || text[0] == '-' || points;
+		/* digits are accumulated as they are classified, for ints and the decimal fast path */
+		u64 mantissa = (first_class & CHAR_DIGIT) ? (u64)(text[0] - '0') : 0;
+		u32 digits = (first_class & CHAR_DIGIT) ? 1 : 0, fraction_digits = 0;
+		/* once a byte rules out a number the rest is only a boundary search */
+		for (; can_be_numeric && length < size; ++length) {
+			const u8 c = char_class[(u8)text[length]];
+			if (!(c & CHAR_TOKEN)) break;
+			if (c & CHAR_DIGIT) {
+				mantissa = mantissa * 10 + (u64)(text[length] - '0');
+				digits++;
+				fraction_digits += points;
+			} else if (text[length] == '.' && points < 2) points++;
+			else can_be_numeric = false;
 		}
+		if (length < size && char_is(text[length], CHAR_TOKEN))
+			length = end_masks ? scan_next_token_end(end_masks, offset + length, offset + size) - offset
+				: length + scan_token_end(text + length, size - length);
+		view->length = length;
 		/* Can be: alphanumeric, int, decimal or date */
-		if (can_be_numeric) {
-			string tmp = { 0 };
-			string_extract(&tmp, str->text, length);
-			assert(tmp.text && "parse_token: (number) tmp.text == 0");
-			if (points == 0)
-				token_init_int(token, atoi(tmp.text));
-			else if (points == 1)
-				token_init_decimal(token, atof(tmp.text));
-			else if (points == 2) {
-				date_t date = date_default();
-				int pos = 0;
-				if (tmp.text[0] == '-') {
-					pos++;
-					fprintf(stdout, "[parse_token] Cannot have negative year: %s\n", tmp.text);
-				}
-				if (tmp.text[pos] == '.') {
-					pos++;
-					fprintf(stdout, "[parse_token] Date is missing year: %s\n", tmp.text);
-				} else {
-					int pos2 = pos;
-					while (tmp.text[++pos2] && tmp.text[pos2] != '.');
-					string tmp2 = { 0 };
-					string_extract(&tmp2, &tmp.text[pos], pos2 - pos);
-					date.year = atoi(tmp2.text);
-					string_clear(&tmp2);
-					pos = pos2 + 1;
-				}
-				if (tmp.text[pos] == '.') {
-					pos++;
-					fprintf(stdout, "[parse_token] Date is missing month: %s\n", tmp.text);
-				} else {
-					int pos3 = pos;
-					while (tmp.text[++pos3] && tmp.text[pos3] != '.');
-					string tmp3 = { 0 };
-					string_extract(&tmp3, &tmp.text[pos], pos3 - pos);
-					u8 m = atoi(tmp3.text);
-					string_clear(&tmp3);
-					if (m < 1 || m > 12) {
-						fprintf(stdout, "[parse_token] Invalid month (%d) in %s\n", m, tmp.text);
-					} else date.month = m;
-					pos = pos3 + 1;
-				}
-				if (tmp.text[pos] == '.') {
-					pos++;
-					fprintf(stdout, "[parse_token] Date is missing day: %s\n", tmp.text);
-				} else {
-					int pos4 = pos;
-					while (tmp.text[++pos4] && tmp.text[pos4] != '.');
-					string tmp4 = { 0 };
-					string_extract(&tmp4, &tmp.text[pos], pos4 - pos);
-					u8 d = atoi(tmp4.text);
-					string_clear(&tmp4);
-					if (d < 1 || d > days_per_month[date.month - 1]) {
-						fprintf(stdout, "[parse_token] Invalid day (%d) in %s\n", d, tmp.text);
-					} else date.day = d;
-				}
-				string_clear(&tmp);
-				token_init_date(token, &date);
-			} else {
-				token_init_unknown(token);
-				fprintf(stdout, "[parse_token] Incompatible point-count (%u) in: %s\n", points, tmp.text);
-				string_clear(&tmp);
-				return false;
-			}
-			string_clear(&tmp);
-			str->text += length;
-			str->length -= length;
-			return true;
+		if (!can_be_numeric)
+			view->type = ALPHANUMERIC;
+		else if (points == 0) { /* wraps like atoi does on overflow */
+			const boolean negative = text[0] == '-';
+			view->type = INT_TOKEN;
+			view->data.i = (int)(negative ? 0u - (u32)mantissa : (u32)mantissa);
+		} else if (points == 1) {
+			const boolean negative = text[0] == '-';
+			view->type = DECIMAL_TOKEN;
+			view->data.d = parse_decimal(text, length, negative, mantissa, digits, fraction_digits);
+			/* mantissa has wrapped past 19 digits, the slow path reads the text again */
+			if (!(digits <= 19 ? fixed_from_digits(mantissa, fraction_digits, negative, &view->data.fixed) : fixed_parse(text, length, &view->data.fixed)))
+				view->data.fixed = fixed_from_double(view->data.d);
 		} else {
-			string tmp = { 0 };
-			string_extract(&tmp, str->text, length);
-			token_init_alphanumeric(token, &tmp, false);
-			str->text += length;
-			str->length -= length;
-			return true;
+			view->type = DATE_TOKEN;
+			parse_date(text, length, &view->data.date);
 		}
-	} else if (is_symbol(str->text[0])) {
-		token_init_symbol(token, str->text[0]);
-		str->text++;
-		str->length--;
-		return true;
-	} else if (is_string_signifier(str->text[0])) {	/* STRING */
-		size_t length = 1;
-		while (length < str->length && str->text[length] != str->text[0]) length++;
-		string tmp = { 0 };
-		string_extract(&tmp, str->text + 1, length - 1);
-		token_init_string(token, &tmp, false);
-		if (length < str->length) length++;
-		str->text += length;
-		str->length -= length;
-		return true;
+		return length;
+	} else if (first_class & CHAR_SYMBOL) {
+		view->type = SYMBOL;
+		view->length = 1;
+		view->data.sym = text[0];
+		return 1;
+	} else if (first_class & CHAR_QUOTE) {	/* STRING */
+		size_t length = 1 + scan_string_end(text + 1, size - 1, text[0]);
+		view->type = STRING;
+		view->text = text + 1;
+		view->length = length - 1;
+		if (length < size && text[length] == text[0]) length++;
+		return length;
 	} else {
+		view->type = UNKNOWN;
+		view->length = 0;
+		return 0;
+	}
+}
+size_t scan_token(const char *text, size_t size, struct token_view_t *view) {
+	return scan_token_masked(text, size, view, 0, 0);
+}
+void token_from_view(struct token_t *token, const struct token_view_t *view) {
+	assert(token && "token_from_view: token == 0");
+	assert(view && "token_from_view: view == 0");
+	string tmp = { 0 };
+	switch (view->type) {
+	case ALPHANUMERIC:
+		string_extract(&tmp, view->text, view->length);
+		token_init_alphanumeric(token, &tmp, false);
+		break;
+	case STRING:
+		string_extract(&tmp, view->text, view->length);
+		token_init_string(token, &tmp, false);
+		break;
+	case SYMBOL:
+		token_init_symbol(token, view->data.sym);
+		break;
+	case INT_TOKEN:
+		token_init_int(token, view->data.i);
+		break;
+	case DECIMAL_TOKEN:
+		token_init_decimal(token, view->data.d, view->data.fixed);
+		break;
+	case DATE_TOKEN:
+		token_init_date(token, &view->data.date);
+		break;
+	default:
+		token_init_unknown(token);
+		break;
+	}
+}
+
+internal void print_unknown_token(const char *text, size_t length) {
+	string_builder_t escaped = { 0 };
+	builder_append_escaped(&escaped, text, length);
+	fprintf(stdout, "[parse_token] Unknown token: %s\n", builder_text(&escaped));
+	builder_free(&escaped);
+}
+
+internal boolean parse_token(const char **text, size_t *length, struct token_t *token) {
+	struct token_view_t view;
+	const size_t token_length = scan_token(*text, *length, &view);
+	if (!token_length) {
+		print_unknown_token(*text, scan_line_end(*text, *length));
 		token_init_unknown(token);
-		fprintf(stdout, "[parse_token] Unknown token: %s\n", str->text);
 		return false;
 	}
+	token_from_view(token, &view);
+	*text += token_length;
+	*length -= token_length;
+	return true;
 }
 
-boolean string_next_token(string *str, struct token_t *token) {
-	assert(str && "string_next_token: str == 0");
+boolean string_next_token(const char **text, size_t *length, struct token_t *token) {
+	assert(text && *text && "string_next_token: text == 0");
+	assert(length && "string_next_token: length == 0");
 	assert(token && "string_next_token: token == 0");
-	while (str->length > 0 && is_whitespace(str->text[0])) {
-		str->text++;
-		str->length--;
-	}
-	if (str->length == 0 || str->text[0] == '#' || (str->length > 1 && str->text[0] == '-' && str->text[1] == '-')) {
+	size_t skip = 0;
+	while (skip < *length && char_is((*text)[skip], CHAR_WHITESPACE)) skip++;
+	*text += skip;
+	*length -= skip;
+	if (*length == 0 || char_is((*text)[0], CHAR_COMMENT) || (*length > 1 && (*text)[0] == '-' && (*text)[1] == '-')) {
 		token_init_unknown(token);
 		return false;
 	}
-	//return parse_token(str, token);
-	const char *line = str->text;
-	boolean ret = parse_token(str, token);
-	
-	/*fprintf(stdout, "TOKEN: ");
-	token_print(stdout, token);
-	fprintf(stdout, " (from: %s)\n", line);*/
-	
-	return ret;
+	return parse_token(text, length, token);
+}
+
+/* reads the whole file with stdio, for files platform_map_file can't handle */
+internal int script_file_read(script_file_t *file, const char *filename) {
+	FILE *fp;
+	const int err = fopen_s(&fp, filename, "rb");
+	if (err) return err;
+	size_t capacity = 0;
+	while (true) {
+		if (file->size == capacity) {
+			capacity = capacity ? 2 * capacity : 4096;
+			file->buffer = realloc_s(file->buffer, capacity);
+			assert(file->buffer && "script_file_read: realloc failed");
+		}
+		const size_t read = fread(file->buffer + file->size, 1, capacity - file->size, fp);
+		if (read == 0) break;
+		file->size += read;
+	}
+	fclose(fp);
+	file->text = file->buffer;
+	return 0;
+}
+int script_file_open(script_file_t *file, const char *filename) {
+	assert(file && "script_file_open: file == 0");
+	assert(filename && "script_file_open: filename == 0");
+	memset(file, 0, sizeof(script_file_t));
+	if (platform_map_file(&file->map, filename) == 0) {
+		file->text = (const char *)file->map.data;
+		file->size = file->map.size;
+		return 0;
+	}
+	return script_file_read(file, filename);
+}
+void script_file_close(script_file_t *file) {
+	assert(file && "script_file_close: file == 0");
+	platform_unmap_file(&file->map);
+	free_s(file->buffer);
+	memset(file, 0, sizeof(script_file_t));
+}
+
+internal boolean scan_next(const char *text, size_t size, const u32 *end_masks, size_t *pos, size_t *line_number, struct token_view_t *view, boolean strict) {
+	size_t p = *pos, lines = 0;
+	while (true) {
+		/* whitespace and line ends */
+		while (p < size) {
+			const u8 c = char_class[(u8)text[p]];
+			if (c & CHAR_WHITESPACE) p++;
+			else if (c & CHAR_NEWLINE) {
+				p += (text[p] == '\r' && p + 1 < size && text[p + 1] == '\n') ? 2 : 1;
+				lines++;
+			} else break;
+		}
+		if (p == size) {
+			view->type = UNKNOWN;
+			break;
+		}
+		/* comments and unreadable tokens lose the rest of their line */
+		if (!char_is(text[p], CHAR_COMMENT) && !(text[p] == '-' && p + 1 < size && text[p + 1] == '-')) {
+			const size_t length = scan_token_masked(text + p, size - p, view, end_masks, p);
+			if (length) {
+				p += length;
+				break;
+			}
+			/* at least the byte that couldn't be read, a NUL is a line end of length 0 */
+			const size_t line_length = MAX(1, scan_line_end(text + p, size - p));
+			if (strict) {
+				view->text = text + p;
+				view->length = line_length;
+				*pos = p + line_length;
+				*line_number += lines;
+				return true;
+			}
+			print_unknown_token(text + p, line_length);
+			p += line_length;
+			continue;
+		}
+		p += scan_line_end(text + p, size - p);
+	}
+	*pos = p;
+	*line_number += lines;
+	return view->type != UNKNOWN;
+}
+boolean token_scan_next(const char *text, size_t size, size_t *pos, size_t *line_number, struct token_view_t *view) {
+	assert((text || !size) && "token_scan_next: text == 0");
+	assert(pos && "token_scan_next: pos == 0");
+	assert(line_number && "token_scan_next: line_number == 0");
+	assert(view && "token_scan_next: view == 0");
+	return scan_next(text, size, 0, pos, line_number, view, false);
+}
+boolean token_scan_next_strict(const char *text, size_t size, size_t *pos, size_t *line_number, struct token_view_t *view) {
+	assert((text || !size) && "token_scan_next_strict: text == 0");
+	assert(pos && "token_scan_next_strict: pos == 0");
+	assert(line_number && "token_scan_next_strict: line_number == 0");
+	assert(view && "token_scan_next_strict: view == 0");
+	return scan_next(text, size, 0, pos, line_number, view, true);
+}
+boolean token_scan_next_masked(const char *text, size_t size, const u32 *end_masks, size_t *pos, size_t *line_number, struct token_view_t *view) {
+	assert((text || !size) && "token_scan_next_masked: text == 0");
+	assert((end_masks || !size) && "token_scan_next_masked: end_masks == 0");
+	assert(pos && "token_scan_next_masked: pos == 0");
+	assert(line_number && "token_scan_next_masked: line_number == 0");
+	assert(view && "token_scan_next_masked: view == 0");
+	return scan_next(text, size, end_masks, pos, line_number, view, false);
 }
 
 int token_source_init(struct token_source_t *src, const char *filename) {
 	assert(src && "token_source_init: src == 0");
 	assert(filename && "token_source_init: filename == 0");
+	memset(src, 0, sizeof(struct token_source_t));
 	string_set_c(&src->filename, filename);
-	string_set_c(&src->line, 0);
-	src->unread = src->line;
-	src->line_number = 0;
-	int ret = file_open(&src->file, filename);
-	if (ret) fprintf(stdout, "[token_source_init] Failed to open file: %s (error code: %d)\n", filename, ret);
+	const int ret = script_file_open(&src->file, filename);
+	if (ret) {
+		fprintf(stdout, "[token_source_init] Failed to open file: %s (error code: %d)\n", filename, ret);
+		string_clear(&src->filename);
+	}
+	/* the first line starts straight away, the others once the line end before them has been passed */
+	src->line_number = src->file.size ? 1 : 0;
 	return ret;
 }
 void token_source_free(struct token_source_t *src) {
 	assert(src && "token_source_free: src == 0");
-	file_close(&src->file);
+	script_file_close(&src->file);
 	string_clear(&src->filename);
-	string_clear(&src->line);
 	token_free(&src->peek_token);
 	memset(src, 0, sizeof(struct token_source_t));
 }
 void token_source_clear_line(struct token_source_t *src) {
 	assert(src && "token_source_clear_line: src == 0");
-	string_clear(&src->line);
-	src->unread = src->line;
+	src->pos += scan_line_end(src->file.text + src->pos, src->file.size - src->pos);
 }
 /* returns true if another token is found, false if the file ends with no token */
 boolean token_source_next(struct token_source_t *src, struct token_t *token) {
 	assert(src && "token_source_next: src == 0");
-	assert(src->file.fp && "token_source_next: src->file.fp == 0");
 	assert(token && "token_source_free: token == 0");
 	token_free(token);
 
 	if (src->peek_token.type == UNKNOWN) {
-		while (true) {
-			while (src->unread.length == 0) {
-				if (!file_read_line(&src->file, &src->line)) {	/* file reading fails */
-					file_close(&src->file);
-					return false;
-				}
-				src->unread = src->line;
-				src->line_number++;
-			}
-			if (string_next_token(&src->unread, token)) return true;
-			else src->unread.length = 0;
-		}
+		struct token_view_t view;
+		if (!token_scan_next(src->file.text, src->file.size, &src->pos, &src->line_number, &view)) return false;
+		token_from_view(token, &view);
+		return true;
 	} else {
 		*token = src->peek_token;
 		memset(&src->peek_token, 0, sizeof(struct token_t));
@@ -335,7 +522,6 @@ boolean token_source_next(struct token_source_t *src, struct token_t *token) {
 }
 boolean token_source_peek(struct token_source_t *src) {
 	assert(src && "token_source_next: src == 0");
-	assert(src->file.fp && "token_source_next: src->file.fp == 0");
 	if (src->peek_token.type == UNKNOWN) {
 		return token_source_next(src, &src->peek_token);
 	} else return true;
@@ -346,13 +532,13 @@ int token_source_expect_symbol(struct token_source_t *src, char sym, const char
 	struct token_t token = { 0 };
 	if (!token_source_next(src, &token)) {
 		token_free(&token);
-		fprintf(stdout, "[%s] Missing token (expected '%c' for %s) [line:%zu|%s]\n", func_name, sym, purpose, src->line_number, src->filename.text);
+		fprintf(stdout, "[%s] Missing token (expected '%c' for %s) [line:%zu|%s]\n", func_name, sym, purpose, src->line_number, string_text(&src->filename));
 		return ERROR_RETURN;
 	}
 	if (token.type != SYMBOL || token.data.sym != sym) {
 		fprintf(stdout, "[%s] Invalid token (expected '%c' for %s): ", func_name, sym, purpose);
 		token_print(stdout, &token);
-		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, src->filename.text);
+		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, string_text(&src->filename));
 		token_free(&token);
 		return ERROR_RETURN;
 	}
@@ -364,13 +550,13 @@ int token_source_expect_alphanumeric(struct token_source_t *src, const char *alp
 	struct token_t token = { 0 };
 	if (!token_source_next(src, &token)) {
 		token_free(&token);
-		fprintf(stdout, "[%s] Missing token (expected \"%s\" for %s) [line:%zu|%s]\n", func_name, alphanumeric, purpose, src->line_number, src->filename.text);
+		fprintf(stdout, "[%s] Missing token (expected \"%s\" for %s) [line:%zu|%s]\n", func_name, alphanumeric, purpose, src->line_number, string_text(&src->filename));
 		return ERROR_RETURN;
 	}
 	if (token.type != ALPHANUMERIC || !string_equal_c(&token.data.str, alphanumeric)) {
 		fprintf(stdout, "[%s] Invalid token (expected \"%s\" for %s): ", func_name, alphanumeric, purpose);
 		token_print(stdout, &token);
-		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, src->filename.text);
+		fprintf(stdout, " [line:%zu|%s]\n", src->line_number, string_text(&src->filename));
 		token_free(&token);
 		return ERROR_RETURN;
 	}
@@ -398,7 +584,7 @@ int token_source_get_int(struct token_source_t *src, int *i, const char *func_na
 	*i = token.data.i;
 	return 0;
 }
-int token_source_get_decimal(struct token_source_t *src, double *d, const char *func_name, const char *purpose) {
+int token_source_get_decimal(struct token_source_t *src, decimal_t *d, const char *func_name, const char *purpose) {
 	assert(src && "token_source_get_decimal: src == 0");
 	assert(d && "token_source_get_decimal: d == 0");
 	struct token_t token = { 0 };
@@ -414,10 +600,10 @@ int token_source_get_decimal(struct token_source_t *src, double *d, const char *
 		token_free(&token);
 		return ERROR_RETURN;
 	}
-	*d = token.data.d;
+	*d = token_decimal(&token);
 	return 0;
 }
-int token_source_get_decimal_or_int(struct token_source_t *src, double *d, const char *func_name, const char *purpose) {
+int token_source_get_decimal_or_int(struct token_source_t *src, decimal_t *d, const char *func_name, const char *purpose) {
 	assert(src && "token_source_get_decimal_or_int: src == 0");
 	assert(d && "token_source_get_decimal_or_int: d == 0");
 	struct token_t token = { 0 };
@@ -426,10 +612,8 @@ int token_source_get_decimal_or_int(struct token_source_t *src, double *d, const
 		fprintf(stdout, "[%s] Missing token (expected decimal or int for %s) [line:%zu]\n", func_name, purpose, src->line_number);
 		return ERROR_RETURN;
 	}
-	if (token.type == DECIMAL_TOKEN)
-		*d = token.data.d;
-	else if (token.type == INT_TOKEN)
-		*d = (double)token.data.i;
+	if (token.type == DECIMAL_TOKEN || token.type == INT_TOKEN)
+		*d = token_decimal(&token);
 	else {
 		fprintf(stdout, "[%s] Invalid token (expected decimal or int for %s): ", func_name, purpose);
 		token_print(stdout, &token);
@@ -521,7 +705,7 @@ int token_source_get_bool(struct token_source_t *src, boolean *b, const char *fu
 		*b = false;
 	else {
 		token_free(&token);
-		fprintf(stdout, "[%s] Expected bool for %s, couldn't understand: %s [line:%zu]\n", func_name, purpose, token.data.str.text, src->line_number);
+		fprintf(stdout, "[%s] Expected bool for %s, couldn't understand: %s [line:%zu]\n", func_name, purpose, string_text(&token.data.str), src->line_number);
 		return ERROR_RETURN;
 	}
 	token_free(&token);
@@ -1,9 +1,27 @@
 #pragma once
 
-#include "file.h"
+#include "string_wrapper.h"
+#include "fixed_point.h"
+#include "platform.h"
 
 #include <stdio.h>
 
+/* Character classes, one table lookup per byte. A byte can be in several classes ('#' is a comment start
+	but can also appear inside a token, digits are also token characters). */
+#define CHAR_ALPHA		0x01	/* a-z, A-Z and any byte >= 0x80 */
+#define CHAR_DIGIT		0x02	/* 0-9 */
+#define CHAR_SYMBOL		0x04	/* = { } ; , */
+#define CHAR_WHITESPACE	0x08	/* space, \t, \v, \f */
+#define CHAR_NEWLINE	0x10	/* \n, \r */
+#define CHAR_QUOTE		0x20	/* ' " */
+#define CHAR_COMMENT	0x40	/* # (-- is also a comment, but needs two bytes) */
+#define CHAR_TOKEN		0x80	/* part of an alphanumeric/numeric token: every byte but \0 and CHAR_DELIMITER */
+/* bytes that end an alphanumeric/numeric token */
+#define CHAR_DELIMITER	(CHAR_SYMBOL | CHAR_WHITESPACE | CHAR_NEWLINE | CHAR_QUOTE)
+
+extern const u8 char_class[256];
+#define char_is(c, classes) (char_class[(u8)(c)] & (classes))
+
 /* Helper functions */
 boolean is_alpha(char c);
 boolean is_number(char c);
@@ -42,7 +60,10 @@ struct token_t {
 		string str;
 		char sym;
 		int i;
-		double d;
+		struct {	/* DECIMAL_TOKEN: both forms, the fixed point one rounded from the digits rather than from d */
+			double d;
+			fixed_t fixed;
+		};
 		date_t date;
 	} data;
 };
@@ -51,27 +72,66 @@ void token_init_alphanumeric(struct token_t *token, const string *str, boolean c
 void token_init_symbol(struct token_t *token, char sym);
 void token_init_string(struct token_t *token, const string *str, boolean copy);
 void token_init_int(struct token_t *token, int i);
-void token_init_decimal(struct token_t *token, double d);
+void token_init_decimal(struct token_t *token, double d, fixed_t fixed);
 void token_init_date(struct token_t *token, const date_t *date);
 void token_free(struct token_t *token);
 struct token_t token_move(struct token_t *token);
 void token_print(FILE *const stream, const struct token_t *token);
 size_t token_sprint(char *const buffer, size_t buffer_count, const struct token_t *token);
+/* the value of a DECIMAL_TOKEN or INT_TOKEN as the database's decimal type */
+decimal_t token_decimal(const struct token_t *token);
+
+/* A token found in place, without allocating: text/length is where it is in the source (a string's
+	contents, without the quotes) and data holds the parsed value of every type but ALPHANUMERIC/STRING. */
+struct token_view_t {
+	enum token_type_t type;
+	const char *text;
+	size_t length;
+	union token_data_t data;
+};
+/* the token at the start of text[0, size), returns the bytes it takes up (quotes included), or 0 if there is
+	no valid token there */
+size_t scan_token(const char *text, size_t size, struct token_view_t *view);
+/* the next token from text[*pos, size), skipping whitespace, comments and unknown tokens. *pos moves past it
+	and *line_number counts the line ends passed on the way. Returns false at the end of text. */
+boolean token_scan_next(const char *text, size_t size, size_t *pos, size_t *line_number, struct token_view_t *view);
+/* the same, but instead of printing and skipping an unknown token it returns it as an UNKNOWN view of the rest
+	of its line (which *pos moves past), for callers that report errors themselves */
+boolean token_scan_next_strict(const char *text, size_t size, size_t *pos, size_t *line_number, struct token_view_t *view);
+/* token_scan_next with the token ends of all of text from scan_token_end_masks, for tokenizing a whole buffer */
+boolean token_scan_next_masked(const char *text, size_t size, const u32 *end_masks, size_t *pos, size_t *line_number, struct token_view_t *view);
+/* copies the view into a token, strings are allocated */
+void token_from_view(struct token_t *token, const struct token_view_t *view);
+
+/* *text and *length walk through another string's characters, so they move past each token without the
+	string losing its beginning */
+boolean string_next_token(const char **text, size_t *length, struct token_t *token);
+
+/* A whole script file in memory: mapped, or read if it can't be (e.g. because it is empty) */
+typedef struct script_file_s {
+	platform_file_map_t map;
+	char *buffer;	/* the file's contents when it couldn't be mapped */
+	const char *text;
+	size_t size;
+} script_file_t;
 
-/* str here contains a pointer to another string's characters, so we can increment it
-	to move through the string without losing its beginning */
-boolean string_next_token(string *str, struct token_t *token);
+int script_file_open(script_file_t *file, const char *filename);
+void script_file_close(script_file_t *file);
 
+/* Tokenizes a whole file in place: tokens are found directly in the script_file_t, counting line ends as they
+	are passed. \n, \r and \r\n each end a line, so line numbers match what the game reports for both Windows
+	and Unix line endings. */
 struct token_source_t {
-	file_t file;
+	script_file_t file;
+	size_t pos;
 	string filename;
-	string line, unread;
 	size_t line_number;
 	struct token_t peek_token;
 };
 
 int token_source_init(struct token_source_t *src, const char *filename);
 void token_source_free(struct token_source_t *src);
+/* skips the rest of the line the last token was on */
 void token_source_clear_line(struct token_source_t *src);
 /* returns true if another token is found, false if the file ends with no token */
 boolean token_source_next(struct token_source_t *src, struct token_t *token);
@@ -80,8 +140,8 @@ int token_source_expect_symbol(struct token_source_t *src, char sym, const char
 int token_source_expect_alphanumeric(struct token_source_t *src, const char *alphanumeric, const char *func_name, const char *purpose);
 
 int token_source_get_int(struct token_source_t *src, int *i, const char *func_name, const char *purpose);
-int token_source_get_decimal(struct token_source_t *src, double *d, const char *func_name, const char *purpose);
-int token_source_get_decimal_or_int(struct token_source_t *src, double *d, const char *func_name, const char *purpose);
+int token_source_get_decimal(struct token_source_t *src, decimal_t *d, const char *func_name, const char *purpose);
+int token_source_get_decimal_or_int(struct token_source_t *src, decimal_t *d, const char *func_name, const char *purpose);
 int token_source_get_string(struct token_source_t *src, string *str, const char *func_name, const char *purpose);
 int token_source_get_alphanumeric(struct token_source_t *src, string *str, const char *func_name, const char *purpose);
 int token_source_get_date(struct token_source_t *src, date_t *date, const char *func_name, const char *purpose);
@@ -0,0 +1,207 @@
+#include "pixel_convert.h"
+
+#include "platform.h"
+#include "assert_opt.h"
+#include "maths.h"
+
+#ifdef PLATFORM_X86
+#include <immintrin.h>
+#endif
+
+typedef void(*convert_row_func_t)(u32 *dest, const u8 *src, s32 count);
+
+/* SCALAR */
+internal void convert_bgr24_scalar(u32 *dest, const u8 *src, s32 count) {
+	for (s32 i = 0; i < count; ++i, src += 3)
+		dest[i] = 0xFF000000 | ((u32)src[2] << 16) | ((u32)src[1] << 8) | (u32)src[0];
+}
+internal void convert_abgr32_scalar(u32 *dest, const u8 *src, s32 count) {
+	for (s32 i = 0; i < count; ++i, src += 4)
+		dest[i] = ((u32)src[0] << 24) | ((u32)src[3] << 16) | ((u32)src[2] << 8) | (u32)src[1];
+}
+internal void convert_rgba32_scalar(u32 *dest, const u8 *src, s32 count) {
+	for (s32 i = 0; i < count; ++i, src += 4)
+		dest[i] = ((u32)src[3] << 24) | ((u32)src[0] << 16) | ((u32)src[1] << 8) | (u32)src[2];
+}
+
+#ifdef PLATFORM_X86
+/* Shuffle masks: byte k of the output pixel comes from byte mask[k] of the input. Output pixels are
+	0xAARRGGBB, i.e. b, g, r, a in memory. -1 produces a zero byte, which the alpha or fills in. */
+#define SHUFFLE_BGR24 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+#define SHUFFLE_ABGR32 1, 2, 3, 0, 5, 6, 7, 4, 9, 10, 11, 8, 13, 14, 15, 12
+#define SHUFFLE_RGBA32 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15
+
+/* SSE2 (always available on x64): 32-bit swizzles are done with shifts, 24-bit needs a byte shuffle */
+TARGET("sse2") internal void convert_abgr32_sse2(u32 *dest, const u8 *src, s32 count) {
+	s32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		/* each little endian word is 0xRRGGBBAA, rotate right by 8 */
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(_mm_srli_epi32(v, 8), _mm_slli_epi32(v, 24)));
+	}
+	convert_abgr32_scalar(dest + i, src + 4 * i, count - i);
+}
+TARGET("sse2") internal void convert_rgba32_sse2(u32 *dest, const u8 *src, s32 count) {
+	const __m128i mask_ag = _mm_set1_epi32((int)0xFF00FF00);
+	const __m128i mask_low = _mm_set1_epi32(0xFF);
+	s32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		/* each little endian word is 0xAABBGGRR, swap bytes 0 and 2 */
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		const __m128i r = _mm_slli_epi32(_mm_and_si128(v, mask_low), 16);
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(v, 16), mask_low);
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(_mm_and_si128(v, mask_ag), _mm_or_si128(r, b)));
+	}
+	convert_rgba32_scalar(dest + i, src + 4 * i, count - i);
+}
+
+/* SSSE3 */
+TARGET("ssse3") internal void convert_bgr24_ssse3(u32 *dest, const u8 *src, s32 count) {
+	const __m128i shuffle = _mm_setr_epi8(SHUFFLE_BGR24);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	s32 i = 0;
+	/* 4 pixels per iteration, but the 16 byte load reads 4 bytes past them */
+	for (; i + 6 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+	}
+	convert_bgr24_scalar(dest + i, src + 3 * i, count - i);
+}
+TARGET("ssse3") internal void convert_abgr32_ssse3(u32 *dest, const u8 *src, s32 count) {
+	const __m128i shuffle = _mm_setr_epi8(SHUFFLE_ABGR32);
+	s32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_shuffle_epi8(v, shuffle));
+	}
+	convert_abgr32_scalar(dest + i, src + 4 * i, count - i);
+}
+TARGET("ssse3") internal void convert_rgba32_ssse3(u32 *dest, const u8 *src, s32 count) {
+	const __m128i shuffle = _mm_setr_epi8(SHUFFLE_RGBA32);
+	s32 i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(src + 4 * i));
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_shuffle_epi8(v, shuffle));
+	}
+	convert_rgba32_scalar(dest + i, src + 4 * i, count - i);
+}
+
+/* AVX2: the shuffle works within each 128-bit lane, so every lane is given its own 16 source bytes */
+TARGET("avx2") internal void convert_bgr24_avx2(u32 *dest, const u8 *src, s32 count) {
+	const __m256i shuffle = _mm256_setr_epi8(SHUFFLE_BGR24, SHUFFLE_BGR24);
+	const __m256i alpha = _mm256_set1_epi32((int)0xFF000000);
+	s32 i = 0;
+	/* 8 pixels per iteration, the upper lane's load ends 28 bytes after the first pixel */
+	for (; i + 10 <= count; i += 8) {
+		const __m128i lo = _mm_loadu_si128((const __m128i *)(src + 3 * i));
+		const __m128i hi = _mm_loadu_si128((const __m128i *)(src + 3 * i + 12));
+		const __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+	}
+	convert_bgr24_ssse3(dest + i, src + 3 * i, count - i);
+}
+TARGET("avx2") internal void convert_abgr32_avx2(u32 *dest, const u8 *src, s32 count) {
+	const __m256i shuffle = _mm256_setr_epi8(SHUFFLE_ABGR32, SHUFFLE_ABGR32);
+	s32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(v, shuffle));
+	}
+	convert_abgr32_ssse3(dest + i, src + 4 * i, count - i);
+}
+TARGET("avx2") internal void convert_rgba32_avx2(u32 *dest, const u8 *src, s32 count) {
+	const __m256i shuffle = _mm256_setr_epi8(SHUFFLE_RGBA32, SHUFFLE_RGBA32);
+	s32 i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(src + 4 * i));
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_shuffle_epi8(v, shuffle));
+	}
+	convert_rgba32_ssse3(dest + i, src + 4 * i, count - i);
+}
+#endif
+
+typedef enum convert_isa_e {
+	ISA_SCALAR, ISA_SSE2, ISA_SSSE3, ISA_AVX2
+} convert_isa_t;
+
+internal const char *isa_names[] = { "scalar", "sse2", "ssse3", "avx2" };
+
+internal convert_isa_t convert_isa = ISA_SCALAR;
+internal convert_row_func_t converters[PIXEL_FORMAT_COUNT] = { 0 };
+
+/* picks the best converters for this cpu, racing calls all write the same values */
+internal void converters_init(void) {
+	convert_isa_t isa = ISA_SCALAR;
+	convert_row_func_t funcs[PIXEL_FORMAT_COUNT] = {
+		[PIXEL_FORMAT_BGR24] = convert_bgr24_scalar,
+		[PIXEL_FORMAT_ABGR32] = convert_abgr32_scalar,
+		[PIXEL_FORMAT_RGBA32] = convert_rgba32_scalar
+	};
+#ifdef PLATFORM_X86
+#ifdef PLATFORM_SSE2
+	isa = ISA_SSE2;
+	funcs[PIXEL_FORMAT_ABGR32] = convert_abgr32_sse2;
+	funcs[PIXEL_FORMAT_RGBA32] = convert_rgba32_sse2;
+#endif
+	if (platform_cpu_has_ssse3()) {
+		isa = ISA_SSSE3;
+		funcs[PIXEL_FORMAT_BGR24] = convert_bgr24_ssse3;
+		funcs[PIXEL_FORMAT_ABGR32] = convert_abgr32_ssse3;
+		funcs[PIXEL_FORMAT_RGBA32] = convert_rgba32_ssse3;
+	}
+	if (platform_cpu_has_avx2()) {
+		isa = ISA_AVX2;
+		funcs[PIXEL_FORMAT_BGR24] = convert_bgr24_avx2;
+		funcs[PIXEL_FORMAT_ABGR32] = convert_abgr32_avx2;
+		funcs[PIXEL_FORMAT_RGBA32] = convert_rgba32_avx2;
+	}
+#endif
+	for (int i = 0; i < PIXEL_FORMAT_COUNT; ++i)
+		converters[i] = funcs[i];
+	convert_isa = isa;
+}
+
+u32 pixel_format_size(pixel_format_t format) {
+	assert(format < PIXEL_FORMAT_COUNT && "pixel_format_size: invalid format");
+	return format == PIXEL_FORMAT_BGR24 ? 3 : 4;
+}
+
+void pixel_convert_row(pixel_format_t format, u32 *dest, const u8 *src, s32 count) {
+	assert(format < PIXEL_FORMAT_COUNT && "pixel_convert_row: invalid format");
+	assert(dest && "pixel_convert_row: dest == 0");
+	assert(src && "pixel_convert_row: src == 0");
+	if (!converters[format]) converters_init();
+	converters[format](dest, src, count);
+}
+
+/* rows smaller than this many pixels aren't worth a thread */
+#define CONVERT_MIN_BATCH_PIXELS (1 << 18)
+
+typedef struct convert_image_t {
+	pixel_format_t format;
+	u32 *dest;
+	const u8 *src;
+	ptrdiff_t src_stride;
+	s32 width;
+} convert_image_t;
+
+internal void convert_image_rows(void *user, s32 begin, s32 end) {
+	const convert_image_t *image = (const convert_image_t *)user;
+	const convert_row_func_t convert = converters[image->format];
+	for (s32 y = begin; y < end; ++y)
+		convert(image->dest + (size_t)y * image->width, image->src + y * image->src_stride, image->width);
+}
+void pixel_convert_image(pixel_format_t format, u32 *dest, const u8 *src, ptrdiff_t src_stride, s32 width, s32 height) {
+	assert(format < PIXEL_FORMAT_COUNT && "pixel_convert_image: invalid format");
+	assert(dest && "pixel_convert_image: dest == 0");
+	assert(src && "pixel_convert_image: src == 0");
+	if (width <= 0 || height <= 0) return;
+	if (!converters[format]) converters_init();
+	convert_image_t image = { .format = format, .dest = dest, .src = src, .src_stride = src_stride, .width = width };
+	parallel_for(height, MAX(1, CONVERT_MIN_BATCH_PIXELS / width), convert_image_rows, &image);
+}
+
+const char *pixel_convert_isa(void) {
+	if (!converters[0]) converters_init();
+	return isa_names[convert_isa];
+}
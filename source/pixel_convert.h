@@ -0,0 +1,28 @@
+#pragma once
+
+#include "types.h"
+
+#include <stddef.h>
+
+/* Conversion of decoded image rows into the RenderBuffer's 0xAARRGGBB pixel format.
+	Each converter has a scalar version and SSE2/SSSE3/AVX2 versions picked at runtime on x86. */
+
+typedef enum pixel_format_e {
+	PIXEL_FORMAT_BGR24,		/* 24-bit BMP: b, g, r bytes, alpha is set to 0xFF */
+	PIXEL_FORMAT_ABGR32,	/* 32-bit BMP: a, b, g, r bytes */
+	PIXEL_FORMAT_RGBA32,	/* lodepng output: r, g, b, a bytes */
+	PIXEL_FORMAT_COUNT
+} pixel_format_t;
+
+/* bytes per source pixel */
+u32 pixel_format_size(pixel_format_t format);
+
+/* convert count pixels of src into dest, src doesn't have to be aligned */
+void pixel_convert_row(pixel_format_t format, u32 *dest, const u8 *src, s32 count);
+
+/* convert a width x height image, row y of dest comes from src + y * src_stride (src_stride may be
+	negative to flip the image). Large images are split across threads. */
+void pixel_convert_image(pixel_format_t format, u32 *dest, const u8 *src, ptrdiff_t src_stride, s32 width, s32 height);
+
+/* name of the instruction set the converters are using, for benchmark output */
+const char *pixel_convert_isa(void);
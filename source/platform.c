@@ -0,0 +1,338 @@
+#include "platform.h"
+
+#include "assert_opt.h"
+#include "memory_opt.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* THREADS */
+typedef struct thread_start_t {
+	thread_func_t func;
+	void *arg;
+} thread_start_t;
+
+#ifdef _WIN32
+internal DWORD WINAPI thread_entry(LPVOID param) {
+	thread_start_t start = *(thread_start_t *)param;
+	free_s(param);
+	start.func(start.arg);
+	scratch_release();
+	return 0;
+}
+int thread_create(thread_t *thread, thread_func_t func, void *arg) {
+	assert(thread && "thread_create: thread == 0");
+	assert(func && "thread_create: func == 0");
+	thread_start_t *start = malloc_s(sizeof(thread_start_t));
+	start->func = func;
+	start->arg = arg;
+	*thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+	if (*thread == NULL) {
+		free_s(start);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+int thread_join(thread_t *thread) {
+	assert(thread && "thread_join: thread == 0");
+	if (WaitForSingleObject(*thread, INFINITE) != WAIT_OBJECT_0) return ERROR_RETURN;
+	CloseHandle(*thread);
+	*thread = NULL;
+	return 0;
+}
+void thread_sleep_ms(u32 ms) {
+	Sleep(ms);
+}
+void thread_yield(void) {
+	SwitchToThread();
+}
+
+int event_init(event_t *event) {
+	assert(event && "event_init: event == 0");
+	event->handle = CreateEvent(NULL, FALSE, FALSE, NULL);
+	return event->handle ? 0 : ERROR_RETURN;
+}
+void event_free(event_t *event) {
+	assert(event && "event_free: event == 0");
+	if (event->handle) {
+		CloseHandle(event->handle);
+		event->handle = NULL;
+	}
+}
+void event_raise(event_t *event) {
+	assert(event && "event_raise: event == 0");
+	SetEvent(event->handle);
+}
+boolean event_wait(event_t *event, u32 timeout_ms) {
+	assert(event && "event_wait: event == 0");
+	return WaitForSingleObject(event->handle, timeout_ms) == WAIT_OBJECT_0;
+}
+#else
+internal void *thread_entry(void *param) {
+	thread_start_t start = *(thread_start_t *)param;
+	free_s(param);
+	start.func(start.arg);
+	scratch_release();
+	return 0;
+}
+int thread_create(thread_t *thread, thread_func_t func, void *arg) {
+	assert(thread && "thread_create: thread == 0");
+	assert(func && "thread_create: func == 0");
+	thread_start_t *start = malloc_s(sizeof(thread_start_t));
+	start->func = func;
+	start->arg = arg;
+	if (pthread_create(thread, NULL, thread_entry, start)) {
+		free_s(start);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+int thread_join(thread_t *thread) {
+	assert(thread && "thread_join: thread == 0");
+	return pthread_join(*thread, NULL) ? ERROR_RETURN : 0;
+}
+void thread_sleep_ms(u32 ms) {
+	struct timespec ts = { .tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000 };
+	nanosleep(&ts, NULL);
+}
+void thread_yield(void) {
+	sched_yield();
+}
+
+int event_init(event_t *event) {
+	assert(event && "event_init: event == 0");
+	event->raised = false;
+	if (pthread_mutex_init(&event->mutex, NULL)) return ERROR_RETURN;
+	if (pthread_cond_init(&event->cond, NULL)) {
+		pthread_mutex_destroy(&event->mutex);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+void event_free(event_t *event) {
+	assert(event && "event_free: event == 0");
+	pthread_cond_destroy(&event->cond);
+	pthread_mutex_destroy(&event->mutex);
+}
+void event_raise(event_t *event) {
+	assert(event && "event_raise: event == 0");
+	pthread_mutex_lock(&event->mutex);
+	event->raised = true;
+	pthread_cond_signal(&event->cond);
+	pthread_mutex_unlock(&event->mutex);
+}
+boolean event_wait(event_t *event, u32 timeout_ms) {
+	assert(event && "event_wait: event == 0");
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+	pthread_mutex_lock(&event->mutex);
+	while (!event->raised)
+		if (pthread_cond_timedwait(&event->cond, &event->mutex, &deadline)) break;
+	const boolean ret = event->raised;
+	event->raised = false;
+	pthread_mutex_unlock(&event->mutex);
+	return ret;
+}
+#endif
+
+#ifdef _WIN32
+u32 platform_cpu_count(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? (u32)info.dwNumberOfProcessors : 1;
+}
+#else
+u32 platform_cpu_count(void) {
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+}
+#endif
+
+#ifdef PLATFORM_X86
+boolean platform_cpu_has_ssse3(void) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return TO_BOOL(info[2] & (1 << 9));
+#else
+	return TO_BOOL(__builtin_cpu_supports("ssse3"));
+#endif
+}
+boolean platform_cpu_has_avx2(void) {
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	/* the OS has to save the ymm registers (OSXSAVE + AVX, then XCR0 bits 1 and 2) */
+	if ((info[2] & (3 << 27)) != (3 << 27) || (_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return TO_BOOL(info[1] & (1 << 5));
+#else
+	return TO_BOOL(__builtin_cpu_supports("avx2"));
+#endif
+}
+#endif
+
+/* PARALLEL */
+#define PARALLEL_MAX_THREADS 64
+typedef struct parallel_range_t {
+	parallel_func_t func;
+	void *user;
+	s32 begin, end;
+} parallel_range_t;
+
+internal void parallel_range_run(void *arg) {
+	const parallel_range_t *range = (const parallel_range_t *)arg;
+	range->func(range->user, range->begin, range->end);
+}
+void parallel_for(s32 count, s32 min_batch, parallel_func_t func, void *user) {
+	assert(func && "parallel_for: func == 0");
+	if (count <= 0) return;
+	if (min_batch < 1) min_batch = 1;
+	s32 range_count = MIN((s32)platform_cpu_count(), PARALLEL_MAX_THREADS);
+	range_count = MIN(range_count, (count + min_batch - 1) / min_batch);
+	if (range_count <= 1) {
+		func(user, 0, count);
+		return;
+	}
+	parallel_range_t ranges[PARALLEL_MAX_THREADS];
+	thread_t threads[PARALLEL_MAX_THREADS];
+	boolean started[PARALLEL_MAX_THREADS] = { 0 };
+	for (s32 i = 0; i < range_count; ++i) {
+		ranges[i].func = func;
+		ranges[i].user = user;
+		ranges[i].begin = (s32)((s64)count * i / range_count);
+		ranges[i].end = (s32)((s64)count * (i + 1) / range_count);
+	}
+	for (s32 i = 1; i < range_count; ++i)
+		started[i] = thread_create(&threads[i], parallel_range_run, &ranges[i]) == 0;
+	parallel_range_run(&ranges[0]);
+	for (s32 i = 1; i < range_count; ++i) {
+		/* fall back to running it here if the thread couldn't be created */
+		if (started[i]) thread_join(&threads[i]);
+		else parallel_range_run(&ranges[i]);
+	}
+}
+
+/* TIME */
+#ifdef _WIN32
+u64 platform_ticks(void) {
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (u64)counter.QuadPart;
+}
+u64 platform_ticks_per_second(void) {
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return (u64)frequency.QuadPart;
+}
+#else
+u64 platform_ticks(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+u64 platform_ticks_per_second(void) {
+	return 1000000000ull;
+}
+#endif
+double platform_ticks_to_seconds(u64 ticks) {
+	local double seconds_per_tick = 0.0;
+	if (seconds_per_tick == 0.0) seconds_per_tick = 1.0 / (double)platform_ticks_per_second();
+	return (double)ticks * seconds_per_tick;
+}
+
+/* PAGES */
+#ifdef _WIN32
+void *platform_alloc_pages(size_t size) {
+	return VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+int platform_free_pages(void *ptr, size_t size) {
+	return VirtualFree(ptr, 0, MEM_RELEASE) ? 0 : ERROR_RETURN;
+}
+#else
+void *platform_alloc_pages(size_t size) {
+	void *ret = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return ret == MAP_FAILED ? 0 : ret;
+}
+int platform_free_pages(void *ptr, size_t size) {
+	return munmap(ptr, size) ? ERROR_RETURN : 0;
+}
+#endif
+
+/* FILE MAPPING */
+#ifdef _WIN32
+int platform_map_file(platform_file_map_t *map, const char *filename) {
+	assert(map && "platform_map_file: map == 0");
+	assert(filename && "platform_map_file: filename == 0");
+	memset(map, 0, sizeof(platform_file_map_t));
+	map->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (map->file == INVALID_HANDLE_VALUE) {
+		map->file = NULL;
+		return ERROR_RETURN;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(map->file, &size) || size.QuadPart == 0) {
+		platform_unmap_file(map);
+		return ERROR_RETURN;
+	}
+	map->size = (size_t)size.QuadPart;
+	map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (map->mapping) map->data = MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!map->data) {
+		platform_unmap_file(map);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+void platform_unmap_file(platform_file_map_t *map) {
+	assert(map && "platform_unmap_file: map == 0");
+	if (map->data) UnmapViewOfFile(map->data);
+	if (map->mapping) CloseHandle(map->mapping);
+	if (map->file) CloseHandle(map->file);
+	memset(map, 0, sizeof(platform_file_map_t));
+}
+#else
+int platform_map_file(platform_file_map_t *map, const char *filename) {
+	assert(map && "platform_map_file: map == 0");
+	assert(filename && "platform_map_file: filename == 0");
+	memset(map, 0, sizeof(platform_file_map_t));
+	const int fd = open(filename, O_RDONLY);
+	if (fd < 0) return ERROR_RETURN;
+	struct stat st;
+	if (fstat(fd, &st) || st.st_size <= 0) {
+		close(fd);
+		return ERROR_RETURN;
+	}
+	void *data = mmap(0, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* the mapping keeps the file referenced */
+	close(fd);
+	if (data == MAP_FAILED) return ERROR_RETURN;
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+	map->data = data;
+	map->size = (size_t)st.st_size;
+	return 0;
+}
+void platform_unmap_file(platform_file_map_t *map) {
+	assert(map && "platform_unmap_file: map == 0");
+	if (map->data) munmap((void *)map->data, map->size);
+	memset(map, 0, sizeof(platform_file_map_t));
+}
+#endif
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Thin portability layer: threads, atomics, monotonic time and page allocation.
+	Everything outside winmain.c and win32_tools.c should go through here rather than <windows.h>. */
+
+/* The MSVC secure CRT functions used across the codebase */
+#ifndef _WIN32
+#include <errno.h>
+#define fopen_s(file, filename, mode) ((*(file) = fopen((filename), (mode))) ? 0 : errno)
+#define sprintf_s snprintf
+#endif
+
+/* THREADS */
+#ifdef _WIN32
+typedef void *thread_t;
+#else
+#include <pthread.h>
+typedef pthread_t thread_t;
+#endif
+
+/* a global with its own copy on every thread, no constructor: starts zeroed on each thread */
+#if defined(_MSC_VER) && !defined(__clang__)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+typedef void(*thread_func_t)(void *arg);
+
+/* returns 0 if successful */
+int thread_create(thread_t *thread, thread_func_t func, void *arg);
+int thread_join(thread_t *thread);
+void thread_sleep_ms(u32 ms);
+void thread_yield(void);
+
+/* auto-reset event: a raise wakes up one waiter, or the next one to wait if nobody is waiting */
+#ifdef _WIN32
+typedef struct event_s {
+	void *handle;
+} event_t;
+#else
+typedef struct event_s {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	boolean raised;
+} event_t;
+#endif
+
+int event_init(event_t *event);
+void event_free(event_t *event);
+void event_raise(event_t *event);
+/* returns true if the event was raised, false if timeout_ms ran out first */
+boolean event_wait(event_t *event, u32 timeout_ms);
+
+/* number of logical processors, at least 1 */
+u32 platform_cpu_count(void);
+
+/* CPU FEATURES */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PLATFORM_X86
+/* always there on x64, optional on 32-bit x86 */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define PLATFORM_SSE2
+#endif
+boolean platform_cpu_has_ssse3(void);
+/* also checks the OS saves the ymm registers */
+boolean platform_cpu_has_avx2(void);
+#endif
+
+/* GCC and clang need the instruction set enabled per function, MSVC lets intrinsics be used anywhere */
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define TARGET(isa)
+#endif
+
+/* PARALLEL */
+/* called with a sub-range [begin, end) of the full range */
+typedef void(*parallel_func_t)(void *user, s32 begin, s32 end);
+/* splits [0, count) into at most platform_cpu_count() contiguous ranges of at least min_batch elements and
+	runs them concurrently, the calling thread takes the first one. Returns once all ranges are done. */
+void parallel_for(s32 count, s32 min_batch, parallel_func_t func, void *user);
+
+/* TIME */
+/* monotonic high resolution tick counter */
+u64 platform_ticks(void);
+u64 platform_ticks_per_second(void);
+double platform_ticks_to_seconds(u64 ticks);
+
+/* PAGES */
+/* returns 0 on error, otherwise zeroed memory */
+void *platform_alloc_pages(size_t size);
+/* size must match the size passed to platform_alloc_pages, returns 0 if successful */
+int platform_free_pages(void *ptr, size_t size);
+
+/* FILE MAPPING */
+/* read-only view of a whole file */
+typedef struct platform_file_map_s {
+	const u8 *data;
+	size_t size;
+#ifdef _WIN32
+	void *file, *mapping;
+#endif
+} platform_file_map_t;
+
+/* returns 0 if successful, fails for empty files */
+int platform_map_file(platform_file_map_t *map, const char *filename);
+void platform_unmap_file(platform_file_map_t *map);
+
+/* ATOMICS (sequentially consistent) */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+internal inline u32 atomic_load_u32(volatile u32 *p) { return (u32)_InterlockedOr((volatile long *)p, 0); }
+internal inline void atomic_store_u32(volatile u32 *p, u32 v) { _InterlockedExchange((volatile long *)p, (long)v); }
+internal inline u32 atomic_exchange_u32(volatile u32 *p, u32 v) { return (u32)_InterlockedExchange((volatile long *)p, (long)v); }
+internal inline u32 atomic_add_u32(volatile u32 *p, u32 v) { return (u32)_InterlockedExchangeAdd((volatile long *)p, (long)v); }
+internal inline boolean atomic_cas_u32(volatile u32 *p, u32 expected, u32 desired) {
+	return (u32)_InterlockedCompareExchange((volatile long *)p, (long)desired, (long)expected) == expected;
+}
+internal inline u64 atomic_load_u64(volatile u64 *p) { return (u64)_InterlockedOr64((volatile __int64 *)p, 0); }
+internal inline void atomic_store_u64(volatile u64 *p, u64 v) { _InterlockedExchange64((volatile __int64 *)p, (__int64)v); }
+internal inline u64 atomic_add_u64(volatile u64 *p, u64 v) { return (u64)_InterlockedExchangeAdd64((volatile __int64 *)p, (__int64)v); }
+internal inline boolean atomic_cas_u64(volatile u64 *p, u64 expected, u64 desired) {
+	return (u64)_InterlockedCompareExchange64((volatile __int64 *)p, (__int64)desired, (__int64)expected) == expected;
+}
+internal inline void *atomic_load_ptr(void *volatile *p) { return _InterlockedCompareExchangePointer(p, 0, 0); }
+internal inline void *atomic_exchange_ptr(void *volatile *p, void *v) { return _InterlockedExchangePointer(p, v); }
+#else
+internal inline u32 atomic_load_u32(volatile u32 *p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+internal inline void atomic_store_u32(volatile u32 *p, u32 v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+internal inline u32 atomic_exchange_u32(volatile u32 *p, u32 v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+internal inline u32 atomic_add_u32(volatile u32 *p, u32 v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+internal inline boolean atomic_cas_u32(volatile u32 *p, u32 expected, u32 desired) {
+	return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+internal inline u64 atomic_load_u64(volatile u64 *p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+internal inline void atomic_store_u64(volatile u64 *p, u64 v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+internal inline u64 atomic_add_u64(volatile u64 *p, u64 v) { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+internal inline boolean atomic_cas_u64(volatile u64 *p, u64 expected, u64 desired) {
+	return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+internal inline void *atomic_load_ptr(void *volatile *p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+internal inline void *atomic_exchange_ptr(void *volatile *p, void *v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+#endif
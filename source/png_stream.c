@@ -0,0 +1,477 @@
+#include "png_stream.h"
+
+#include "platform.h"
+#include "maths.h"
+#include "assert_opt.h"
+#include "memory_opt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PNG_BYTES_PER_PIXEL 3
+/* uncompressed bytes per block, blocks are the unit of work for the compression threads */
+#define PNG_BLOCK_BYTES (1 << 20)
+/* blocks allowed in flight per thread before workers wait for the writer to catch up */
+#define PNG_SLOTS_PER_THREAD 2
+
+/* CHECKSUMS */
+internal u32 crc_table[256];
+
+internal u32 crc32_update(u32 crc, const u8 *data, size_t len) {
+	for (size_t i = 0; i < len; ++i)
+		crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#define ADLER_BASE 65521
+internal u32 adler32_update(u32 adler, const u8 *data, size_t len) {
+	u32 a = adler & 0xFFFF, b = adler >> 16;
+	while (len) {
+		/* 5552 is the most bytes that can be summed before b can overflow */
+		const size_t n = MIN(len, 5552);
+		for (size_t i = 0; i < n; ++i) {
+			a += data[i];
+			b += a;
+		}
+		a %= ADLER_BASE;
+		b %= ADLER_BASE;
+		data += n;
+		len -= n;
+	}
+	return a | (b << 16);
+}
+/* adler32 of the concatenation of two sequences, given both checksums and the length of the second */
+internal u32 adler32_combine(u32 adler1, u32 adler2, size_t len2) {
+	const u32 rem = (u32)(len2 % ADLER_BASE);
+	u32 sum1 = adler1 & 0xFFFF;
+	u32 sum2 = (u32)(((u64)rem * sum1) % ADLER_BASE);
+	sum1 += (adler2 & 0xFFFF) + ADLER_BASE - 1;
+	sum2 += (adler1 >> 16) + (adler2 >> 16) + ADLER_BASE - rem;
+	if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+	if (sum1 >= ADLER_BASE) sum1 -= ADLER_BASE;
+	if (sum2 >= (ADLER_BASE << 1)) sum2 -= (ADLER_BASE << 1);
+	if (sum2 >= ADLER_BASE) sum2 -= ADLER_BASE;
+	return sum1 | (sum2 << 16);
+}
+
+/* DEFLATE: greedy LZ77 over hash chains, encoded with the fixed Huffman codes */
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+#define MAX_CHAIN 16
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define END_OF_BLOCK 256
+
+internal const u16 length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+internal const u8 length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+internal const u16 dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+	513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+internal const u8 dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+/* fixed Huffman codes, bit reversed since deflate packs bits starting from the lsb but codes msb first */
+internal u16 fixed_lit_code[288];
+internal u8 fixed_lit_bits[288];
+internal u8 fixed_dist_code[30];
+internal u8 length_code[MAX_MATCH + 1];
+/* distance code for distances 1..256 by dist - 1, above that by 256 + ((dist - 1) >> 7) */
+internal u8 dist_code[512];
+
+internal u32 reverse_bits(u32 code, u32 bits) {
+	u32 ret = 0;
+	for (u32 i = 0; i < bits; ++i, code >>= 1)
+		ret = (ret << 1) | (code & 1);
+	return ret;
+}
+/* must be called before any worker threads start */
+internal void png_tables_init(void) {
+	local boolean initialised = false;
+	if (initialised) return;
+	for (u32 i = 0; i < 256; ++i) {
+		u32 c = i;
+		for (int k = 0; k < 8; ++k)
+			c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+		crc_table[i] = c;
+	}
+	for (u32 sym = 0; sym < 288; ++sym) {
+		u32 code, bits;
+		if (sym < 144) { code = 0x30 + sym; bits = 8; }
+		else if (sym < 256) { code = 0x190 + sym - 144; bits = 9; }
+		else if (sym < 280) { code = sym - 256; bits = 7; }
+		else { code = 0xC0 + sym - 280; bits = 8; }
+		fixed_lit_code[sym] = (u16)reverse_bits(code, bits);
+		fixed_lit_bits[sym] = (u8)bits;
+	}
+	for (u32 i = 0; i < 30; ++i)
+		fixed_dist_code[i] = (u8)reverse_bits(i, 5);
+	for (u32 code = 0; code < 29; ++code) {
+		const u32 end = code == 28 ? MAX_MATCH + 1 : length_base[code + 1];
+		for (u32 len = length_base[code]; len < end; ++len)
+			length_code[len] = (u8)code;
+	}
+	for (u32 code = 0; code < 30; ++code) {
+		const u32 end = code == 29 ? WINDOW_SIZE + 1 : dist_base[code + 1];
+		for (u32 dist = dist_base[code]; dist < end; ++dist) {
+			if (dist <= 256) dist_code[dist - 1] = (u8)code;
+			else dist_code[256 + ((dist - 1) >> 7)] = (u8)code;
+		}
+	}
+	initialised = true;
+}
+
+typedef struct bit_writer_t {
+	u8 *out;
+	u64 bits;
+	u32 count;
+} bit_writer_t;
+
+internal inline void bits_put(bit_writer_t *bw, u32 value, u32 count) {
+	bw->bits |= (u64)value << bw->count;
+	bw->count += count;
+	while (bw->count >= 8) {
+		*bw->out++ = (u8)bw->bits;
+		bw->bits >>= 8;
+		bw->count -= 8;
+	}
+}
+internal inline void bits_put_literal(bit_writer_t *bw, u32 sym) {
+	bits_put(bw, fixed_lit_code[sym], fixed_lit_bits[sym]);
+}
+internal inline void bits_put_match(bit_writer_t *bw, u32 len, u32 dist) {
+	const u32 lcode = length_code[len];
+	bits_put_literal(bw, 257 + lcode);
+	if (length_extra[lcode]) bits_put(bw, len - length_base[lcode], length_extra[lcode]);
+	const u32 dcode = dist <= 256 ? dist_code[dist - 1] : dist_code[256 + ((dist - 1) >> 7)];
+	bits_put(bw, fixed_dist_code[dcode], 5);
+	if (dist_extra[dcode]) bits_put(bw, dist - dist_base[dcode], dist_extra[dcode]);
+}
+
+internal inline u32 hash3(const u8 *p) {
+	return (((u32)p[0] << 16 | (u32)p[1] << 8 | (u32)p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+/* worst case output size of deflate_block, literals cost at most 9 bits per byte and matches less */
+internal size_t deflate_bound(size_t len) {
+	return len + len / 8 + 16;
+}
+/* compress data as one fixed Huffman block followed by a sync flush, so that blocks compressed on their
+	own can be concatenated into a single stream. head and prev are scratch, HASH_SIZE and WINDOW_SIZE long. */
+internal size_t deflate_block(const u8 *data, size_t len, u8 *out, s32 *head, s32 *prev) {
+	bit_writer_t bw = { .out = out, .bits = 0, .count = 0 };
+	bits_put(&bw, 1 << 1, 3); /* BFINAL = 0, BTYPE = 01 (fixed Huffman) */
+	for (u32 i = 0; i < HASH_SIZE; ++i) head[i] = -1;
+	size_t pos = 0;
+	while (pos < len) {
+		u32 best_len = 0, best_dist = 0;
+		if (pos + MIN_MATCH <= len) {
+			const u32 h = hash3(data + pos);
+			const u32 max_len = (u32)MIN(MAX_MATCH, len - pos);
+			s32 candidate = head[h];
+			for (int chain = 0; candidate >= 0 && pos - candidate <= WINDOW_SIZE && chain < MAX_CHAIN; ++chain) {
+				const u8 *a = data + candidate, *b = data + pos;
+				if (a[best_len] == b[best_len]) {
+					u32 match = 0;
+					while (match < max_len && a[match] == b[match]) match++;
+					if (match > best_len) {
+						best_len = match;
+						best_dist = (u32)(pos - candidate);
+						if (match == max_len) break;
+					}
+				}
+				/* entries overwritten by a position further along mean the chain has left the window */
+				const s32 next = prev[candidate & WINDOW_MASK];
+				if (next >= candidate) break;
+				candidate = next;
+			}
+			prev[pos & WINDOW_MASK] = head[h];
+			head[h] = (s32)pos;
+		}
+		if (best_len >= MIN_MATCH) {
+			bits_put_match(&bw, best_len, best_dist);
+			for (size_t p = pos + 1; p < pos + best_len && p + MIN_MATCH <= len; ++p) {
+				const u32 h = hash3(data + p);
+				prev[p & WINDOW_MASK] = head[h];
+				head[h] = (s32)p;
+			}
+			pos += best_len;
+		} else {
+			bits_put_literal(&bw, data[pos++]);
+		}
+	}
+	bits_put_literal(&bw, END_OF_BLOCK);
+	/* sync flush: empty stored block, aligned to a byte boundary */
+	bits_put(&bw, 0, 3);
+	if (bw.count) bits_put(&bw, 0, 8 - bw.count);
+	bits_put(&bw, 0x0000, 16);
+	bits_put(&bw, 0xFFFF, 16);
+	return (size_t)(bw.out - out);
+}
+
+/* FILTERING */
+/* picks whichever of None, Sub and Up gives the smallest sum of absolute differences, writes the filter
+	type byte followed by the filtered row to out. prior is 0 for the first row of the image. */
+internal void filter_row(const u8 *row, const u8 *prior, size_t len, u8 *out) {
+	u32 sum_none = 0, sum_sub = 0, sum_up = 0xFFFFFFFF;
+	for (size_t i = 0; i < len; ++i) {
+		const u8 sub = (u8)(row[i] - (i >= PNG_BYTES_PER_PIXEL ? row[i - PNG_BYTES_PER_PIXEL] : 0));
+		sum_none += (u32)abs((s8)row[i]);
+		sum_sub += (u32)abs((s8)sub);
+	}
+	if (prior) {
+		sum_up = 0;
+		for (size_t i = 0; i < len; ++i)
+			sum_up += (u32)abs((s8)(u8)(row[i] - prior[i]));
+	}
+	if (sum_up < sum_sub && sum_up < sum_none) {
+		*out++ = 2;
+		for (size_t i = 0; i < len; ++i)
+			out[i] = (u8)(row[i] - prior[i]);
+	} else if (sum_sub < sum_none) {
+		*out++ = 1;
+		for (size_t i = 0; i < len; ++i)
+			out[i] = (u8)(row[i] - (i >= PNG_BYTES_PER_PIXEL ? row[i - PNG_BYTES_PER_PIXEL] : 0));
+	} else {
+		*out++ = 0;
+		memcpy(out, row, len);
+	}
+}
+
+/* STREAM */
+typedef struct png_block_t {
+	u8 *compressed;
+	size_t compressed_size;
+	size_t raw_size;
+	u32 adler;
+	volatile u32 ready;
+} png_block_t;
+
+/* scratch owned by one compressing thread */
+typedef struct png_worker_t {
+	struct png_stream_t *stream;
+	u32 *pixels;
+	u8 *rgb_prior, *rgb_row;
+	u8 *raw;
+	s32 *head, *prev;
+} png_worker_t;
+
+typedef struct png_stream_t {
+	s32 width, height;
+	s32 rows_per_block;
+	u32 block_count;
+	size_t row_bytes;	/* filtered row size, including the filter type byte */
+	png_row_func_t row_func;
+	void *user;
+
+	png_block_t *slots;
+	u32 slot_count;
+	volatile u32 next_block;	/* next block for a worker to claim */
+	volatile u32 blocks_written;
+	event_t block_ready;
+} png_stream_t;
+
+internal void png_worker_alloc(png_worker_t *worker, png_stream_t *stream) {
+	worker->stream = stream;
+	worker->pixels = malloc_s(sizeof(u32) * stream->width);
+	worker->rgb_prior = malloc_s(stream->row_bytes);
+	worker->rgb_row = malloc_s(stream->row_bytes);
+	worker->raw = malloc_s(stream->row_bytes * stream->rows_per_block);
+	worker->head = malloc_s(sizeof(s32) * HASH_SIZE);
+	worker->prev = malloc_s(sizeof(s32) * WINDOW_SIZE);
+}
+internal void png_worker_free(png_worker_t *worker) {
+	free_s(worker->pixels);
+	free_s(worker->rgb_prior);
+	free_s(worker->rgb_row);
+	free_s(worker->raw);
+	free_s(worker->head);
+	free_s(worker->prev);
+}
+
+internal void png_worker_read_row(png_worker_t *worker, s32 y, u8 *rgb) {
+	const png_stream_t *stream = worker->stream;
+	stream->row_func(stream->user, y, worker->pixels);
+	for (s32 x = 0; x < stream->width; ++x) {
+		const u32 pix = worker->pixels[x];
+		*rgb++ = (u8)(pix >> 16);
+		*rgb++ = (u8)(pix >> 8);
+		*rgb++ = (u8)pix;
+	}
+}
+internal void png_compress_block(png_worker_t *worker, u32 block_index, png_block_t *block) {
+	const png_stream_t *stream = worker->stream;
+	const s32 y0 = (s32)block_index * stream->rows_per_block;
+	const s32 y1 = MIN(stream->height, y0 + stream->rows_per_block);
+	const size_t rgb_bytes = stream->row_bytes - 1;
+	/* the Up filter needs the row before the block, which another block owns */
+	if (y0 > 0) png_worker_read_row(worker, y0 - 1, worker->rgb_prior);
+	u8 *raw = worker->raw;
+	for (s32 y = y0; y < y1; ++y) {
+		png_worker_read_row(worker, y, worker->rgb_row);
+		filter_row(worker->rgb_row, y > 0 ? worker->rgb_prior : 0, rgb_bytes, raw);
+		raw += stream->row_bytes;
+		SWAP(worker->rgb_prior, worker->rgb_row);
+	}
+	block->raw_size = (size_t)(raw - worker->raw);
+	block->adler = adler32_update(1, worker->raw, block->raw_size);
+	block->compressed_size = deflate_block(worker->raw, block->raw_size, block->compressed, worker->head, worker->prev);
+}
+
+internal void png_worker_main(void *arg) {
+	png_worker_t *worker = (png_worker_t *)arg;
+	png_stream_t *stream = worker->stream;
+	u32 index;
+	while ((index = atomic_add_u32(&stream->next_block, 1)) < stream->block_count) {
+		/* bounded memory: wait until the writer has flushed the block that used this slot last */
+		while (index >= atomic_load_u32(&stream->blocks_written) + stream->slot_count)
+			thread_sleep_ms(1);
+		png_block_t *block = &stream->slots[index % stream->slot_count];
+		png_compress_block(worker, index, block);
+		atomic_store_u32(&block->ready, 1);
+		event_raise(&stream->block_ready);
+	}
+}
+
+internal void png_write_u32(u8 *dest, u32 value) {
+	dest[0] = (u8)(value >> 24);
+	dest[1] = (u8)(value >> 16);
+	dest[2] = (u8)(value >> 8);
+	dest[3] = (u8)value;
+}
+internal void png_write_chunk(FILE *file, const char *type, const u8 *data, size_t len) {
+	u8 header[8];
+	png_write_u32(header, (u32)len);
+	memcpy(header + 4, type, 4);
+	u32 crc = crc32_update(0xFFFFFFFF, header + 4, 4);
+	crc = crc32_update(crc, data, len);
+	u8 footer[4];
+	png_write_u32(footer, crc ^ 0xFFFFFFFF);
+	fwrite(header, 1, 8, file);
+	if (len) fwrite(data, 1, len, file);
+	fwrite(footer, 1, 4, file);
+}
+
+int png_write_stream(const char *filename, s32 width, s32 height, png_row_func_t row_func, void *user, u32 thread_count) {
+	assert(filename && "png_write_stream: filename == 0");
+	assert(row_func && "png_write_stream: row_func == 0");
+	if (width <= 0 || height <= 0) {
+		fprintf(stdout, "[png_write_stream] invalid image size (%d x %d)\n", width, height);
+		return ERROR_RETURN;
+	}
+	FILE *file = 0;
+	if (fopen_s(&file, filename, "wb")) {
+		fprintf(stdout, "[png_write_stream] failed to open %s\n", filename);
+		return ERROR_RETURN;
+	}
+	png_tables_init();
+
+	png_stream_t stream = { 0 };
+	stream.width = width;
+	stream.height = height;
+	stream.row_bytes = 1 + (size_t)width * PNG_BYTES_PER_PIXEL;
+	stream.rows_per_block = (s32)MAX(1, PNG_BLOCK_BYTES / stream.row_bytes);
+	stream.block_count = (u32)((height + stream.rows_per_block - 1) / stream.rows_per_block);
+	stream.row_func = row_func;
+	stream.user = user;
+	if (thread_count == 0) thread_count = platform_cpu_count();
+	thread_count = MIN(thread_count, stream.block_count);
+	/* a single thread compresses each block right before writing it */
+	stream.slot_count = thread_count > 1 ? PNG_SLOTS_PER_THREAD * thread_count : 1;
+	stream.slots = calloc_s(sizeof(png_block_t) * stream.slot_count);
+	for (u32 i = 0; i < stream.slot_count; ++i)
+		stream.slots[i].compressed = malloc_s(deflate_bound(stream.row_bytes * stream.rows_per_block));
+
+	png_worker_t *workers = malloc_s(sizeof(png_worker_t) * thread_count);
+	thread_t *threads = malloc_s(sizeof(thread_t) * thread_count);
+	for (u32 i = 0; i < thread_count; ++i)
+		png_worker_alloc(&workers[i], &stream);
+	u32 started = 0;
+	/* the event has to be freed even if no worker starts */
+	const boolean event_ready = thread_count > 1 && event_init(&stream.block_ready) == 0;
+	if (event_ready) {
+		while (started < thread_count && thread_create(&threads[started], png_worker_main, &workers[started]) == 0)
+			started++;
+		/* as long as one worker started, the others not starting only costs speed */
+	}
+
+	/* signature and header */
+	static const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, sizeof(signature), file);
+	u8 ihdr[13];
+	png_write_u32(ihdr, (u32)width);
+	png_write_u32(ihdr + 4, (u32)height);
+	ihdr[8] = 8;	/* bit depth */
+	ihdr[9] = 2;	/* colour type: RGB */
+	ihdr[10] = 0;	/* compression: deflate */
+	ihdr[11] = 0;	/* filter method */
+	ihdr[12] = 0;	/* no interlacing */
+	png_write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+	/* zlib header: deflate with a 32K window, no dictionary, check bits so that header % 31 == 0 */
+	static const u8 zlib_header[2] = { 0x78, 0x01 };
+	png_write_chunk(file, "IDAT", zlib_header, sizeof(zlib_header));
+
+	/* blocks are written in order as soon as they're done */
+	u32 adler = 1;
+	for (u32 index = 0; index < stream.block_count; ++index) {
+		png_block_t *block = &stream.slots[index % stream.slot_count];
+		if (started) {
+			/* every block is claimed by some worker, which finishes it before claiming another */
+			while (!atomic_load_u32(&block->ready))
+				event_wait(&stream.block_ready, 10);
+		} else {
+			png_compress_block(&workers[0], index, block);
+		}
+		png_write_chunk(file, "IDAT", block->compressed, block->compressed_size);
+		adler = adler32_combine(adler, block->adler, block->raw_size);
+		atomic_store_u32(&block->ready, 0);
+		atomic_store_u32(&stream.blocks_written, index + 1);
+	}
+
+	/* final empty stored block and the checksum of the uncompressed data */
+	u8 trailer[9] = { 0x01, 0x00, 0x00, 0xFF, 0xFF };
+	png_write_u32(trailer + 5, adler);
+	png_write_chunk(file, "IDAT", trailer, sizeof(trailer));
+	png_write_chunk(file, "IEND", 0, 0);
+
+	for (u32 i = 0; i < started; ++i)
+		thread_join(&threads[i]);
+	if (event_ready) event_free(&stream.block_ready);
+	for (u32 i = 0; i < thread_count; ++i)
+		png_worker_free(&workers[i]);
+	free_s(threads);
+	free_s(workers);
+	for (u32 i = 0; i < stream.slot_count; ++i)
+		free_s(stream.slots[i].compressed);
+	free_s(stream.slots);
+
+	const int write_error = ferror(file);
+	fclose(file);
+	if (write_error) {
+		fprintf(stdout, "[png_write_stream] failed writing %s\n", filename);
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+typedef struct png_scaled_source_t {
+	const RenderBuffer *rb;
+	s32 x_scale, y_scale;
+} png_scaled_source_t;
+
+internal void png_scaled_row(void *user, s32 y, u32 *dest) {
+	const png_scaled_source_t *source = (const png_scaled_source_t *)user;
+	const RenderBuffer *rb = source->rb;
+	/* the file is top to bottom, the RenderBuffer bottom to top */
+	const u32 *src = rb->pixels + (size_t)(rb->height - 1 - y / source->y_scale) * rb->width;
+	for (s32 x = 0; x < rb->width; ++x)
+		for (s32 i = 0; i < source->x_scale; ++i)
+			*dest++ = src[x];
+}
+int png_write_renderbuffer_scaled(const char *filename, const RenderBuffer *rb, s32 x_scale, s32 y_scale, u32 thread_count) {
+	assert(filename && "png_write_renderbuffer_scaled: filename == 0");
+	assert(rb && "png_write_renderbuffer_scaled: rb == 0");
+	assert(x_scale > 0 && y_scale > 0 && "Cannot rescale by factor <= 0!");
+	png_scaled_source_t source = { .rb = rb, .x_scale = x_scale, .y_scale = y_scale };
+	return png_write_stream(filename, rb->width * x_scale, rb->height * y_scale, png_scaled_row, &source, thread_count);
+}
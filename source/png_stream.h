@@ -0,0 +1,20 @@
+#pragma once
+
+#include "types.h"
+#include "render.h"
+
+/* Streaming PNG writer: rows are requested from a callback block by block, filtered, deflated and
+	written to disk as they complete, so an image never has to exist in memory in full. Blocks are
+	compressed independently (each ends on a deflate sync flush, like pigz) and can be spread across
+	threads, the file is still written strictly in row order. Output is 8-bit RGB, alpha is dropped. */
+
+/* fill dest with the width pixels (0xAARRGGBB) of row y, counted from the top of the image.
+	Called concurrently from several threads when thread_count > 1, and each row may be requested twice. */
+typedef void(*png_row_func_t)(void *user, s32 y, u32 *dest);
+
+/* thread_count 0 uses every core. Returns 0 if successful */
+int png_write_stream(const char *filename, s32 width, s32 height, png_row_func_t row_func, void *user, u32 thread_count);
+
+/* write rb scaled up by (x_scale, y_scale) with nearest neighbour sampling, without building the scaled
+	buffer RB_rescale_clone would. Rows are flipped so RB_load_image_png reads back the same buffer. */
+int png_write_renderbuffer_scaled(const char *filename, const RenderBuffer *rb, s32 x_scale, s32 y_scale, u32 thread_count);
@@ -0,0 +1,135 @@
+#include "profiler.h"
+
+#include "platform.h"
+#include "maths.h"
+#include "assert_opt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+internal const char *value_names[PROFILE_VALUE_COUNT] = { "input", "tick", "sample", "present", "frame", "pixels" };
+
+void profiler_init(profiler_t *p) {
+	assert(p && "profiler_init: p == 0");
+	memset(p, 0, sizeof(profiler_t));
+}
+void profiler_begin_frame(profiler_t *p) {
+	assert(p && "profiler_begin_frame: p == 0");
+	const u64 now = platform_ticks();
+	if (p->in_frame) {
+		p->current.values[PROFILE_FRAME] = now - p->frame_start;
+		p->current.recorded |= 1u << PROFILE_FRAME;
+		p->history[p->frame_count % PROFILE_HISTORY] = p->current;
+		p->frame_count++;
+	}
+	memset(&p->current, 0, sizeof(profile_frame_t));
+	p->frame_start = now;
+	p->stage_start = now;
+	p->in_frame = true;
+}
+void profiler_mark(profiler_t *p, profile_value_t value) {
+	assert(p && "profiler_mark: p == 0");
+	assert(value < PROFILE_VALUE_COUNT && "profiler_mark: invalid value");
+	const u64 now = platform_ticks();
+	p->current.values[value] += now - p->stage_start;
+	p->current.recorded |= 1u << value;
+	p->stage_start = now;
+}
+void profiler_add(profiler_t *p, profile_value_t value, u64 amount) {
+	assert(p && "profiler_add: p == 0");
+	assert(value < PROFILE_VALUE_COUNT && "profiler_add: invalid value");
+	p->current.values[value] += amount;
+	p->current.recorded |= 1u << value;
+}
+
+const char *profiler_value_name(profile_value_t value) {
+	assert(value < PROFILE_VALUE_COUNT && "profiler_value_name: invalid value");
+	return value_names[value];
+}
+
+internal int compare_u64(const void *a, const void *b) {
+	const u64 x = *(const u64 *)a, y = *(const u64 *)b;
+	return (x > y) - (x < y);
+}
+void profiler_summary(const profiler_t *p, profile_value_t value, profile_summary_t *summary) {
+	assert(p && "profiler_summary: p == 0");
+	assert(value < PROFILE_VALUE_COUNT && "profiler_summary: invalid value");
+	assert(summary && "profiler_summary: summary == 0");
+	memset(summary, 0, sizeof(profile_summary_t));
+	const u32 frames = (u32)MIN(p->frame_count, PROFILE_HISTORY);
+	u64 sorted[PROFILE_HISTORY];
+	u64 total = 0;
+	u32 count = 0;
+	for (u32 i = 0; i < frames; ++i) {
+		if (!(p->history[i].recorded & (1u << value))) continue;
+		sorted[count] = p->history[i].values[value];
+		total += sorted[count++];
+	}
+	if (count == 0) return;
+	qsort(sorted, count, sizeof(u64), compare_u64);
+	/* nearest rank: the smallest value at least 99% of frames are at or below */
+	const u32 p99_rank = (count * 99 + 99) / 100;
+	const double scale = value == PROFILE_PIXELS ? 1.0 : 1000.0 * platform_ticks_to_seconds(1);
+	summary->min = (double)sorted[0] * scale;
+	summary->max = (double)sorted[count - 1] * scale;
+	summary->avg = (double)total * scale / (double)count;
+	summary->p99 = (double)sorted[p99_rank - 1] * scale;
+	summary->samples = count;
+}
+void profiler_print(const profiler_t *p, FILE *out) {
+	assert(p && "profiler_print: p == 0");
+	assert(out && "profiler_print: out == 0");
+	for (profile_value_t value = 0; value < PROFILE_VALUE_COUNT; ++value) {
+		profile_summary_t summary;
+		profiler_summary(p, value, &summary);
+		const int precision = value == PROFILE_PIXELS ? 0 : 3;
+		fprintf(out, "[profile] %-8s min %10.*f  avg %10.*f  p99 %10.*f  max %10.*f %s (%u frames)\n", value_names[value],
+			precision, summary.min, precision, summary.avg, precision, summary.p99, precision, summary.max,
+			value == PROFILE_PIXELS ? "px" : "ms", summary.samples);
+	}
+}
+void profiler_format(const profiler_t *p, char *buffer, size_t size) {
+	assert(p && "profiler_format: p == 0");
+	assert(buffer && "profiler_format: buffer == 0");
+	profile_summary_t frame, sample, present, pixels;
+	profiler_summary(p, PROFILE_FRAME, &frame);
+	profiler_summary(p, PROFILE_SAMPLE, &sample);
+	profiler_summary(p, PROFILE_PRESENT, &present);
+	profiler_summary(p, PROFILE_PIXELS, &pixels);
+	/* sample and pixels are over the frames that presented a new render, which can be fewer than were shown */
+	snprintf(buffer, size, "%.0f fps | frame %.2f ms (p99 %.2f) | sample %.2f ms (p99 %.2f) | present %.2f ms | %.0fk px | %u/%u new",
+		frame.avg > 0.0 ? 1000.0 / frame.avg : 0.0, frame.avg, frame.p99, sample.avg, sample.p99, present.avg, pixels.avg / 1000.0,
+		sample.samples, frame.samples);
+}
+
+#define OVERLAY_COLUMN_WIDTH 2
+#define OVERLAY_PIXELS_PER_MS 4
+#define OVERLAY_HEIGHT 160
+#define OVERLAY_MARGIN 8
+void profiler_draw_overlay(const profiler_t *p, RenderBuffer *rb) {
+	assert(p && "profiler_draw_overlay: p == 0");
+	assert(rb && "profiler_draw_overlay: rb == 0");
+	/* colours for the stacked time stages, the rest of the frame (sleeping) isn't drawn */
+	static const u32 colours[PROFILE_FRAME] = { 0x4080FF, 0x40FF80, 0xFFB020, 0xFF4040 };
+	const double ms_per_tick = 1000.0 * platform_ticks_to_seconds(1);
+	const s32 x0 = OVERLAY_MARGIN, y0 = OVERLAY_MARGIN;
+	const s32 width = PROFILE_HISTORY * OVERLAY_COLUMN_WIDTH;
+	RB_draw_rect(rb, x0, y0, x0 + width, y0 + OVERLAY_HEIGHT, 0x202020);
+	const u32 count = (u32)MIN(p->frame_count, PROFILE_HISTORY);
+	/* newest frame on the right */
+	for (u32 i = 0; i < count; ++i) {
+		const profile_frame_t *frame = &p->history[(p->frame_count - 1 - i) % PROFILE_HISTORY];
+		const s32 x = x0 + width - (s32)(i + 1) * OVERLAY_COLUMN_WIDTH;
+		s32 y = y0;
+		for (profile_value_t value = 0; value < PROFILE_FRAME && y < y0 + OVERLAY_HEIGHT; ++value) {
+			if (!(frame->recorded & (1u << value))) continue;
+			const s32 height = (s32)((double)frame->values[value] * ms_per_tick * OVERLAY_PIXELS_PER_MS + 0.5);
+			const s32 top = MIN(y + height, y0 + OVERLAY_HEIGHT);
+			if (top > y) RB_draw_rect(rb, x, y, x + OVERLAY_COLUMN_WIDTH, top, colours[value]);
+			y = top;
+		}
+	}
+	/* 60Hz budget */
+	const s32 budget = y0 + (s32)(1000.0 / 60.0 * OVERLAY_PIXELS_PER_MS);
+	RB_draw_rect(rb, x0, budget, x0 + width, budget + 1, 0xFFFFFF);
+}
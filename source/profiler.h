@@ -0,0 +1,61 @@
+#pragma once
+
+#include "types.h"
+#include "render.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Per-frame counters kept for the last PROFILE_HISTORY frames. Stage times are measured with platform_ticks,
+	the summary gives min/avg/p99 over the history. Not thread safe: fill it from one thread, and pass along
+	numbers measured elsewhere (like the render thread's sample time) with profiler_add. A value only counts for
+	the frames it was marked or added in, so a frame that presented nothing new doesn't pull the sample time and
+	pixels towards 0. */
+
+#define PROFILE_HISTORY 256
+
+typedef enum profile_value_e {
+	PROFILE_INPUT,		/* message processing */
+	PROFILE_TICK,		/* game/camera update */
+	PROFILE_SAMPLE,		/* drawing the map into the frame */
+	PROFILE_PRESENT,	/* overlay and blit to the window */
+	PROFILE_FRAME,		/* whole frame, from one profiler_begin_frame to the next, sleeping included */
+	PROFILE_PIXELS,		/* pixels written while sampling (a count, not a time) */
+	PROFILE_VALUE_COUNT
+} profile_value_t;
+
+typedef struct profile_frame_s {
+	u64 values[PROFILE_VALUE_COUNT];
+	u32 recorded;	/* bit 1 << value for each value marked or added this frame */
+} profile_frame_t;
+
+typedef struct profiler_s {
+	profile_frame_t history[PROFILE_HISTORY];
+	u64 frame_count;	/* frames completed, the newest is history[(frame_count - 1) % PROFILE_HISTORY] */
+	profile_frame_t current;
+	u64 frame_start;
+	u64 stage_start;
+	boolean in_frame;
+} profiler_t;
+
+/* min/avg/p99 in milliseconds for times, in units for counts */
+typedef struct profile_summary_s {
+	double min, avg, p99, max;
+	u32 samples;	/* frames the value was recorded in, all 0 if none */
+} profile_summary_t;
+
+void profiler_init(profiler_t *p);
+/* ends the previous frame (if any) and starts a new one */
+void profiler_begin_frame(profiler_t *p);
+/* everything from the last profiler_begin_frame/profiler_mark call until now is attributed to value */
+void profiler_mark(profiler_t *p, profile_value_t value);
+void profiler_add(profiler_t *p, profile_value_t value, u64 amount);
+
+const char *profiler_value_name(profile_value_t value);
+void profiler_summary(const profiler_t *p, profile_value_t value, profile_summary_t *summary);
+/* one line per value */
+void profiler_print(const profiler_t *p, FILE *out);
+/* short single line summary, for a window title */
+void profiler_format(const profiler_t *p, char *buffer, size_t size);
+/* bar graph of the history in the bottom left corner of rb, one column per frame stacked by stage */
+void profiler_draw_overlay(const profiler_t *p, RenderBuffer *rb);
@@ -1,6 +1,5 @@
 #include "render.h"
 
-#include "win32_tools.h"
 #include "maths.h"
 #include "assert_opt.h"
 #include "memory_opt.h"
@@ -9,6 +8,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* allocate pixels (will NOT check if they already exist!) */
 int RB_alloc_pixels(RenderBuffer *rb) {
@@ -18,7 +18,7 @@ int RB_alloc_pixels(RenderBuffer *rb) {
 		rb->pixels = 0;
 		return 0;
 	}
-	if ((rb->pixels = VAlloc(sizeof(u32) * rb->size)))
+	if ((rb->pixels = platform_alloc_pages(sizeof(u32) * rb->size)))
 		return 0;
 	return ERROR_RETURN;
 }
@@ -32,8 +32,11 @@ int RB_alloc_resize_pixels(RenderBuffer *rb, s32 width, s32 height) {
 /* free rb->pixels (if it's non-zero) */
 int RB_free_pixels(RenderBuffer *rb) {
 	assert(rb && "RB_free_pixels: rb == 0");
-	if (rb->pixels)
-		return !VFree(rb->pixels);
+	if (rb->pixels) {
+		const int err = platform_free_pages(rb->pixels, sizeof(u32) * rb->size);
+		rb->pixels = 0;
+		return err;
+	}
 	return 0;
 }
 /* free rb->pixels if its non-zero, then allocate pixels for the new dimensions (this will clear the buffer too) */
@@ -311,7 +314,8 @@ void RB_draw_triangle(RenderBuffer *rb, s32 x0, s32 y0, s32 x1, s32 y1, s32 x2,
 		return;
 	}
 
-	s32* sides = malloc_s(tri_height * 2 * sizeof(s32));
+	const scratch_mark_t mark = scratch_mark();
+	s32* sides = scratch_alloc(tri_height * 2 * sizeof(s32));
 	if (mid_point_side > 0) { /* mid point p1 is to the left of p0->p2 */
 		s32 len = triangle_side(sides + 1, x0, y0, x2, y2, false);
 		assert(len == tri_height && "Triangle side points doesn't match height!");
@@ -330,7 +334,7 @@ void RB_draw_triangle(RenderBuffer *rb, s32 x0, s32 y0, s32 x1, s32 y1, s32 x2,
 	for (s32 i = 0; i < tri_height; ++i)
 		RB_draw_horizontal(rb, sides[i * 2], sides[i * 2 + 1], y0 - i, colour);
 	
-	free_s(sides);
+	scratch_reset(mark);
 }
 
 /* Will draw to the rectangle defined by (prb, width, height), using the same sized rectangle based at ps in source for colour,
@@ -375,17 +379,17 @@ void RB_draw_renderbuffer_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 xs, s32 ys
 	RB_draw_buffer(rb, xrb, yrb, xs, ys, width, height, source->pixels, source->width);
 }
 
-void RB_draw_renderbuffer_sample(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height, const RenderBuffer *source) {
+u64 RB_draw_renderbuffer_sample(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height, const RenderBuffer *source) {
 	assert(rb && "RB_draw_renderbuffer_sample: rb == 0");
 	assert(source && "RB_draw_renderbuffer_sample: source == 0");
-	RB_draw_renderbuffer_sample_sub(rb, xrb, yrb, dest_width, dest_height, 0.0f, 0.0f, 1.0f, 1.0f, source);
+	return RB_draw_renderbuffer_sample_sub(rb, xrb, yrb, dest_width, dest_height, 0.0f, 0.0f, 1.0f, 1.0f, source);
 }
-void RB_draw_renderbuffer_sample_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height,
+u64 RB_draw_renderbuffer_sample_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height,
 	float xs, float ys, float src_width, float src_height, const RenderBuffer *source) {
 	assert(rb && "RB_draw_renderbuffer_sample_sub: rb == 0");
 	assert(source && "RB_draw_renderbuffer_sample_sub: source == 0");
 	if (xrb + dest_width <= 0 || xrb >= rb->width || yrb + dest_height <= 0 || yrb >= rb->height || dest_width <= 0 || dest_height <= 0)
-		return;
+		return 0;
 	/* Now we know: xrb+width > 0, xrb < rb->width, yrb+height > 0, yrb < rb->height, width > 0, height > 0 */
 
 	if (xrb < 0) {
@@ -444,6 +448,7 @@ void RB_draw_renderbuffer_sample_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 des
 		y_src += y_per_pix;
 		pix_dest += delta_dest;
 	}
+	return (u64)dest_width * (u64)dest_height;
 }
 
 int RB_load_image_png(RenderBuffer *rb, const char *filename) {
@@ -461,57 +466,33 @@ int RB_load_image_png(RenderBuffer *rb, const char *filename) {
 	/* Copy image data to renderbuffer */
 	error = RB_resize(rb, width, height);
 	if (error) return ERROR_RETURN;
-	u32 *pix = rb->pixels + rb->size - rb->width;
-	const unsigned char *im = image;
 	/* have to flip along y axis! */
-	for (int y = 0; y < rb->height; ++y) {
-		for (int x = 0; x < rb->width; ++x) {
-			u32 r = *im++;
-			u32 g = *im++;
-			u32 b = *im++;
-			u32 a = *im++;
-			*pix++ = (a << 24) | (r << 16) | (g << 8) | b;
-		}
-		pix -= rb->width * 2;
-	}
+	const ptrdiff_t stride = (ptrdiff_t)rb->width * 4;
+	pixel_convert_image(PIXEL_FORMAT_RGBA32, rb->pixels, image + (rb->height - 1) * stride, -stride, rb->width, rb->height);
 
 	/* NOT free_s as this was malloc'd by lodepng */
 	free(image);
 
 	return 0;
 }
-int RB_load_image_bmp(RenderBuffer *rb, const char *filename) {
-	assert(rb && "RB_load_image_bmp: rb == 0");
-	assert(filename && "RB_load_image_bmp: filename == 0");
-	unsigned char *filedata = 0;
-	size_t filesize = 0;
-	{
-		FILE *file = 0;
-		if (fopen_s(&file, filename, "rb")) {
-			fprintf(stdout, "[RB_load_image_bmp] failed to load %s\n", filename);
-			return ERROR_RETURN;
-		}
-		fseek(file, 0, SEEK_END);
-		filesize = ftell(file);
-		if (filesize == 0) {
-			fprintf(stdout, "[RB_load_image_bmp] file empty\n");
-			return ERROR_RETURN;
-		}
-		fseek(file, 0, SEEK_SET);
-
-		filedata = malloc_s(filesize);
-		assert(filedata && "RB_load_image_bmp: malloc failed");
-		const size_t size_read = fread(filedata, 1, filesize, file);
-		assert(size_read == filesize && "RB_load_image_bmp: bytes read don't match file size");
-		fclose(file);
+int RB_bmp_open(bmp_file_t *bmp, const char *filename) {
+	assert(bmp && "RB_bmp_open: bmp == 0");
+	assert(filename && "RB_bmp_open: filename == 0");
+	if (platform_map_file(&bmp->file, filename)) {
+		fprintf(stdout, "[RB_bmp_open] failed to load %s\n", filename);
+		return ERROR_RETURN;
 	}
+	const unsigned char *filedata = bmp->file.data;
+	const size_t filesize = bmp->file.size;
 	static const size_t MINHEADER = 54; /* minimum BMP header size */
 	if (filesize < MINHEADER) {
-		fprintf(stdout, "[RB_load_image_bmp] header too small (%zu)\n", filesize);
+		fprintf(stdout, "[RB_bmp_open] header too small (%zu)\n", filesize);
+		RB_bmp_close(bmp);
 		return ERROR_RETURN;
 	}
 	if (filedata[0] != 'B' || filedata[1] != 'M') {
-		fprintf(stdout, "[RB_load_image_bmp] missing BM header (%c%c)\n", filedata[0], filedata[1]);
+		fprintf(stdout, "[RB_bmp_open] missing BM header (%c%c)\n", filedata[0], filedata[1]);
+		RB_bmp_close(bmp);
 		return ERROR_RETURN;
 	}
 	const int pixeloffset = filedata[10] + 256 * filedata[11]; /* where the pixel data starts */
@@ -519,7 +500,8 @@ int RB_load_image_bmp(RenderBuffer *rb, const char *filename) {
 	const int height = filedata[22] + filedata[23] * 256;
 	/* read number of channels from BMP header */
 	if (filedata[28] != 24 && filedata[28] != 32) {
-		fprintf(stdout, "[RB_load_image_bmp] unsupported bit-depth (%d)\n", filedata[28]);
+		fprintf(stdout, "[RB_bmp_open] unsupported bit-depth (%d)\n", filedata[28]);
+		RB_bmp_close(bmp);
 		return ERROR_RETURN;
 	}
 	const int numChannels = filedata[28] / 8;
@@ -530,31 +512,38 @@ int RB_load_image_bmp(RenderBuffer *rb, const char *filename) {
 	if (scanlineBytes & 3) scanlineBytes = (scanlineBytes & ~3) + 4;
 
 	const int datasize = scanlineBytes * height;
-	if (filesize < datasize + pixeloffset) {
-		fprintf(stdout, "[RB_load_image_bmp] file too small to fit image (%zu < %zu)\n", filesize, (size_t)(datasize + pixeloffset));
+	if (filesize < (size_t)(datasize + pixeloffset)) {
+		fprintf(stdout, "[RB_bmp_open] file too small to fit image (%zu < %zu)\n", filesize, (size_t)(datasize + pixeloffset));
+		RB_bmp_close(bmp);
 		return ERROR_RETURN;
 	}
 
-	int err = RB_resize(rb, width, height);
-	if (err) return ERROR_RETURN;
-	const unsigned char *im = &filedata[pixeloffset];
-	for (int y = 0; y < rb->height; ++y)
-		for (int x = 0; x < rb->width; ++x) {
-			const int bmpos = (rb->height - y - 1) * scanlineBytes + numChannels * x;
-			u32 r, g, b, a;
-			if (numChannels == 3) {
-				r = im[bmpos + 2];
-				g = im[bmpos + 1];
-				b = im[bmpos + 0];
-				a = 255;
-			} else {
-				r = im[bmpos + 3];
-				g = im[bmpos + 2];
-				b = im[bmpos + 1];
-				a = im[bmpos + 0];
-			}
-			rb->pixels[y * width + x] = (a << 24) | (r << 16) | (g << 8) | b;
-		}
-	free_s(filedata);
+	bmp->width = width;
+	bmp->height = height;
+	bmp->format = numChannels == 3 ? PIXEL_FORMAT_BGR24 : PIXEL_FORMAT_ABGR32;
+	/* rows are stored bottom to top */
+	bmp->stride = -(ptrdiff_t)scanlineBytes;
+	bmp->row0 = &filedata[pixeloffset] + (ptrdiff_t)(height - 1) * scanlineBytes;
 	return 0;
 }
+void RB_bmp_close(bmp_file_t *bmp) {
+	assert(bmp && "RB_bmp_close: bmp == 0");
+	platform_unmap_file(&bmp->file);
+	bmp->row0 = 0;
+}
+void RB_bmp_read_row(const bmp_file_t *bmp, s32 y, u32 *dest) {
+	assert(bmp && "RB_bmp_read_row: bmp == 0");
+	assert(y >= 0 && y < bmp->height && "RB_bmp_read_row: y out of bounds");
+	pixel_convert_row(bmp->format, dest, bmp->row0 + y * bmp->stride, bmp->width);
+}
+
+int RB_load_image_bmp(RenderBuffer *rb, const char *filename) {
+	assert(rb && "RB_load_image_bmp: rb == 0");
+	assert(filename && "RB_load_image_bmp: filename == 0");
+	bmp_file_t bmp;
+	if (RB_bmp_open(&bmp, filename)) return ERROR_RETURN;
+	int err = RB_resize(rb, bmp.width, bmp.height);
+	if (!err) pixel_convert_image(bmp.format, rb->pixels, bmp.row0, bmp.stride, bmp.width, bmp.height);
+	RB_bmp_close(&bmp);
+	return err ? ERROR_RETURN : 0;
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "types.h"
+#include "platform.h"
+#include "pixel_convert.h"
 
 /* ALWAYS ZERO INITIALISE OTHERWISE PIXELS WILL BE NON-ZERO!!! */
 typedef struct RenderBuffer_t {
@@ -41,10 +43,26 @@ void RB_draw_buffer(RenderBuffer *rb, s32 xrb, s32 yrb, s32 xs, s32 ys, s32 widt
 void RB_draw_renderbuffer(RenderBuffer *rb, s32 xrb, s32 yrb, const RenderBuffer *source);
 void RB_draw_renderbuffer_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 xs, s32 ys, s32 width, s32 height, const RenderBuffer *source);
 
-void RB_draw_renderbuffer_sample(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height, const RenderBuffer *source);
-void RB_draw_renderbuffer_sample_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height,
+/* the sample functions return the number of pixels written after clipping */
+u64 RB_draw_renderbuffer_sample(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height, const RenderBuffer *source);
+u64 RB_draw_renderbuffer_sample_sub(RenderBuffer *rb, s32 xrb, s32 yrb, s32 dest_width, s32 dest_height,
 	float xs, float ys, float src_width, float src_height, const RenderBuffer *source);
 
 /* Make sure rb is ZERO-INITIALISED */
 int RB_load_image_png(RenderBuffer *rb, const char *filename);
 int RB_load_image_bmp(RenderBuffer *rb, const char *filename);
+
+/* A memory mapped BMP, for decoding rows straight from the file without loading it into a RenderBuffer first */
+typedef struct bmp_file_s {
+	platform_file_map_t file;
+	s32 width, height;
+	pixel_format_t format;
+	const u8 *row0;		/* first row in RenderBuffer order (the last row in the file) */
+	ptrdiff_t stride;	/* bytes from one RenderBuffer row to the next, negative */
+} bmp_file_t;
+
+/* returns 0 if successful, in which case RB_bmp_close must be called */
+int RB_bmp_open(bmp_file_t *bmp, const char *filename);
+void RB_bmp_close(bmp_file_t *bmp);
+/* decode bmp->width pixels of row y (same row order as RB_load_image_bmp) into dest */
+void RB_bmp_read_row(const bmp_file_t *bmp, s32 y, u32 *dest);
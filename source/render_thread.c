@@ -0,0 +1,114 @@
+#include "render_thread.h"
+
+#include "assert_opt.h"
+
+#include <string.h>
+
+#define CAMERA_FRESH 4
+/* how long the renderer sleeps when there is nothing to do before checking again */
+#define RENDER_IDLE_TIMEOUT_MS 100
+
+int render_thread_init(render_thread_t *rt, render_frame_func_t render_func, void *user) {
+	assert(rt && "render_thread_init: rt == 0");
+	assert(render_func && "render_thread_init: render_func == 0");
+	memset(rt, 0, sizeof(render_thread_t));
+	rt->render_func = render_func;
+	rt->user = user;
+	rt->camera_write = 0;
+	rt->camera_middle = 1;
+	rt->camera_read = 2;
+	return event_init(&rt->wake);
+}
+void render_thread_free(render_thread_t *rt) {
+	assert(rt && "render_thread_free: rt == 0");
+	render_thread_stop(rt);
+	RB_free_pixels(&rt->frames[0].rb);
+	RB_free_pixels(&rt->frames[1].rb);
+	event_free(&rt->wake);
+}
+
+internal void render_thread_main(void *arg) {
+	render_thread_t *rt = (render_thread_t *)arg;
+	while (atomic_load_u32(&rt->running))
+		if (!render_thread_render_once(rt))
+			event_wait(&rt->wake, RENDER_IDLE_TIMEOUT_MS);
+}
+int render_thread_start(render_thread_t *rt) {
+	assert(rt && "render_thread_start: rt == 0");
+	assert(!rt->running && "render_thread_start: rt->running != 0");
+	atomic_store_u32(&rt->running, 1);
+	if (thread_create(&rt->thread, render_thread_main, rt)) {
+		atomic_store_u32(&rt->running, 0);
+		fprintf(stdout, "[render_thread_start] Failed to create render thread\n");
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+void render_thread_stop(render_thread_t *rt) {
+	assert(rt && "render_thread_stop: rt == 0");
+	if (!atomic_exchange_u32(&rt->running, 0)) return;
+	event_raise(&rt->wake);
+	thread_join(&rt->thread);
+}
+
+void render_thread_set_camera(render_thread_t *rt, const camera_t *cam) {
+	assert(rt && "render_thread_set_camera: rt == 0");
+	assert(cam && "render_thread_set_camera: cam == 0");
+	rt->cameras[rt->camera_write] = *cam;
+	rt->camera_write = atomic_exchange_u32(&rt->camera_middle, rt->camera_write | CAMERA_FRESH) & ~CAMERA_FRESH;
+	event_raise(&rt->wake);
+}
+render_frame_t *render_thread_acquire(render_thread_t *rt) {
+	assert(rt && "render_thread_acquire: rt == 0");
+	const u32 state = atomic_load_u32(&rt->presentable);
+	if (state != FRAME_PENDING(0) && state != FRAME_PENDING(1)) return 0;
+	/* the renderer only ever writes to presentable when it is FRAME_NONE, so no CAS is needed */
+	const u32 index = state - FRAME_PENDING(0);
+	atomic_store_u32(&rt->presentable, FRAME_PRESENTING(index));
+	return &rt->frames[index];
+}
+void render_thread_release(render_thread_t *rt) {
+	assert(rt && "render_thread_release: rt == 0");
+	assert((rt->presentable == FRAME_PRESENTING(0) || rt->presentable == FRAME_PRESENTING(1)) &&
+		"render_thread_release: no frame acquired");
+	atomic_store_u32(&rt->presentable, FRAME_NONE);
+	event_raise(&rt->wake);
+}
+
+/* swaps in the newest camera, returns false if none has been published since the last call */
+internal boolean render_thread_fetch_camera(render_thread_t *rt) {
+	if (!(atomic_load_u32(&rt->camera_middle) & CAMERA_FRESH)) return false;
+	rt->camera_read = atomic_exchange_u32(&rt->camera_middle, rt->camera_read) & ~CAMERA_FRESH;
+	return true;
+}
+boolean render_thread_render_once(render_thread_t *rt) {
+	assert(rt && "render_thread_render_once: rt == 0");
+	u32 state = atomic_load_u32(&rt->presentable);
+	/* the last frame hasn't been picked up yet, a new one would only replace it */
+	if (state == FRAME_PENDING(0) || state == FRAME_PENDING(1)) return false;
+	if (!render_thread_fetch_camera(rt)) return false;
+	const camera_t *cam = &rt->cameras[rt->camera_read];
+	render_frame_t *frame = &rt->frames[rt->back];
+	RenderBuffer *rb = &frame->rb;
+	/* the presenter can only be holding the other buffer */
+	assert(state != FRAME_PRESENTING(rt->back) && "render_thread_render_once: back buffer is being presented");
+	if (cam->screen_dims.x <= 0 || cam->screen_dims.y <= 0) return false;
+	if (RB_resize(rb, cam->screen_dims.x, cam->screen_dims.y)) {
+		fprintf(stdout, "[render_thread_render_once] Failed to resize back buffer to %dx%d\n",
+			cam->screen_dims.x, cam->screen_dims.y);
+		return false;
+	}
+	const u64 start = platform_ticks();
+	frame->pixels = rt->render_func(rb, cam, rt->user);
+	frame->render_ticks = platform_ticks() - start;
+	atomic_add_u64(&rt->render_ticks, frame->render_ticks);
+	atomic_add_u64(&rt->frames_rendered, 1);
+	/* publish once the presenter is done with the previous frame */
+	while (!atomic_cas_u32(&rt->presentable, FRAME_NONE, FRAME_PENDING(rt->back))) {
+		/* headless callers present synchronously, and a stopping thread has nobody left to wait for */
+		if (!atomic_load_u32(&rt->running)) return false;
+		event_wait(&rt->wake, RENDER_IDLE_TIMEOUT_MS);
+	}
+	rt->back ^= 1;
+	return true;
+}
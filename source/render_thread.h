@@ -0,0 +1,67 @@
+#pragma once
+
+#include "render.h"
+#include "camera.h"
+#include "platform.h"
+
+/* Renders frames on a dedicated thread, alternating between two RenderBuffers so one can be presented
+	while the other is drawn. The camera is handed over through a lock-free triple buffer: the input thread
+	never waits for the renderer and the renderer always draws with the most recently published camera. */
+
+#define FRAME_NONE 0
+#define FRAME_PENDING(i) (1 + (i))
+#define FRAME_PRESENTING(i) (3 + (i))
+
+/* draws a frame into rb, returns the number of pixels written */
+typedef u64(*render_frame_func_t)(RenderBuffer *rb, const camera_t *cam, void *user);
+
+/* a finished frame and how it was made */
+typedef struct render_frame_s {
+	RenderBuffer rb;
+	u64 render_ticks;	/* time spent in render_func */
+	u64 pixels;			/* as returned by render_func */
+} render_frame_t;
+
+typedef struct render_thread_s {
+	render_frame_t frames[2];
+	u32 back;	/* frame currently owned by the renderer */
+	/* FRAME_NONE, FRAME_PENDING(i) once frames[i] is finished, FRAME_PRESENTING(i) while it's acquired */
+	volatile u32 presentable;
+
+	/* camera triple buffer: cameras[camera_write] belongs to the input thread, cameras[camera_read] to the
+		renderer, camera_middle holds the spare slot's index, or'd with CAMERA_FRESH if it hasn't been read yet */
+	camera_t cameras[3];
+	u32 camera_write, camera_read;
+	volatile u32 camera_middle;
+
+	render_frame_func_t render_func;
+	void *user;
+
+	thread_t thread;
+	event_t wake;	/* raised whenever there may be work for the renderer */
+	volatile u32 running;
+
+	/* statistics, safe to read from any thread */
+	volatile u64 frames_rendered;
+	volatile u64 render_ticks;	/* total time spent in render_func */
+} render_thread_t;
+
+/* returns 0 if successful */
+int render_thread_init(render_thread_t *rt, render_frame_func_t render_func, void *user);
+/* stops the thread if it's running and frees both buffers */
+void render_thread_free(render_thread_t *rt);
+int render_thread_start(render_thread_t *rt);
+void render_thread_stop(render_thread_t *rt);
+
+/* INPUT THREAD */
+/* publish a new camera, the next frame will be rendered with it */
+void render_thread_set_camera(render_thread_t *rt, const camera_t *cam);
+/* returns the most recently finished frame, or 0 if there is no new one. The frame belongs to the caller
+	(who may draw over it) until render_thread_release is called, which must happen before the next acquire */
+render_frame_t *render_thread_acquire(render_thread_t *rt);
+void render_thread_release(render_thread_t *rt);
+
+/* RENDER THREAD (or headless caller, when the thread isn't running) */
+/* renders one frame if a new camera has been published and the previous frame has been presented,
+	returns true if a frame was rendered */
+boolean render_thread_render_once(render_thread_t *rt);
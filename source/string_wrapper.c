@@ -3,6 +3,7 @@
 #include "assert_opt.h"
 #include "memory_opt.h"
 
+#include <stdarg.h>
 #include <string.h>
 
 boolean is_whitespace(char c) {
@@ -12,119 +13,174 @@ boolean is_newline(char c) {
 	return c == '\n' || c == '\r';
 }
 
-string string_make(const char *text) {
-	string ret = { 0 };
-	if (text) {
-		ret.length = strlen(text);
-		if (ret.length) {
-			ret.text = malloc_s(ret.length + 1);
-			assert(ret.text && "string_make: malloc failed");
-			memcpy(ret.text, text, ret.length + 1);
+/* makes str length characters long, keeping the ones it already has that still fit and moving between small and
+	heap storage as needed. Returns where the characters go, already terminated at length */
+internal char *string_resize(string *str, size_t length) {
+	const size_t old_length = string_length(str);
+	char *text;
+	if (length <= STRING_SMALL_CAPACITY) {
+		if (string_on_heap(str)) {
+			char *heap = str->heap.text;
+			memcpy(str->small.text, heap, length);
+			free_s(heap);
 		}
+		str->small.length = (u8)length;
+		text = str->small.text;
+	} else {
+		if (!string_on_heap(str)) {
+			char *heap = malloc_s(length + 1);
+			assert(heap && "string_resize: malloc failed");
+			memcpy(heap, str->small.text, old_length);
+			memset(str, 0, sizeof(string));
+			str->heap.text = heap;
+			str->heap.tag = STRING_ON_HEAP;
+		} else if (old_length != length) {
+			str->heap.text = realloc_s(str->heap.text, length + 1);
+			assert(str->heap.text && "string_resize: realloc failed");
+		}
+		str->heap.length = length;
+		text = str->heap.text;
 	}
+	text[length] = '\0';
+	return text;
+}
+
+string string_make(const char *text) {
+	string ret = { 0 };
+	if (text) string_extract(&ret, text, strlen(text));
 	return ret;
 }
 string string_make_repeated(const char *text, size_t n) {
 	string ret = { 0 };
 	if (n == 0 || text == 0 || text[0] == 0) return ret;
 	const size_t len = strlen(text);
-	ret.length = n * len;
-	ret.text = malloc_s(ret.length + 1);
-	assert(ret.text && "string_make_repeated: malloc failed");
-	for (int i = 0; i < n; ++i)
-		memcpy(&ret.text[n * len], text, len);
+	char *dest = string_resize(&ret, n * len);
+	for (size_t i = 0; i < n; ++i)
+		memcpy(&dest[i * len], text, len);
 	return ret;
 }
 void string_clear(string *str) {
 	assert(str && "string_clear: str == 0");
-	if (str->text) {
-		free_s(str->text);
-		str->text = 0;
-	}
-	str->length = 0;
+	if (string_on_heap(str)) free_s(str->heap.text);
+	memset(str, 0, sizeof(string));
 }
 void string_set(string *strDest, const string *strSrc) {
 	assert(strDest && "string_set: strDest == 0");
 	assert(strSrc && "string_set: strSrc == 0");
-	if (strSrc->text == 0 || strSrc->length == 0) {
-		if (strDest->text) {
-			free_s(strDest->text);
-			strDest->text = 0;
-		}
-		strDest->length = 0;
-		return;
-	}
-	if (strDest->text == 0)
-		strDest->text = malloc_s(strSrc->length + 1);
-	else if (strDest->length != strSrc->length) {
-		free_s(strDest->text);
-		strDest->text = malloc_s(strSrc->length + 1);
-	}
-	assert(strDest->text && "string_set: str->text == 0");
-	memcpy(strDest->text, strSrc->text, strSrc->length + 1);
-	strDest->length = strSrc->length;
+	if (strDest == strSrc) return;
+	const size_t length = string_length(strSrc);
+	if (length <= STRING_SMALL_CAPACITY) string_clear(strDest);
+	memcpy(string_resize(strDest, length), string_text(strSrc), length);
 }
 void string_set_c(string *str, const char *text) {
 	assert(str && "string_set_c: str == 0");
-	string tmp = string_make(text);
-	string_set(str, &tmp);
-	string_clear(&tmp);
+	string_extract(str, text, text ? strlen(text) : 0);
 }
 void string_append(string *strA, const string *strB) {
 	assert(strA && "string_append: strA == 0");
 	assert(strB && "string_append: strB == 0");
-	if (strB->text == 0 || strB->length == 0) return;
-	if (strA->text == 0 || strA->length == 0) {
-		string_set(strA, strB);
-		return;
-	}
-
-	char *new_text = realloc_s(strA->text, strA->length + strB->length + 1);
-	assert(new_text && "string_append: realloc failed");
-	memcpy(&new_text[strA->length], strB->text, strB->length + 1);
-	strA->text = new_text;
-	strA->length += strB->length;
+	assert(strA != strB && "string_append: strA == strB");
+	const size_t length = string_length(strA), append_length = string_length(strB);
+	if (append_length == 0) return;
+	memcpy(string_resize(strA, length + append_length) + length, string_text(strB), append_length);
 }
 void string_append_c(string *str, const char *text) {
 	assert(str && "string_append_c: str == 0");
-	string tmp = string_make(text);
-	string_append(str, &tmp);
-	string_clear(&tmp);
+	if (text == 0 || text[0] == 0) return;
+	const size_t length = string_length(str), append_length = strlen(text);
+	memcpy(string_resize(str, length + append_length) + length, text, append_length);
 }
 void string_extract(string *str, const char *text, size_t length) {
 	assert(str && "string_extract: str == 0");
 	string_clear(str);
 	if (text == 0 || length == 0) return;
-	str->text = malloc_s(length + 1);
-	assert(str->text && "string_extract: malloc failed");
-	str->length = length;
-	memcpy(str->text, text, length);
-	str->text[length] = '\0';
+	memcpy(string_resize(str, length), text, length);
 }
 string string_move(string *str) {
 	assert(str && "string_move: str == 0");
 	string ret = *str;
-	str->length = 0;
-	str->text = 0;
+	memset(str, 0, sizeof(string));
 	return ret;
 }
 boolean string_empty(const string *str) {
 	assert(str && "string_empty: str == 0");
-	return str->text == 0 || str->length == 0;
+	return string_length(str) == 0;
 }
 boolean string_equal(const string *strA, const string *strB) {
 	assert(strA && "string_equal: strA == 0");
 	assert(strB && "string_equal: strB == 0");
-	const boolean emptyA = string_empty(strA), emptyB = string_empty(strB);
-	if (emptyA || emptyB) return emptyA && emptyB;
-	if (strA->length != strB->length) return false;
-	for (int i = 0; i < strA->length; ++i)
-		if (strA->text[i] != strB->text[i]) return false;
-	return true;
+	const size_t length = string_length(strA);
+	return length == string_length(strB) && memcmp(string_text(strA), string_text(strB), length) == 0;
 }
 boolean string_equal_c(const string *strA, const char *strB) {
-	string tmp = string_make(strB);
-	boolean ret = string_equal(strA, &tmp);
-	string_clear(&tmp);
+	assert(strA && "string_equal_c: strA == 0");
+	const size_t length = strB ? strlen(strB) : 0;
+	return length == string_length(strA) && memcmp(string_text(strA), strB ? strB : "", length) == 0;
+}
+
+const char *builder_text(const string_builder_t *builder) {
+	assert(builder && "builder_text: builder == 0");
+	return builder->buf ? builder->buf : "";
+}
+size_t builder_length(const string_builder_t *builder) {
+	assert(builder && "builder_length: builder == 0");
+	return buf_len(builder->buf);
+}
+void builder_append_n(string_builder_t *builder, const char *text, size_t length) {
+	assert(builder && "builder_append_n: builder == 0");
+	assert((text || !length) && "builder_append_n: text == 0");
+	if (length == 0) return;
+	const size_t old_length = buf_len(builder->buf);
+	buf_fit(builder->buf, old_length + length + 1);
+	memcpy(builder->buf + old_length, text, length);
+	builder->buf[old_length + length] = '\0';
+	buf__hdr(builder->buf)->len += length;
+}
+void builder_append_c(string_builder_t *builder, const char *text) {
+	if (text) builder_append_n(builder, text, strlen(text));
+}
+void builder_append(string_builder_t *builder, const string *str) {
+	assert(str && "builder_append: str == 0");
+	builder_append_n(builder, string_text(str), string_length(str));
+}
+void builder_printf(string_builder_t *builder, const char *fmt, ...) {
+	assert(builder && "builder_printf: builder == 0");
+	va_list args;
+	va_start(args, fmt);
+	builder->buf = buf__vprintf(builder->buf MEMORY_SITE_ARGS, fmt, args);
+	va_end(args);
+}
+void builder_append_escaped(string_builder_t *builder, const char *text, size_t length) {
+	assert((text || !length) && "builder_append_escaped: text == 0");
+	size_t start = 0;
+	for (size_t i = 0; i < length; ++i) {
+		const u8 c = (u8)text[i];
+		if ((c < 0x20 && c != '\t') || c == 0x7F) {
+			builder_append_n(builder, text + start, i - start);
+			builder_printf(builder, "\\x%02X", c);
+			start = i + 1;
+		}
+	}
+	builder_append_n(builder, text + start, length - start);
+}
+void builder_truncate(string_builder_t *builder, size_t length) {
+	assert(builder && "builder_truncate: builder == 0");
+	assert(length <= buf_len(builder->buf) && "builder_truncate: length is past the end");
+	if (builder->buf) {
+		builder->buf[length] = '\0';
+		buf__hdr(builder->buf)->len = length;
+	}
+}
+void builder_clear(string_builder_t *builder) {
+	builder_truncate(builder, 0);
+}
+string builder_to_string(const string_builder_t *builder) {
+	assert(builder && "builder_to_string: builder == 0");
+	string ret = { 0 };
+	string_extract(&ret, builder->buf, buf_len(builder->buf));
 	return ret;
 }
+void builder_free(string_builder_t *builder) {
+	assert(builder && "builder_free: builder == 0");
+	buf_free(builder->buf);
+}
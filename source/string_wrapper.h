@@ -2,17 +2,46 @@
 
 #include "types.h"
 
+#include <stddef.h>
 #include <stdlib.h>
 
 boolean is_whitespace(char c);
 boolean is_newline(char c);
 
-typedef struct string_t {
-	char *text;
-	size_t length;
+/* Short strings (tags, culture names, flags...) are kept inside the struct instead of in their own allocation:
+	up to STRING_SMALL_CAPACITY characters fit in small.text, with their length in the last byte. Longer ones
+	are on the heap and that byte is STRING_ON_HEAP (heap.unused pads up to it, 7 bytes with 64 bit pointers). Go through string_text and string_length to read either. */
+#define STRING_SMALL_CAPACITY 22
+#define STRING_ON_HEAP 0xFF
+
+typedef union string_t {
+	struct {
+		char *text;
+		size_t length;
+		u8 unused[STRING_SMALL_CAPACITY + 1 - sizeof(char *) - sizeof(size_t)];
+		u8 tag;			/* STRING_ON_HEAP */
+	} heap;
+	struct {
+		char text[STRING_SMALL_CAPACITY + 1];
+		u8 length;
+	} small;
 } string;
 
-/* zero-initialise, otherwise text will be freed! */
+/* tag and length have to share the last byte, whatever the size of a pointer */
+_Static_assert(offsetof(string, heap.tag) == offsetof(string, small.length), "string: heap.tag and small.length don't overlap");
+
+/* zero-initialise, otherwise text will be freed! (all zeroes is the empty string) */
+
+internal inline boolean string_on_heap(const string *str) {
+	return str->small.length == STRING_ON_HEAP;
+}
+/* never 0, the empty string is "" */
+internal inline const char *string_text(const string *str) {
+	return string_on_heap(str) ? str->heap.text : str->small.text;
+}
+internal inline size_t string_length(const string *str) {
+	return string_on_heap(str) ? str->heap.length : str->small.length;
+}
 
 string string_make(const char *text);
 string string_make_repeated(const char *text, size_t n);
@@ -26,3 +55,27 @@ string string_move(string *str);
 boolean string_empty(const string *str);
 boolean string_equal(const string *strA, const string *strB);
 boolean string_equal_c(const string *strA, const char *strB);
+
+/* STRING BUILDER
+	For text put together from pieces (paths, messages): a char stretchy buffer whose capacity doubles as it
+	fills, so appending costs amortised O(1) per byte instead of a realloc to the exact length every time.
+	Always terminated. builder_clear and builder_truncate keep the capacity, so one builder can be reused as a
+	scratch buffer for many strings; builder_to_string copies the result out. Zero-initialise. */
+typedef struct string_builder_s {
+	char *buf;
+} string_builder_t;
+
+/* never 0, an empty builder's text is "" */
+const char *builder_text(const string_builder_t *builder);
+size_t builder_length(const string_builder_t *builder);
+void builder_append_n(string_builder_t *builder, const char *text, size_t length);
+void builder_append_c(string_builder_t *builder, const char *text);
+void builder_append(string_builder_t *builder, const string *str);
+void builder_printf(string_builder_t *builder, const char *fmt, ...);
+/* control characters (a NUL, a stray \r...) go in as \xNN, for putting file contents in a message */
+void builder_append_escaped(string_builder_t *builder, const char *text, size_t length);
+/* cuts the text back to its first length characters */
+void builder_truncate(string_builder_t *builder, size_t length);
+void builder_clear(string_builder_t *builder);
+string builder_to_string(const string_builder_t *builder);
+void builder_free(string_builder_t *builder);
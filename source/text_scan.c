@@ -0,0 +1,235 @@
+#include "text_scan.h"
+
+#include "parser.h"
+#include "platform.h"
+#include "assert_opt.h"
+
+#include <string.h>
+
+#ifdef PLATFORM_X86
+#include <immintrin.h>
+#endif
+
+/* bytes scan_token_end checks one at a time before handing over to the vector scanner */
+#define SCAN_SCALAR_PREFIX 8
+
+typedef size_t(*scan_func_t)(const char *text, size_t length);
+typedef size_t(*scan_string_func_t)(const char *text, size_t length, char quote);
+/* the token end mask of the 32 bytes at text */
+typedef u32(*scan_mask_func_t)(const char *text);
+
+/* SCALAR */
+internal size_t scan_token_end_scalar(const char *text, size_t length) {
+	size_t i = 0;
+	while (i < length && char_is(text[i], CHAR_TOKEN)) i++;
+	return i;
+}
+internal size_t scan_string_end_scalar(const char *text, size_t length, char quote) {
+	size_t i = 0;
+	while (i < length && text[i] != quote && !char_is(text[i], CHAR_NEWLINE) && text[i] != '\0') i++;
+	return i;
+}
+internal size_t scan_line_end_scalar(const char *text, size_t length) {
+	size_t i = 0;
+	while (i < length && !char_is(text[i], CHAR_NEWLINE) && text[i] != '\0') i++;
+	return i;
+}
+internal u32 token_end_block_scalar(const char *text) {
+	u32 mask = 0;
+	for (u32 i = 0; i < SCAN_MASK_BYTES; ++i)
+		if (!char_is(text[i], CHAR_TOKEN)) mask |= (u32)1 << i;
+	return mask;
+}
+
+#ifdef PLATFORM_X86
+#define lowest_set_bit scan_lowest_set_bit
+
+/* SSE2: one compare per delimiter, with a few folded together */
+TARGET("sse2") internal __m128i token_end_mask_sse2(__m128i v) {
+	/* \t \n \v \f \r are 9-13, i.e. (v - 9) <= 4 unsigned */
+	const __m128i control = _mm_sub_epi8(v, _mm_set1_epi8(9));
+	__m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8(4)), control);
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, _mm_set1_epi8(',')));
+	/* '{' and '}' are ';' and '=' with bit 6 set */
+	const __m128i folded = _mm_andnot_si128(_mm_set1_epi8(0x40), v);
+	hit = _mm_or_si128(hit, _mm_cmpeq_epi8(folded, _mm_set1_epi8(';')));
+	return _mm_or_si128(hit, _mm_cmpeq_epi8(folded, _mm_set1_epi8('=')));
+}
+TARGET("sse2") internal size_t scan_token_end_sse2(const char *text, size_t length) {
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const u32 mask = (u32)_mm_movemask_epi8(token_end_mask_sse2(_mm_loadu_si128((const __m128i *)(text + i))));
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_token_end_scalar(text + i, length - i);
+}
+TARGET("sse2") internal u32 token_end_block_sse2(const char *text) {
+	const u32 low = (u32)_mm_movemask_epi8(token_end_mask_sse2(_mm_loadu_si128((const __m128i *)text)));
+	const u32 high = (u32)_mm_movemask_epi8(token_end_mask_sse2(_mm_loadu_si128((const __m128i *)(text + 16))));
+	return low | high << 16;
+}
+TARGET("sse2") internal __m128i line_end_mask_sse2(__m128i v) {
+	return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_setzero_si128()),
+		_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+}
+TARGET("sse2") internal size_t scan_string_end_sse2(const char *text, size_t length, char quote) {
+	const __m128i target = _mm_set1_epi8(quote);
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(text + i));
+		const u32 mask = (u32)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, target), line_end_mask_sse2(v)));
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_string_end_scalar(text + i, length - i, quote);
+}
+TARGET("sse2") internal size_t scan_line_end_sse2(const char *text, size_t length) {
+	size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const u32 mask = (u32)_mm_movemask_epi8(line_end_mask_sse2(_mm_loadu_si128((const __m128i *)(text + i))));
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_line_end_scalar(text + i, length - i);
+}
+
+/* AVX2: the delimiters are classified by nibble lookups, a byte is one if the bits for its low and high
+	nibble overlap. Bit 0: 0x0_ bytes (\0, \t-\r), bit 1: 0x2_ bytes (' ', '"', '\'', ','), bit 2: 0x3_ and
+	0x7_ bytes (';', '=', '{', '}'). Bytes >= 0x80 have an empty high nibble entry. */
+#define TOKEN_END_LOW_NIBBLE 3, 0, 2, 0, 0, 0, 0, 2, 0, 1, 1, 5, 3, 5, 0, 0
+#define TOKEN_END_HIGH_NIBBLE 1, 0, 2, 4, 0, 0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0
+
+TARGET("avx2") internal inline u32 token_end_block_avx2(const char *text) {
+	/* vpshufb looks up within each 128-bit lane, so both lanes get the table */
+	const __m256i low_table = _mm256_setr_epi8(TOKEN_END_LOW_NIBBLE, TOKEN_END_LOW_NIBBLE);
+	const __m256i high_table = _mm256_setr_epi8(TOKEN_END_HIGH_NIBBLE, TOKEN_END_HIGH_NIBBLE);
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	const __m256i v = _mm256_loadu_si256((const __m256i *)text);
+	const __m256i low = _mm256_shuffle_epi8(low_table, _mm256_and_si256(v, nibble));
+	const __m256i high = _mm256_shuffle_epi8(high_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+	const __m256i hit = _mm256_cmpeq_epi8(_mm256_and_si256(low, high), _mm256_setzero_si256());
+	return ~(u32)_mm256_movemask_epi8(hit);
+}
+TARGET("avx2") internal size_t scan_token_end_avx2(const char *text, size_t length) {
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const u32 mask = token_end_block_avx2(text + i);
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_token_end_sse2(text + i, length - i);
+}
+TARGET("avx2") internal __m256i line_end_mask_avx2(__m256i v) {
+	return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_setzero_si256()),
+		_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+}
+TARGET("avx2") internal size_t scan_string_end_avx2(const char *text, size_t length, char quote) {
+	const __m256i target = _mm256_set1_epi8(quote);
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(text + i));
+		const u32 mask = (u32)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, target), line_end_mask_avx2(v)));
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_string_end_sse2(text + i, length - i, quote);
+}
+TARGET("avx2") internal size_t scan_line_end_avx2(const char *text, size_t length) {
+	size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		const u32 mask = (u32)_mm256_movemask_epi8(line_end_mask_avx2(_mm256_loadu_si256((const __m256i *)(text + i))));
+		if (mask) return i + lowest_set_bit(mask);
+	}
+	return i + scan_line_end_sse2(text + i, length - i);
+}
+#endif
+
+typedef enum scan_isa_e {
+	SCAN_ISA_SCALAR, SCAN_ISA_SSE2, SCAN_ISA_AVX2
+} scan_isa_t;
+
+internal const char *scan_isa_names[] = { "scalar", "sse2", "avx2" };
+
+internal scan_isa_t scan_isa = SCAN_ISA_SCALAR;
+internal scan_func_t token_end_func = 0;
+internal scan_string_func_t string_end_func = 0;
+internal scan_func_t line_end_func = 0;
+internal scan_mask_func_t token_end_block_func = 0;
+
+/* picks the best scanners for this cpu, racing calls all write the same values */
+internal void scanners_init(void) {
+	scan_isa_t isa = SCAN_ISA_SCALAR;
+	scan_func_t token_end = scan_token_end_scalar, line_end = scan_line_end_scalar;
+	scan_string_func_t string_end = scan_string_end_scalar;
+	scan_mask_func_t token_end_block = token_end_block_scalar;
+#ifdef PLATFORM_SSE2
+	isa = SCAN_ISA_SSE2;
+	token_end = scan_token_end_sse2;
+	string_end = scan_string_end_sse2;
+	line_end = scan_line_end_sse2;
+	token_end_block = token_end_block_sse2;
+#endif
+#ifdef PLATFORM_X86
+	if (platform_cpu_has_avx2()) {
+		isa = SCAN_ISA_AVX2;
+		token_end = scan_token_end_avx2;
+		string_end = scan_string_end_avx2;
+		line_end = scan_line_end_avx2;
+		token_end_block = token_end_block_avx2;
+	}
+#endif
+	string_end_func = string_end;
+	line_end_func = line_end;
+	token_end_block_func = token_end_block;
+	scan_isa = isa;
+	token_end_func = token_end;
+}
+
+size_t scan_token_end(const char *text, size_t length) {
+	assert((text || !length) && "scan_token_end: text == 0");
+	/* most tokens are short, a few table lookups are cheaper than starting on a vector */
+	size_t i = 0;
+	for (; i < length && i < SCAN_SCALAR_PREFIX; ++i)
+		if (!char_is(text[i], CHAR_TOKEN)) return i;
+	if (!token_end_func) scanners_init();
+	return i + token_end_func(text + i, length - i);
+}
+size_t scan_string_end(const char *text, size_t length, char quote) {
+	assert((text || !length) && "scan_string_end: text == 0");
+	if (!token_end_func) scanners_init();
+	return string_end_func(text, length, quote);
+}
+size_t scan_line_end(const char *text, size_t length) {
+	assert((text || !length) && "scan_line_end: text == 0");
+	if (!token_end_func) scanners_init();
+	return line_end_func(text, length);
+}
+
+#ifdef PLATFORM_X86
+TARGET("avx2") internal void token_end_masks_avx2(const char *text, size_t blocks, u32 *masks) {
+	for (size_t k = 0; k < blocks; ++k) masks[k] = token_end_block_avx2(text + k * SCAN_MASK_BYTES);
+}
+#endif
+void scan_token_end_masks(const char *text, size_t length, u32 *masks) {
+	assert((text || !length) && "scan_token_end_masks: text == 0");
+	assert((masks || !length) && "scan_token_end_masks: masks == 0");
+	if (!token_end_func) scanners_init();
+	const size_t blocks = length / SCAN_MASK_BYTES;
+#ifdef PLATFORM_X86
+	/* the block function inlined into the loop, the call per block would cost as much as the block */
+	if (scan_isa == SCAN_ISA_AVX2) token_end_masks_avx2(text, blocks, masks);
+	else
+#endif
+	for (size_t k = 0; k < blocks; ++k) masks[k] = token_end_block_func(text + k * SCAN_MASK_BYTES);
+	/* a NUL ends a token, so padding the rest of the last block with them sets its bits past length */
+	if (length % SCAN_MASK_BYTES) {
+		char tail[SCAN_MASK_BYTES] = { 0 };
+		memcpy(tail, text + blocks * SCAN_MASK_BYTES, length % SCAN_MASK_BYTES);
+		masks[blocks] = token_end_block_func(tail);
+	}
+}
+
+const char *text_scan_isa(void) {
+	if (!token_end_func) scanners_init();
+	return scan_isa_names[scan_isa];
+}
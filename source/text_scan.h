@@ -0,0 +1,52 @@
+#pragma once
+
+#include "types.h"
+#include "maths.h"
+
+#include <stddef.h>
+
+/* Searches over script text that look at 16 (SSE2) or 32 (AVX2) bytes per step, with a scalar fallback
+	picked at runtime. Each returns the index of the first matching byte in text[0, length), or length if
+	there is none. Nothing past text + length is read. */
+
+/* first byte that ends an alphanumeric/numeric token: CHAR_DELIMITER or \0 */
+size_t scan_token_end(const char *text, size_t length);
+/* the closing quote of a string, strings also end at the end of the line: first quote, \n, \r or \0 */
+size_t scan_string_end(const char *text, size_t length, char quote);
+/* first \n, \r or \0 */
+size_t scan_line_end(const char *text, size_t length);
+
+/* WHOLE BUFFER
+	Finding token ends one call at a time costs more than the search itself, script tokens being a few bytes
+	long. For tokenizing a whole file, every 32 byte block is classified up front into a mask with a bit per
+	byte, and each token end is then a bit search from where the token started. */
+#define SCAN_MASK_BYTES 32
+
+internal inline size_t scan_mask_count(size_t length) {
+	return (length + SCAN_MASK_BYTES - 1) / SCAN_MASK_BYTES;
+}
+/* bit i of masks[k] is set if text[32 * k + i] ends a token as for scan_token_end, the bits past length are set
+	too. masks has room for scan_mask_count(length) */
+void scan_token_end_masks(const char *text, size_t length, u32 *masks);
+
+internal inline u32 scan_lowest_set_bit(u32 mask) {
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (u32)index;
+#else
+	return (u32)__builtin_ctz(mask);
+#endif
+}
+/* the first token end in text[pos, length) from its masks, or length if there is none */
+internal inline size_t scan_next_token_end(const u32 *masks, size_t pos, size_t length) {
+	if (pos >= length) return length;
+	size_t block = pos / SCAN_MASK_BYTES;
+	u32 mask = masks[block] & (~(u32)0 << (pos % SCAN_MASK_BYTES));
+	/* the last block has its bits past length set, so this stops there at the latest */
+	while (!mask) mask = masks[++block];
+	return MIN(block * SCAN_MASK_BYTES + scan_lowest_set_bit(mask), length);
+}
+
+/* name of the instruction set the scanners are using, for benchmark output */
+const char *text_scan_isa(void);
@@ -0,0 +1,299 @@
+#include "token_array.h"
+
+#include "assert_opt.h"
+#include "memory_opt.h"
+#include "text_scan.h"
+
+#include <string.h>
+
+/* script tokens average under 6 bytes of text, so this rarely has to grow */
+#define TOKEN_ARRAY_BYTES_PER_TOKEN 5
+
+internal int token_array_tokenize(token_array_t *array) {
+	const int ret = script_file_open(&array->file, string_text(&array->filename));
+	if (ret) {
+		fprintf(stdout, "[token_array_load] Failed to open file: %s (error code: %d)\n", string_text(&array->filename), ret);
+		return ret;
+	}
+	const char *text = array->file.text;
+	const size_t size = array->file.size;
+	if (size > UINT32_MAX) {
+		fprintf(stdout, "[token_array_load] File too large (%zu bytes): %s\n", size, string_text(&array->filename));
+		return ERROR_RETURN;
+	}
+	buf_fit(array->tokens, size / TOKEN_ARRAY_BYTES_PER_TOKEN + 1);
+	/* the token ends of the whole file first, an eighth of its size */
+	u32 *end_masks = size ? malloc_s(scan_mask_count(size) * sizeof(u32)) : 0;
+	scan_token_end_masks(text, size, end_masks);
+	size_t pos = 0, line_number = size ? 1 : 0;
+	struct token_view_t view;
+	while (token_scan_next_masked(text, size, end_masks, &pos, &line_number, &view)) {
+		compact_token_t token = {
+			.type = (u8)view.type, .line = (u32)line_number,
+			.offset = (u32)(view.text - text), .length = (u32)view.length
+		};
+		switch (view.type) {
+		case SYMBOL: token.data.sym = view.data.sym; break;
+		case INT_TOKEN: token.data.i = view.data.i; break;
+#ifdef DECIMAL_FIXED_POINT
+		case DECIMAL_TOKEN: token.data.d = view.data.fixed; break;
+#else
+		case DECIMAL_TOKEN: token.data.d = view.data.d; break;
+#endif
+		case DATE_TOKEN: token.data.date = view.data.date; break;
+		default: break;
+		}
+		buf_push(array->tokens, token);
+	}
+	free_s(end_masks);
+	return 0;
+}
+
+int token_array_load(token_array_t *array, const char *filename) {
+	assert(array && "token_array_load: array == 0");
+	assert(filename && "token_array_load: filename == 0");
+	memset(array, 0, sizeof(token_array_t));
+	string_set_c(&array->filename, filename);
+	return token_array_tokenize(array);
+}
+
+internal void token_array_thread(void *arg) {
+	token_array_t *array = arg;
+	array->load_result = token_array_tokenize(array);
+}
+int token_array_load_async(token_array_t *array, const char *filename) {
+	assert(array && "token_array_load_async: array == 0");
+	assert(filename && "token_array_load_async: filename == 0");
+	memset(array, 0, sizeof(token_array_t));
+	string_set_c(&array->filename, filename);
+	if (thread_create(&array->thread, token_array_thread, array)) {
+		fprintf(stdout, "[token_array_load_async] Failed to start thread, loading %s here instead\n", filename);
+		array->load_result = token_array_tokenize(array);
+		return 0;
+	}
+	array->loading = true;
+	return 0;
+}
+int token_array_wait(token_array_t *array) {
+	assert(array && "token_array_wait: array == 0");
+	if (array->loading) {
+		if (thread_join(&array->thread)) {
+			fprintf(stdout, "[token_array_wait] Failed to join thread loading %s\n", string_text(&array->filename));
+			return ERROR_RETURN;
+		}
+		array->loading = false;
+	}
+	return array->load_result;
+}
+void token_array_free(token_array_t *array) {
+	assert(array && "token_array_free: array == 0");
+	assert(!array->loading && "token_array_free: still loading");
+	script_file_close(&array->file);
+	string_clear(&array->filename);
+	buf_free(array->tokens);
+	memset(array, 0, sizeof(token_array_t));
+}
+
+void compact_token_print(FILE *const stream, const token_array_t *array, const compact_token_t *token) {
+	assert(array && "compact_token_print: array == 0");
+	assert(token && "compact_token_print: token == 0");
+	const int length = (int)token->length;
+	if (token->type == ALPHANUMERIC)
+		fprintf(stream, "ALPHANUMERIC:%.*s", length, compact_token_text(array, token));
+	else if (token->type == SYMBOL)
+		fprintf(stream, "SYMBOL:%c", token->data.sym);
+	else if (token->type == STRING)
+		fprintf(stream, "STRING:%.*s", length, compact_token_text(array, token));
+	else if (token->type == INT_TOKEN)
+		fprintf(stream, "INT:%d", token->data.i);
+	else if (token->type == DECIMAL_TOKEN)
+		fprintf(stream, "DECIMAL:%f", decimal_to_double(token->data.d));
+	else if (token->type == DATE_TOKEN)
+		fprintf(stream, "DATE:%d.%d.%d", token->data.date.year, token->data.date.month, token->data.date.day);
+	else
+		fprintf(stream, "ERROR");
+}
+
+/* CURSOR */
+void token_cursor_init(token_cursor_t *cursor, const token_array_t *array) {
+	assert(cursor && "token_cursor_init: cursor == 0");
+	assert(array && "token_cursor_init: array == 0");
+	assert(!array->loading && "token_cursor_init: array is still loading");
+	cursor->array = array;
+	cursor->pos = 0;
+}
+const compact_token_t *token_cursor_next(token_cursor_t *cursor) {
+	assert(cursor && "token_cursor_next: cursor == 0");
+	if (cursor->pos >= buf_len(cursor->array->tokens)) return 0;
+	return &cursor->array->tokens[cursor->pos++];
+}
+const compact_token_t *token_cursor_peek(const token_cursor_t *cursor) {
+	assert(cursor && "token_cursor_peek: cursor == 0");
+	if (cursor->pos >= buf_len(cursor->array->tokens)) return 0;
+	return &cursor->array->tokens[cursor->pos];
+}
+size_t token_cursor_line(const token_cursor_t *cursor) {
+	assert(cursor && "token_cursor_line: cursor == 0");
+	return cursor->pos ? cursor->array->tokens[cursor->pos - 1].line : 0;
+}
+void token_cursor_skip_line(token_cursor_t *cursor) {
+	assert(cursor && "token_cursor_skip_line: cursor == 0");
+	if (!cursor->pos) return;
+	const size_t count = buf_len(cursor->array->tokens);
+	const u32 line = cursor->array->tokens[cursor->pos - 1].line;
+	while (cursor->pos < count && cursor->array->tokens[cursor->pos].line == line) cursor->pos++;
+}
+
+#define TOKEN_MASK(type) (1u << (type))
+
+/* the next token if its type is in type_mask, otherwise prints why not in the token_source_get_* format */
+internal const compact_token_t *cursor_get(token_cursor_t *cursor, u32 type_mask, const char *expected, const char *func_name, const char *purpose) {
+	const compact_token_t *token = token_cursor_next(cursor);
+	if (!token) {
+		fprintf(stdout, "[%s] Missing token (expected %s for %s) [line:%zu]\n", func_name, expected, purpose, token_cursor_line(cursor));
+		return 0;
+	}
+	if (!(TOKEN_MASK(token->type) & type_mask)) {
+		fprintf(stdout, "[%s] Invalid token (expected %s for %s): ", func_name, expected, purpose);
+		compact_token_print(stdout, cursor->array, token);
+		fprintf(stdout, " [line:%zu]\n", token_cursor_line(cursor));
+		return 0;
+	}
+	return token;
+}
+
+int token_cursor_expect_symbol(token_cursor_t *cursor, char sym, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_expect_symbol: cursor == 0");
+	assert(is_symbol(sym) && "token_cursor_expect_symbol: invalid symbol");
+	const compact_token_t *token = token_cursor_next(cursor);
+	if (!token) {
+		fprintf(stdout, "[%s] Missing token (expected '%c' for %s) [line:%zu|%s]\n", func_name, sym, purpose, token_cursor_line(cursor), string_text(&cursor->array->filename));
+		return ERROR_RETURN;
+	}
+	if (token->type != SYMBOL || token->data.sym != sym) {
+		fprintf(stdout, "[%s] Invalid token (expected '%c' for %s): ", func_name, sym, purpose);
+		compact_token_print(stdout, cursor->array, token);
+		fprintf(stdout, " [line:%zu|%s]\n", token_cursor_line(cursor), string_text(&cursor->array->filename));
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+int token_cursor_expect_alphanumeric(token_cursor_t *cursor, const char *alphanumeric, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_expect_alphanumeric: cursor == 0");
+	assert((alphanumeric && alphanumeric[0]) && "token_cursor_expect_alphanumeric: invalid alphanumeric");
+	const compact_token_t *token = token_cursor_next(cursor);
+	if (!token) {
+		fprintf(stdout, "[%s] Missing token (expected \"%s\" for %s) [line:%zu|%s]\n", func_name, alphanumeric, purpose, token_cursor_line(cursor), string_text(&cursor->array->filename));
+		return ERROR_RETURN;
+	}
+	if (token->type != ALPHANUMERIC || strlen(alphanumeric) != token->length
+		|| memcmp(compact_token_text(cursor->array, token), alphanumeric, token->length)) {
+		fprintf(stdout, "[%s] Invalid token (expected \"%s\" for %s): ", func_name, alphanumeric, purpose);
+		compact_token_print(stdout, cursor->array, token);
+		fprintf(stdout, " [line:%zu|%s]\n", token_cursor_line(cursor), string_text(&cursor->array->filename));
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+
+int token_cursor_get_int(token_cursor_t *cursor, int *i, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_int: cursor == 0");
+	assert(i && "token_cursor_get_int: i == 0");
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(INT_TOKEN), "int", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	*i = token->data.i;
+	return 0;
+}
+int token_cursor_get_decimal(token_cursor_t *cursor, decimal_t *d, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_decimal: cursor == 0");
+	assert(d && "token_cursor_get_decimal: d == 0");
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(DECIMAL_TOKEN), "decimal", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	*d = token->data.d;
+	return 0;
+}
+int token_cursor_get_decimal_or_int(token_cursor_t *cursor, decimal_t *d, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_decimal_or_int: cursor == 0");
+	assert(d && "token_cursor_get_decimal_or_int: d == 0");
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(DECIMAL_TOKEN) | TOKEN_MASK(INT_TOKEN), "decimal or int", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	*d = token->type == INT_TOKEN ? decimal_from_int(token->data.i) : token->data.d;
+	return 0;
+}
+int token_cursor_get_string(token_cursor_t *cursor, string *str, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_string: cursor == 0");
+	assert(str && "token_cursor_get_string: str == 0");
+	string_clear(str);
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(STRING), "string", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	string_extract(str, compact_token_text(cursor->array, token), token->length);
+	return 0;
+}
+int token_cursor_get_alphanumeric(token_cursor_t *cursor, string *str, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_alphanumeric: cursor == 0");
+	assert(str && "token_cursor_get_alphanumeric: str == 0");
+	string_clear(str);
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(ALPHANUMERIC), "alphanumeric", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	string_extract(str, compact_token_text(cursor->array, token), token->length);
+	return 0;
+}
+int token_cursor_get_date(token_cursor_t *cursor, date_t *date, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_date: cursor == 0");
+	assert(date && "token_cursor_get_date: date == 0");
+	*date = date_default();
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(DATE_TOKEN), "date", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	*date = token->data.date;
+	return 0;
+}
+int token_cursor_get_bool(token_cursor_t *cursor, boolean *b, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_bool: cursor == 0");
+	assert(b && "token_cursor_get_bool: b == 0");
+	const compact_token_t *token = cursor_get(cursor, TOKEN_MASK(ALPHANUMERIC), "bool", func_name, purpose);
+	if (!token) return ERROR_RETURN;
+	const char *text = compact_token_text(cursor->array, token);
+	if (token->length == 3 && !memcmp(text, "yes", 3))
+		*b = true;
+	else if (token->length == 2 && !memcmp(text, "no", 2))
+		*b = false;
+	else {
+		fprintf(stdout, "[%s] Expected bool for %s, couldn't understand: %.*s [line:%zu]\n", func_name, purpose, (int)token->length, text, token_cursor_line(cursor));
+		return ERROR_RETURN;
+	}
+	return 0;
+}
+int token_cursor_get_color(token_cursor_t *cursor, u8 *col, boolean csv, const char *func_name, const char *purpose) {
+	assert(cursor && "token_cursor_get_color: cursor == 0");
+	assert(col && "token_cursor_get_color: col == 0");
+	if (!csv && token_cursor_expect_symbol(cursor, '{', func_name, purpose)) return ERROR_RETURN;
+	for (int i = 0; i < 3; ++i) {
+		const compact_token_t *token = token_cursor_next(cursor);
+		if (token && csv && token->type == SYMBOL && token->data.sym == ';')
+			token = token_cursor_next(cursor);
+		if (!token) return ERROR_RETURN;
+		int tmp_color = 0;
+		if (token->type == INT_TOKEN) {
+			tmp_color = token->data.i;
+		} else if (token->type == DECIMAL_TOKEN) {
+			const double d = decimal_to_double(token->data.d);
+			if (0.0 <= d && d <= 1.0) tmp_color = (int)(d * 255.0);
+			else tmp_color = (int)d;
+		} else {
+			fprintf(stdout, "[%s] Invalid token (expected int for color for %s): ", func_name, purpose);
+			compact_token_print(stdout, cursor->array, token);
+			fprintf(stdout, " [line:%zu]\n", token_cursor_line(cursor));
+			return ERROR_RETURN;
+		}
+		if (tmp_color < 0) {
+			fprintf(stdout, "[%s] color[%d] for %s is negative (%d) [line:%zu]\n", func_name, i, purpose, tmp_color, token_cursor_line(cursor));
+			tmp_color = 0;
+		} else if (tmp_color > 255) {
+			fprintf(stdout, "[%s] color[%d] for %s is greater than 255 (%d) [line:%zu]\n", func_name, i, purpose, tmp_color, token_cursor_line(cursor));
+			tmp_color = 255;
+		}
+		col[i] = (u8)tmp_color;
+	}
+	if (!csv && token_cursor_expect_symbol(cursor, '}', func_name, purpose)) return ERROR_RETURN;
+	return 0;
+}
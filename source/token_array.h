@@ -0,0 +1,74 @@
+#pragma once
+
+#include "parser.h"
+
+/* Tokenizes a whole file in one pass into a flat array of compact tokens, which readers then walk with a
+	token_cursor_t. Nothing is allocated per token: alphanumerics and strings are offsets into the file,
+	which stays in memory as long as the array does. The array can be built on a worker thread while the
+	caller gets on with something else (e.g. loading the next file). */
+
+typedef struct compact_token_s {
+	u8 type;		/* enum token_type_t */
+	u32 line;
+	u32 offset, length;	/* where the token is in the file, a string's contents without the quotes */
+	union {
+		int i;
+		char sym;
+		decimal_t d;
+		date_t date;
+	} data;
+} compact_token_t;
+
+typedef struct token_array_s {
+	script_file_t file;
+	string filename;
+	compact_token_t *tokens;	/* stretchy buffer */
+	/* token_array_load_async */
+	thread_t thread;
+	boolean loading;
+	int load_result;
+} token_array_t;
+
+/* returns 0 if successful, on failure array is left empty but must still be freed */
+int token_array_load(token_array_t *array, const char *filename);
+/* starts loading on a new thread, token_array_wait must be called before the array is used or freed */
+int token_array_load_async(token_array_t *array, const char *filename);
+/* waits for token_array_load_async to finish and returns what token_array_load would have */
+int token_array_wait(token_array_t *array);
+void token_array_free(token_array_t *array);
+
+internal inline const char *compact_token_text(const token_array_t *array, const compact_token_t *token) {
+	return array->file.text + token->offset;
+}
+/* the same output as token_print */
+void compact_token_print(FILE *const stream, const token_array_t *array, const compact_token_t *token);
+
+/* CURSOR
+	Reads through a token_array_t with the same helpers (and messages) as token_source_t */
+typedef struct token_cursor_s {
+	const token_array_t *array;
+	size_t pos;	/* index of the next token */
+} token_cursor_t;
+
+void token_cursor_init(token_cursor_t *cursor, const token_array_t *array);
+/* returns 0 at the end of the array */
+const compact_token_t *token_cursor_next(token_cursor_t *cursor);
+const compact_token_t *token_cursor_peek(const token_cursor_t *cursor);
+/* the line of the last token returned by token_cursor_next */
+size_t token_cursor_line(const token_cursor_t *cursor);
+/* skips the rest of the line the last token was on */
+void token_cursor_skip_line(token_cursor_t *cursor);
+
+int token_cursor_expect_symbol(token_cursor_t *cursor, char sym, const char *func_name, const char *purpose);
+int token_cursor_expect_alphanumeric(token_cursor_t *cursor, const char *alphanumeric, const char *func_name, const char *purpose);
+
+int token_cursor_get_int(token_cursor_t *cursor, int *i, const char *func_name, const char *purpose);
+int token_cursor_get_decimal(token_cursor_t *cursor, decimal_t *d, const char *func_name, const char *purpose);
+int token_cursor_get_decimal_or_int(token_cursor_t *cursor, decimal_t *d, const char *func_name, const char *purpose);
+int token_cursor_get_string(token_cursor_t *cursor, string *str, const char *func_name, const char *purpose);
+int token_cursor_get_alphanumeric(token_cursor_t *cursor, string *str, const char *func_name, const char *purpose);
+int token_cursor_get_date(token_cursor_t *cursor, date_t *date, const char *func_name, const char *purpose);
+int token_cursor_get_bool(token_cursor_t *cursor, boolean *b, const char *func_name, const char *purpose);
+/* NOT csv = also includes the { } either side of the color values
+	YES csv = skips any semicolons inside the color */
+int token_cursor_get_color(token_cursor_t *cursor, u8 *col, boolean csv, const char *func_name, const char *purpose);
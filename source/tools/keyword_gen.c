@@ -0,0 +1,107 @@
+#include "database_keys.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Build step: writes keywords.h, a perfect hash table for every set in for_all_keyword_sets (database_keys.h).
+	For each set it looks for a seed that sends every key to its own slot of the smallest power of two table
+	it can, so a lookup never has to probe.
+	Usage: keyword_gen <output file> */
+
+#define KEYWORD_MAX_SLOTS 4096
+#define KEYWORD_SEED_TRIES 1000000
+
+typedef struct keyword_gen_set_s {
+	const char *name;
+	const char **strings;
+	u32 count;
+	boolean has_enum;
+} keyword_gen_set_t;
+
+#define template_keyword_gen_set(set, keys, has_enum) { #set, set##_strings, sizeof(set##_strings) / sizeof(set##_strings[0]), has_enum },
+internal const keyword_gen_set_t keyword_gen_sets[] = {
+	for_all_keyword_sets(template_keyword_gen_set)
+};
+#undef template_keyword_gen_set
+
+/* fills slots (size slot_count) for seed, returns false if two keys share a slot */
+internal boolean try_seed(const keyword_gen_set_t *set, u32 seed, u8 *slots, u32 slot_count) {
+	memset(slots, 0, slot_count);
+	for (u32 i = 0; i < set->count; ++i) {
+		const u32 slot = keyword_hash(set->strings[i], strlen(set->strings[i]), seed) & (slot_count - 1);
+		if (slots[slot]) return false;
+		slots[slot] = (u8)(i + 1);
+	}
+	return true;
+}
+
+/* the first seed that works for a table of slot_count, returns false if there is none within KEYWORD_SEED_TRIES */
+internal boolean find_seed(const keyword_gen_set_t *set, u8 *slots, u32 slot_count, u32 *seed) {
+	for (*seed = 0; *seed < KEYWORD_SEED_TRIES; ++*seed)
+		if (try_seed(set, *seed, slots, slot_count)) return true;
+	return false;
+}
+
+internal int write_set(FILE *fp, const keyword_gen_set_t *set) {
+	if (set->count >= 255) {
+		fprintf(stdout, "[keyword_gen] Too many keys in %s (%u), slots only hold 255\n", set->name, set->count);
+		return ERROR_RETURN;
+	}
+	for (u32 i = 0; i < set->count; ++i)
+		for (u32 j = 0; j < i; ++j)
+			if (strcmp(set->strings[i], set->strings[j]) == 0) {
+				fprintf(stdout, "[keyword_gen] Duplicate key in %s: %s\n", set->name, set->strings[i]);
+				return ERROR_RETURN;
+			}
+	local u8 slots[KEYWORD_MAX_SLOTS];
+	u32 slot_count = 1, seed = 0;
+	while (slot_count < set->count) slot_count *= 2;
+	while (!find_seed(set, slots, slot_count, &seed)) {
+		slot_count *= 2;
+		if (slot_count > KEYWORD_MAX_SLOTS) {
+			fprintf(stdout, "[keyword_gen] Could not find a perfect hash for %s\n", set->name);
+			return ERROR_RETURN;
+		}
+	}
+
+	char upper[64] = { 0 };
+	for (size_t i = 0; set->name[i] && i + 1 < sizeof(upper); ++i)
+		upper[i] = (char)toupper((unsigned char)set->name[i]);
+	fprintf(fp, "\n/* %s: %u keys in %u slots */\n", set->name, set->count, slot_count);
+	if (set->has_enum) {
+		fprintf(fp, "enum %s_key_t {\n", set->name);
+		for (u32 i = 0; i < set->count; ++i)
+			fprintf(fp, "\t%s_KEY_%s,\n", upper, set->strings[i]);
+		fprintf(fp, "\t%s_KEY_COUNT\n};\n", upper);
+	}
+	fprintf(fp, "internal const u8 %s_slots[%u] = {", set->name, slot_count);
+	for (u32 i = 0; i < slot_count; ++i)
+		fprintf(fp, "%s%u%s", i % 16 ? " " : "\n\t", slots[i], i + 1 < slot_count ? "," : "\n");
+	fprintf(fp, "};\n");
+	fprintf(fp, "internal const keyword_set_t %s_keywords = { %s_strings, %u, %uu, %uu, %s_slots };\n",
+		set->name, set->name, set->count, seed, slot_count - 1, set->name);
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc != 2) {
+		fprintf(stdout, "Usage: keyword_gen <output file>\n");
+		return EXIT_FAILURE;
+	}
+	FILE *fp = fopen(argv[1], "w");
+	if (!fp) {
+		fprintf(stdout, "[keyword_gen] Failed to open %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fprintf(fp, "#pragma once\n\n/* Generated by tools/keyword_gen.c from database_keys.h, do not edit */\n\n#include \"database_keys.h\"\n");
+	int err = 0;
+	for (size_t i = 0; i < sizeof(keyword_gen_sets) / sizeof(keyword_gen_sets[0]) && !err; ++i)
+		err = write_set(fp, &keyword_gen_sets[i]);
+	fclose(fp);
+	if (err) {
+		remove(argv[1]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "validator.h"
+
+#include "directory.h"
+#include "parser.h"
+#include "platform.h"
+#include "assert_opt.h"
+#include "memory_opt.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* extensions of the files in a mod that aren't script */
+internal const char *validate_skipped_extensions[] = {
+	"bmp", "dds", "tga", "png", "jpg", "csv", "wav", "ogg", "mp3", "xac", "xsm", "fx", "ttf", "fnt", "dll", "exe"
+};
+
+internal boolean validate_is_script(const char *name) {
+	const char *dot = strrchr(name, '.');
+	if (!dot || dot == name) return true;
+	for (size_t i = 0; i < sizeof(validate_skipped_extensions) / sizeof(validate_skipped_extensions[0]); ++i)
+		if (strcmp(dot + 1, validate_skipped_extensions[i]) == 0) return false;
+	return true;
+}
+
+internal boolean view_is_data(const struct token_view_t *view) {
+	return view->type == ALPHANUMERIC || view->type == STRING || view->type == INT_TOKEN || view->type == DECIMAL_TOKEN || view->type == DATE_TOKEN;
+}
+
+int validate_file(const char *filepath, char **messages, u64 *bytes, u64 *tokens) {
+	assert(filepath && "validate_file: filepath == 0");
+	assert(messages && "validate_file: messages == 0");
+	assert(bytes && "validate_file: bytes == 0");
+	assert(tokens && "validate_file: tokens == 0");
+	script_file_t file;
+	if (script_file_open(&file, filepath)) {
+		buf_printf(*messages, "[validate_file] Could not open %s\n", filepath);
+		return ERROR_RETURN;
+	}
+	int err = 0;
+	size_t pos = 0, line_number = 1;
+	u64 count = 0;
+	struct token_view_t view;
+	boolean can_eq = false, is_eq = false;
+	int depth = 0;
+	while (token_scan_next_strict(file.text, file.size, &pos, &line_number, &view)) {
+		count++;
+		const boolean is_sym = view.type == SYMBOL;
+		if (view.type == UNKNOWN) {
+			string_builder_t escaped = { 0 };
+			builder_append_escaped(&escaped, view.text, view.length);
+			buf_printf(*messages, "[validate_file] Unknown token: %s [line:%zu|%s]\n", builder_text(&escaped), line_number, filepath);
+			builder_free(&escaped);
+			err = ERROR_RETURN;
+			continue;
+		}
+		if (!is_eq && !can_eq && is_sym && view.data.sym == ',') continue;
+		if (can_eq) {
+			can_eq = false;
+			if (is_sym && view.data.sym == '=') {
+				is_eq = true;
+				continue;
+			}
+		}
+		if (is_eq && view_is_data(&view)) is_eq = false;
+		else if (is_sym && view.data.sym == '{') {
+			is_eq = false;
+			depth++;
+		} else if (!is_eq && is_sym && view.data.sym == '}') {
+			if (depth) depth--;
+			else {
+				buf_printf(*messages, "[validate_file] Closing bracket } with no matching opening bracket [line:%zu|%s]\n", line_number, filepath);
+				err = ERROR_RETURN;
+			}
+		} else if (!is_eq && view_is_data(&view)) can_eq = true;
+		else {
+			if (is_sym) buf_printf(*messages, "[validate_file] Invalid token: %c [line:%zu|%s]\n", view.data.sym, line_number, filepath);
+			else buf_printf(*messages, "[validate_file] Invalid token: %.*s [line:%zu|%s]\n", (int)view.length, view.text, line_number, filepath);
+			err = ERROR_RETURN;
+		}
+	}
+	if (is_eq) {
+		buf_printf(*messages, "[validate_file] Trailing = at end of file [line:%zu|%s]\n", line_number, filepath);
+		err = ERROR_RETURN;
+	}
+	if (depth) {
+		buf_printf(*messages, "[validate_file] Unclosed opening brackets { : %d [line:%zu|%s]\n", depth, line_number, filepath);
+		err = ERROR_RETURN;
+	}
+	*bytes += file.size;
+	*tokens += count;
+	script_file_close(&file);
+	return err;
+}
+
+typedef struct validate_job_s {
+	const directory_entry_t *entries;
+	char **messages;		/* one buffer per entry */
+	int *results;
+	u32 count;
+	volatile u32 next;
+	volatile u64 bytes, tokens;
+} validate_job_t;
+
+internal void validate_worker(void *arg) {
+	validate_job_t *job = (validate_job_t *)arg;
+	u64 bytes = 0, tokens = 0;
+	u32 i;
+	while ((i = atomic_add_u32(&job->next, 1)) < job->count)
+		job->results[i] = validate_file(string_text(&job->entries[i].path), &job->messages[i], &bytes, &tokens);
+	atomic_add_u64(&job->bytes, bytes);
+	atomic_add_u64(&job->tokens, tokens);
+}
+
+int validate_folder(const char *base_folder, u32 thread_count, validate_stats_t *stats) {
+	assert(base_folder && "validate_folder: base_folder == 0");
+	validate_stats_t local_stats;
+	if (!stats) stats = &local_stats;
+	memset(stats, 0, sizeof(validate_stats_t));
+
+	u64 start = platform_ticks();
+	directory_entry_t *all = 0;
+	int err = directory_list_files(base_folder, &all);
+	directory_entry_t *entries = 0;
+	for_buf(i, all) {
+		if (validate_is_script(directory_entry_name(&all[i]))) buf_push(entries, all[i]);
+		else {
+			string_clear(&all[i].path);
+			stats->skipped++;
+		}
+	}
+	buf_free(all);
+	stats->list_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+
+	validate_job_t job = { 0 };
+	job.entries = entries;
+	job.count = (u32)buf_len(entries);
+	if (job.count) {
+		job.messages = (char **)calloc_s(job.count * sizeof(char *));
+		job.results = (int *)calloc_s(job.count * sizeof(int));
+	}
+	if (thread_count == 0) thread_count = platform_cpu_count();
+	if (thread_count > job.count) thread_count = job.count ? job.count : 1;
+
+	start = platform_ticks();
+	thread_t *threads = thread_count > 1 ? (thread_t *)malloc_s((thread_count - 1) * sizeof(thread_t)) : 0;
+	u32 started = 0;
+	for (; started + 1 < thread_count; ++started)
+		if (thread_create(&threads[started], validate_worker, &job)) break;
+	validate_worker(&job);
+	for (u32 i = 0; i < started; ++i) thread_join(&threads[i]);
+	if (threads) free_s(threads);
+	stats->check_seconds = platform_ticks_to_seconds(platform_ticks() - start);
+	stats->threads = started + 1;
+
+	for (u32 i = 0; i < job.count; ++i) {
+		if (job.messages[i]) fwrite(job.messages[i], 1, buf_len(job.messages[i]), stdout);
+		buf_free(job.messages[i]);
+		if (job.results[i]) {
+			stats->failed++;
+			err = ERROR_RETURN;
+		}
+	}
+	stats->files = job.count;
+	stats->bytes = job.bytes;
+	stats->tokens = job.tokens;
+	if (job.messages) free_s(job.messages);
+	if (job.results) free_s(job.results);
+	directory_list_free(&entries);
+	return err;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "types.h"
+
+/* Syntax checks every script file in a mod: brackets balance and every = has something on both sides, the
+	same rules as lexer_check_file. The whole tree is listed first, then the files are shared out between
+	worker threads as each one finishes its last; each file's messages are kept with it and printed in path
+	order at the end, so the output doesn't depend on the thread count. */
+
+typedef struct validate_stats_s {
+	u32 files, failed, skipped;	/* skipped = not script files (images, sounds...) */
+	u32 threads;	/* checked on, at most one per file */
+	u64 bytes, tokens;
+	double list_seconds, check_seconds;
+} validate_stats_t;
+
+/* messages is a stretchy buffer the file's messages are appended to, returns 0 if the file is fine */
+int validate_file(const char *filepath, char **messages, u64 *bytes, u64 *tokens);
+/* thread_count 0 = one per processor, stats can be 0. Returns 0 if every file is fine */
+int validate_folder(const char *base_folder, u32 thread_count, validate_stats_t *stats);
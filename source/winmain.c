@@ -2,6 +2,10 @@
 
 #include "win32_tools.h"
 #include "render.h"
+#include "render_thread.h"
+#include "camera.h"
+#include "platform.h"
+#include "profiler.h"
 #include "maths.h"
 #include "assert_opt.h"
 #include "memory_opt.h"
@@ -14,38 +18,30 @@
 
 #include <wingdi.h>
 
-#include "camera.c"
-
 #define START_DIMS 1280,720
-
-#define profile_out if(0) fprintf
+#define WINDOW_TITLE "Vic2Modding"
 
 /* Engine */
 HWND main_window;
 boolean running = true;
-RenderBuffer renderbuffer = { 0 };
+render_thread_t render_thread;
 BITMAPINFO win32_bitmap_info;
 vec2 mouse_pos;
+camera_t camera = { .pos = { .x = 0, .y = 0 }, .zoom = 0.4f, .screen_dims = { .x = 0, .y = 0 } };
+profiler_t profiler;
+boolean show_profiler = false;	/* overlay and numbers in the title, toggled with F3 */
 
 /* Content */
 struct database_t database = { 0 };
 RenderBuffer map = { 0 };
 
-u32 map_mode_owner(struct province_t * prov) {
-	if (prov->owner) return prov->owner->color;
-	if (!prov->sea_start) return 0xAAAAAA;
-	return prov->color;
-}
-u32 map_mode_rgo(struct province_t *prov) {
-	if (prov->rgo) return prov->rgo->color;
-	if (!prov->sea_start) return 0xFF0000;
-	return prov->color;
-}
-u32 map_mode_state(struct province_t *prov) {
-	if (prov->state) return prov->state->provinces[0]->color;
-	if (!prov->sea_start) return 0xFF00FF;
-	return prov->color;
-}
+map_palette_t map_modes[] = { map_palette_owner, map_palette_rgo, map_palette_state };
+/* 0 if unchanged, otherwise 1 + index into map_modes. map is only touched by the render thread once
+	it's running, so the input thread posts the change here instead of applying it itself */
+volatile u32 pending_map_mode = 0;
+/* index into map_modes of the last one picked, only used by the input thread */
+u32 selected_map_mode = 0;
+
 #include "database_parsing.h"
 void init_map(void) {
 
@@ -62,9 +58,10 @@ void init_map(void) {
 	lexer_check_file(MOD_FOLDER "settings.txt", "settings.txt");*/
 
 	int err = database_load_all(&database);
+	memory_profile_report(stdout, 20);
 	if (err) return;
 
-	database_apply_mapmode(&database, &map, map_mode_owner);
+	database_apply_palette(&database, &map, map_palette_owner);
 
 	/*struct lexeme_t *root = lexeme_new();
 	lexer_process_file(MOD_FOLDER "common/ideologies.txt", root);
@@ -94,27 +91,23 @@ void tick(void) {
 	if (keys[KEY_RIGHT]) camera.pos.x += speed;
 }
 
-void render(void) {
-	RB_clear(&renderbuffer);
+/* runs on the render thread */
+u64 render(RenderBuffer *rb, const camera_t *cam, void *user) {
+	const u32 map_mode = atomic_exchange_u32(&pending_map_mode, 0);
+	if (map_mode) database_apply_palette(&database, &map, map_modes[map_mode - 1]);
+
+	RB_clear(rb);
 
 	vec2 corner = { .x = 0, .y = 0 };
 	vec2 dims = { .x = map.width, .y = map.height };
-	world_to_screen_quad(&corner, &dims);
-	RB_draw_renderbuffer_sample(&renderbuffer, corner.x, corner.y, dims.x, dims.y, &map);
-	//RB_draw_renderbuffer_sample(&renderbuffer, 0, 0, renderbuffer.width, renderbuffer.height, map);
+	world_to_screen_quad(cam, &corner, &dims);
+	return RB_draw_renderbuffer_sample(rb, corner.x, corner.y, dims.x, dims.y, &map);
+	//RB_draw_renderbuffer_sample(rb, 0, 0, rb->width, rb->height, map);
 }
 
 /* Timinig */
-double frequency_counter;
 double seconds_elapsed(u64 last_counter) {
-	LARGE_INTEGER current_counter;
-	QueryPerformanceCounter(&current_counter);
-	return (double)(current_counter.QuadPart - last_counter) / frequency_counter;
-}
-u64 get_perf_counter(void) {
-	LARGE_INTEGER current_counter;
-	QueryPerformanceCounter(&current_counter);
-	return current_counter.QuadPart;
+	return platform_ticks_to_seconds(platform_ticks() - last_counter);
 }
 
 LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -147,14 +140,9 @@ LRESULT CALLBACK window_callback(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lPar
 
 		fprintf(stdout, "Window size: %d x %d\n", width, height);
 
-		RB_resize(&renderbuffer, width, height);
-
+		/* the render thread resizes its buffers to match the next camera it receives */
 		camera.screen_dims.x = width;
 		camera.screen_dims.y = height;
-
-		/* update the bitmapinfo */
-		win32_bitmap_info.bmiHeader.biWidth = width;
-		win32_bitmap_info.bmiHeader.biHeight = height;
 	} break;
 	default:
 		return DefWindowProc(hwnd, msg, wParam, lParam);
@@ -174,6 +162,20 @@ void keyboard_input(u32 vk_code, boolean was_down, boolean is_down, boolean alt_
 	case VK_LEFT: { keys[KEY_LEFT] = is_down; } break;
 	case 'D':
 	case VK_RIGHT: { keys[KEY_RIGHT] = is_down; } break;
+	case '1':
+	case '2':
+	case '3': {
+		if (is_down && !was_down) {
+			selected_map_mode = vk_code - '1';
+			atomic_store_u32(&pending_map_mode, 1 + selected_map_mode);
+		}
+	} break;
+	case VK_F3: {
+		if (is_down && !was_down) {
+			show_profiler = !show_profiler;
+			if (!show_profiler) SetWindowText(main_window, WINDOW_TITLE);
+		}
+	} break;
 	}
 }
 void message_process(MSG message) {
@@ -195,7 +197,7 @@ void message_process(MSG message) {
 		POINT mouse_pos_new;
 		GetCursorPos(&mouse_pos_new);
 		ScreenToClient(main_window, &mouse_pos_new);
-		mouse_pos_new.y = renderbuffer.height - mouse_pos_new.y;
+		mouse_pos_new.y = camera.screen_dims.y - mouse_pos_new.y;
 
 		mouse_pos.x = mouse_pos_new.x;
 		mouse_pos.y = mouse_pos_new.y;
@@ -210,15 +212,17 @@ void message_process(MSG message) {
 	} break;
 	case WM_LBUTTONDOWN:	/* Left mouse button */
 	{
-		const vec2 world_pos = screen_to_world(mouse_pos);
-		if (world_pos.x >= 0 && world_pos.x < map.width && world_pos.y >= 0 && world_pos.y < map.height) {
-			const size_t index = world_pos.x + world_pos.y * map.width;
+		const vec2 world_pos = screen_to_world(&camera, mouse_pos);
+		/* map belongs to the render thread, so the colour comes from the province id map and the palette instead */
+		if (world_pos.x >= 0 && world_pos.x < database.map.width && world_pos.y >= 0 && world_pos.y < database.map.height) {
+			const size_t index = world_pos.x + world_pos.y * database.map.width;
 			const u32 id = database.map.province_id.pixels[index];
 			const struct province_t *prov = database_get_province(&database, id);
-			fprintf(stdout, "[CLICK] col = #%06x, ", map.pixels[index]);
+			fprintf(stdout, "[CLICK] col = #%06x, ", database_palette_colour(&database, map_modes[selected_map_mode], id));
 			if (prov) fprintf(stdout, "id = %d, owner=%s, rgo=%s, state=%s, sea_start=%s\n",
-				prov->id, prov->owner ? prov->owner->tag.text : "NONE", prov->rgo ? prov->rgo->name.text : "NONE",
-				prov->state ? prov->state->name.text : "NONE", prov->sea_start ? "yes" : "no");
+				prov->id, prov->owner.index ? database_country(&database, prov->owner)->tag.text : "NONE",
+				prov->rgo.index ? string_text(&database_trade_good(&database, prov->rgo)->name) : "NONE",
+				prov->state.index ? string_text(&database_state(&database, prov->state)->name) : "NONE", prov->sea_start ? "yes" : "no");
 			else fprintf(stdout, "NO PROVINCE\n");
 		}
 	} break;
@@ -245,7 +249,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 	/* Registering the Window Class */
 	if (init_WNDClass(&window_class, hInstance, window_callback)) return ERROR_RETURN;
 	/* Creating the Window */
-	if (create_HWND(&main_window, &window_class, hInstance, "Vic2Modding", START_DIMS)) return ERROR_RETURN;
+	if (create_HWND(&main_window, &window_class, hInstance, WINDOW_TITLE, START_DIMS)) return ERROR_RETURN;
 
 	/* Graphics setup */
 	hdc = GetDC(main_window);
@@ -256,6 +260,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 
 	init_map();
 
+	if (render_thread_init(&render_thread, render, 0) || render_thread_start(&render_thread)) return ERROR_RETURN;
+
 	/* Activate window */
 	ShowWindow(main_window, nCmdShow);
 	UpdateWindow(main_window);
@@ -263,38 +269,42 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 	/* FPS setup */
 	const int refresh_rate = GetDeviceCaps(hdc, VREFRESH);
 	double last_dt = 1.0 / (double)refresh_rate, second_counter = 0.0;
-	int frames = 0;
 	const double target_dt = last_dt;
-	{
-		LARGE_INTEGER frequency_counter_large;
-		QueryPerformanceFrequency(&frequency_counter_large);
-		frequency_counter = (double)frequency_counter_large.QuadPart;
-	}
-	u64 last_counter = get_perf_counter();
+	u64 last_counter = platform_ticks();
+	profiler_init(&profiler);
 
 	/* Message Loop */
 	MSG message = { 0 };
 	while (running) {
-
-		profile_out(stdout, "[TICK] start = %f\n", seconds_elapsed(last_counter));
+		profiler_begin_frame(&profiler);
 
 		/* Input */
 		while (PeekMessage(&message, NULL, 0, 0, PM_REMOVE))
 			message_process(message);
+		profiler_mark(&profiler, PROFILE_INPUT);
 		tick();
+		render_thread_set_camera(&render_thread, &camera);
+		profiler_mark(&profiler, PROFILE_TICK);
 
-		profile_out(stdout, "[RENDER] start = %f\n", seconds_elapsed(last_counter));
-
-		/* Render */
+		/* Present the latest finished frame, if there is one (rendering happens on render_thread) */
 		{
-			render();
-			SetStretchBltMode(hdc, HALFTONE);
-			StretchDIBits(hdc, 0, 0, win32_bitmap_info.bmiHeader.biWidth, win32_bitmap_info.bmiHeader.biHeight,
-				0, 0, renderbuffer.width, renderbuffer.height,
-				renderbuffer.pixels, &win32_bitmap_info, DIB_RGB_COLORS, SRCCOPY);
-			frames++;
+			render_frame_t *frame = render_thread_acquire(&render_thread);
+			if (frame) {
+				RenderBuffer *rb = &frame->rb;
+				profiler_add(&profiler, PROFILE_SAMPLE, frame->render_ticks);
+				profiler_add(&profiler, PROFILE_PIXELS, frame->pixels);
+				if (show_profiler) profiler_draw_overlay(&profiler, rb);
+				/* the frame may have been rendered before the last resize */
+				win32_bitmap_info.bmiHeader.biWidth = rb->width;
+				win32_bitmap_info.bmiHeader.biHeight = rb->height;
+				SetStretchBltMode(hdc, HALFTONE);
+				StretchDIBits(hdc, 0, 0, camera.screen_dims.x, camera.screen_dims.y,
+					0, 0, rb->width, rb->height,
+					rb->pixels, &win32_bitmap_info, DIB_RGB_COLORS, SRCCOPY);
+				render_thread_release(&render_thread);
+			}
 		}
-		profile_out(stdout, "[TIMING] start = %f\n", seconds_elapsed(last_counter));
+		profiler_mark(&profiler, PROFILE_PRESENT);
 
 		/* Timing */
 		{
@@ -308,15 +318,19 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
 			second_counter += last_dt;
 			if (second_counter >= 1.0) {
 				second_counter -= 1.0;
-				//fprintf(stdout, "[FPS:%d]\n", frames);
-				frames = 0;
+				if (show_profiler) {
+					char title[256];
+					const int len = snprintf(title, sizeof(title), WINDOW_TITLE " | ");
+					profiler_format(&profiler, title + len, sizeof(title) - len);
+					SetWindowText(main_window, title);
+				}
 			}
-			last_counter = get_perf_counter();
+			last_counter = platform_ticks();
 		}
 	}
 
+	render_thread_free(&render_thread);
 	deinit_map();
-	RB_free_pixels(&renderbuffer);
 
 	check_memory_leaks();
 	int i = getchar();